@@ -0,0 +1,113 @@
+// Level of detail benchmark: builds the MeshOpt_BuildLodChain() of a model,
+// as Mesh does when it is added to the scene, and measures how far each
+// level really strays from the full model (points of its triangles against
+// a MeshBVH of the original ones) next to the error the simplifier reports.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_lod [file.obj] [levels]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "tiny_obj_loader.h"
+#include "meshbvh.hpp"
+#include "meshopt.hpp"
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : "../../assets/objects/golf_ball.obj";
+    int levels = argc > 2 ? atoi(argv[2]) : 6;
+    if (levels < 1)
+        levels = 1;
+
+    std::string basepath(filename);
+    size_t slash = basepath.find_last_of("/");
+    basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath.c_str(), true)) {
+        fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Registros de Mesh::BuildTrianglesAndAddToVirtualScene(): posição vec4,
+    // normal vec4 e textura vec2 por canto, depois soldados
+    const size_t stride = 4 + 4 + 2;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (size_t s = 0; s < shapes.size(); ++s) {
+        for (size_t i = 0; i < shapes[s].mesh.indices.size(); ++i) {
+            const tinyobj::index_t& idx = shapes[s].mesh.indices[i];
+            float record[stride] = { attrib.vertices[3 * idx.vertex_index + 0], attrib.vertices[3 * idx.vertex_index + 1],
+                                     attrib.vertices[3 * idx.vertex_index + 2], 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            if (idx.normal_index >= 0)
+                for (int k = 0; k < 3; ++k)
+                    record[4 + k] = attrib.normals[3 * idx.normal_index + k];
+            if (idx.texcoord_index >= 0)
+                for (int k = 0; k < 2; ++k)
+                    record[8 + k] = attrib.texcoords[2 * idx.texcoord_index + k];
+            indices.push_back(static_cast<unsigned int>(indices.size()));
+            vertices.insert(vertices.end(), record, record + stride);
+        }
+    }
+    size_t num_vertices = MeshOpt_WeldVertices(vertices, stride, indices);
+    const size_t base_count = indices.size();
+    if (base_count == 0) {
+        fprintf(stderr, "ERROR: \"%s\" has no triangles.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<MeshOptLod> lods;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    MeshOpt_BuildLodChain(vertices, stride, indices, 0, base_count, levels, lods);
+    double build_ms = ElapsedMs(start);
+
+    // Superfície original, para medir o desvio de cada nível
+    std::vector<float> positions(3 * num_vertices);
+    for (size_t v = 0; v < num_vertices; ++v)
+        for (int k = 0; k < 3; ++k)
+            positions[3 * v + k] = vertices[v * stride + k];
+    std::vector<unsigned int> base(indices.begin(), indices.begin() + base_count);
+    MeshBVH bvh;
+    bvh.build(positions, base);
+    glm::vec3 size = bvh.getBounds().max - bvh.getBounds().min;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+
+    printf("%s: %zu triangles, %zu vertices, size %.4f\n", filename, base_count / 3, num_vertices, extent);
+    printf("  chain of %zu levels built in %.3f ms\n", lods.size(), build_ms);
+    printf("  level  triangles  fraction  error (reported)  deviation max / mean (measured)\n");
+    for (size_t l = 0; l < lods.size(); ++l) {
+        const MeshOptLod& lod = lods[l];
+        // Centro e meios das arestas de cada triângulo contra a malha original
+        double sum = 0.0;
+        float max_distance = 0.0f;
+        size_t samples = 0;
+        for (size_t i = lod.first; i < lod.first + lod.count; i += 3) {
+            glm::vec3 p[3];
+            for (int k = 0; k < 3; ++k) {
+                if (indices[i + k] >= num_vertices) {
+                    fprintf(stderr, "ERROR: Level %zu indexes vertex %u of %zu.\n", l + 1, indices[i + k], num_vertices);
+                    return EXIT_FAILURE;
+                }
+                p[k] = glm::vec3(positions[3 * indices[i + k] + 0], positions[3 * indices[i + k] + 1], positions[3 * indices[i + k] + 2]);
+            }
+            glm::vec3 points[4] = { (p[0] + p[1] + p[2]) / 3.0f, 0.5f * (p[0] + p[1]), 0.5f * (p[1] + p[2]), 0.5f * (p[2] + p[0]) };
+            for (int k = 0; k < 4; ++k) {
+                MeshContact contact;
+                if (!bvh.closestPoint(points[k], extent, &contact))
+                    continue;
+                sum += contact.distance;
+                max_distance = std::max(max_distance, contact.distance);
+                ++samples;
+            }
+        }
+        printf("  %5zu  %9zu  %7.1f%%  %16.6f  %.6f / %.6f\n", l + 1, lod.count / 3, 100.0 * lod.count / base_count,
+               lod.error, max_distance, samples ? sum / samples : 0.0);
+    }
+    return 0;
+}
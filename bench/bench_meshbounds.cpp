@@ -0,0 +1,102 @@
+// Mesh center and bounds benchmark: the per-step cost of the collision
+// shapes of a ball when Mesh::getCenter() scans the vertices (twice per
+// call, as it used to) against the values cached once per load, as
+// Mesh::updateLocalBounds() does now.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_meshbounds [file.obj] [steps]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "tiny_obj_loader.h"
+#include "bounds.hpp"
+#include "physics.hpp"
+
+// Collision shapes built per physics step in main(): SphereToPlane,
+// SphereToCylinder and SphereToCylinderBottom each ask for the center
+static const int CENTERS_PER_STEP = 3;
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : "../../assets/objects/golf_ball.obj";
+    int steps = argc > 2 ? atoi(argv[2]) : 1000;
+    if (steps < 1)
+        steps = 1;
+
+    std::string basepath(filename);
+    size_t slash = basepath.find_last_of("/");
+    basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath.c_str(), true)) {
+        fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+        return EXIT_FAILURE;
+    }
+    const std::vector<float>& vertices = attrib.vertices;
+    const float* xyz = vertices.empty() ? NULL : &vertices[0];
+    const size_t count = vertices.size() / 3;
+
+    RigidBody body;
+    body.setPosition(glm::vec4(0.1f, 2.0f, 0.8f, 1.0f));
+
+    // Uma vez por carga (ou rescale): o que Mesh::updateLocalBounds() guarda
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    AABB local_bounds = AABB_FromPoints(xyz, count);
+    BoundingSphere local_sphere = BoundingSphere_FromPoints(xyz, count, local_bounds);
+    glm::vec4 local_center = body.ComputeRigidBodyCenter(vertices);
+    double cache_ms = ElapsedMs(start);
+
+    // Antes: getCenter() = getMeshCenter() + (posição - getMeshCenter()),
+    // cada getMeshCenter() percorrendo todos os vértices
+    glm::vec4 scan_sum(0.0f);
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        for (int c = 0; c < CENTERS_PER_STEP; ++c) {
+            glm::vec4 center = body.ComputeRigidBodyCenter(vertices) +
+                               (body.getPosition() - body.ComputeRigidBodyCenter(vertices));
+            scan_sum += center;
+        }
+    }
+    double scan_ms = ElapsedMs(start);
+
+    // Agora: o centro é a posição do corpo e as caixas do mundo vêm das
+    // locais guardadas e da transformação do passo
+    glm::vec4 cached_sum(0.0f);
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(body.getPosition()));
+    float world_radius = 0.0f;
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        for (int c = 0; c < CENTERS_PER_STEP; ++c)
+            cached_sum += body.getPosition();
+        transform[3].x += 1e-6f; // Outra transformação a cada passo
+        AABB world_bounds = AABB_Transform(local_bounds, transform);
+        BoundingSphere world_sphere = BoundingSphere_Transform(local_sphere, transform);
+        world_radius += world_sphere.radius + (world_bounds.max.x - world_bounds.min.x);
+    }
+    double cached_ms = ElapsedMs(start);
+    volatile float sink = world_radius; // O laço não pode ser descartado
+    (void)sink;
+
+    // Os dois caminhos dão o mesmo centro (a soma de cada passo é igual)
+    glm::vec4 difference = glm::abs(scan_sum - cached_sum) / static_cast<float>(steps * CENTERS_PER_STEP);
+    if (difference.x > 1e-4f || difference.y > 1e-4f || difference.z > 1e-4f) {
+        fprintf(stderr, "ERROR: Centers differ by (%f, %f, %f).\n", difference.x, difference.y, difference.z);
+        return EXIT_FAILURE;
+    }
+
+    BoundingSphere box_sphere = BoundingSphere_FromAABB(local_bounds);
+    printf("%s: %zu vertices, center (%.4f, %.4f, %.4f), radius %.4f (box sphere %.4f)\n", filename, count,
+           local_center.x, local_center.y, local_center.z, local_sphere.radius, box_sphere.radius);
+    printf("  cache once        %9.3f ms\n", cache_ms);
+    printf("  %d steps, %d centers per step\n", steps, CENTERS_PER_STEP);
+    printf("  vertex scans      %9.3f ms  %9.3f us/step\n", scan_ms, 1000.0 * scan_ms / steps);
+    printf("  cached            %9.3f ms  %9.3f us/step\n", cached_ms, 1000.0 * cached_ms / steps);
+    printf("  speedup           %9.1fx\n", cached_ms > 0.0 ? scan_ms / cached_ms : 0.0);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Triangle BVH benchmark: build time and closest-point queries against
+// testing every triangle. Also checks that both find the same distance.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_meshbvh [file.obj] [queries]
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "tiny_obj_loader.h"
+#include "meshbvh.hpp"
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : "../../assets/objects/golf_ball.obj";
+    int queries = argc > 2 ? atoi(argv[2]) : 10000;
+    if (queries < 1)
+        queries = 1;
+
+    std::string basepath(filename);
+    size_t slash = basepath.find_last_of("/");
+    basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath.c_str(), true)) {
+        fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+        return EXIT_FAILURE;
+    }
+    // Same indices as Mesh::buildCollisionBVH()
+    std::vector<unsigned> indices;
+    for (size_t s = 0; s < shapes.size(); ++s)
+        for (size_t i = 0; i < shapes[s].mesh.indices.size(); ++i)
+            indices.push_back(static_cast<unsigned>(shapes[s].mesh.indices[i].vertex_index));
+
+    MeshBVH bvh;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bvh.build(attrib.vertices, indices);
+    double build_ms = ElapsedMs(start);
+    if (bvh.empty()) {
+        fprintf(stderr, "ERROR: \"%s\" has no triangles.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    // Points in the bounds of the model grown by 10%, with a search radius of
+    // 5% of its size (about what a ball over a course piece asks for)
+    const AABB& bounds = bvh.getBounds();
+    glm::vec3 size = bounds.max - bounds.min;
+    glm::vec3 low = bounds.min - 0.1f * size;
+    glm::vec3 high = bounds.max + 0.1f * size;
+    const float radius = 0.05f * glm::length(size);
+    std::vector<glm::vec3> points(queries);
+    srand(1);
+    for (int i = 0; i < queries; ++i) {
+        glm::vec3 t(rand() / (float)RAND_MAX, rand() / (float)RAND_MAX, rand() / (float)RAND_MAX);
+        points[i] = low + t * (high - low);
+    }
+
+    std::vector<float> bvh_distance(queries, -1.0f);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; ++i) {
+        MeshContact contact;
+        if (bvh.closestPoint(points[i], radius, &contact))
+            bvh_distance[i] = contact.distance;
+    }
+    double bvh_ms = ElapsedMs(start);
+
+    std::vector<float> brute_distance(queries, -1.0f);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; ++i) {
+        MeshContact contact;
+        if (bvh.closestPointBruteForce(points[i], radius, &contact))
+            brute_distance[i] = contact.distance;
+    }
+    double brute_ms = ElapsedMs(start);
+
+    int hits = 0;
+    for (int i = 0; i < queries; ++i) {
+        if (std::fabs(bvh_distance[i] - brute_distance[i]) > 1e-5f) {
+            fprintf(stderr, "ERROR: Query %d: BVH distance %f, brute force %f.\n", i, bvh_distance[i], brute_distance[i]);
+            return EXIT_FAILURE;
+        }
+        if (bvh_distance[i] >= 0.0f)
+            ++hits;
+    }
+
+    printf("%s: %zu triangles, %zu nodes\n", filename, bvh.getTriangleCount(), bvh.getNodeCount());
+    printf("  build             %9.3f ms\n", build_ms);
+    printf("  %d queries (%d within %.3f)\n", queries, hits, radius);
+    printf("  BVH               %9.3f ms  %7.3f us/query\n", bvh_ms, 1000.0 * bvh_ms / queries);
+    printf("  brute force       %9.3f ms  %7.3f us/query\n", brute_ms, 1000.0 * brute_ms / queries);
+    printf("  speedup           %9.1fx\n", brute_ms / bvh_ms);
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Load-time benchmark: tinyobj text parse vs. binary mesh cache.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_meshcache [file.obj] [iterations]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "tiny_obj_loader.h"
+#include "meshcache.hpp"
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : "../../assets/objects/golf_ball.obj";
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    if (iterations < 1)
+        iterations = 1;
+
+    std::string basepath(filename);
+    size_t slash = basepath.find_last_of("/");
+    basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+
+    // Text parse (what ObjModel does without a cache)
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    double parse_ms = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+        tinyobj::attrib_t a;
+        std::vector<tinyobj::shape_t> s;
+        std::vector<tinyobj::material_t> m;
+        std::string warn, err;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!tinyobj::LoadObj(&a, &s, &m, &warn, &err, filename, basepath.c_str(), true)) {
+            fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+            return EXIT_FAILURE;
+        }
+        parse_ms += ElapsedMs(start);
+        if (i == 0) {
+            attrib = a;
+            shapes = s;
+        }
+    }
+    parse_ms /= iterations;
+
+    if (!MeshCache_Save(filename, attrib, shapes)) {
+        fprintf(stderr, "ERROR: Cannot write \"%s\".\n", MeshCache_Path(filename).c_str());
+        return EXIT_FAILURE;
+    }
+
+    double cache_ms = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+        tinyobj::attrib_t a;
+        std::vector<tinyobj::shape_t> s;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!MeshCache_Load(filename, &a, &s)) {
+            fprintf(stderr, "ERROR: Cannot read \"%s\".\n", MeshCache_Path(filename).c_str());
+            return EXIT_FAILURE;
+        }
+        cache_ms += ElapsedMs(start);
+        if (i == 0 && (a.vertices != attrib.vertices || s.size() != shapes.size()
+                       || s[0].mesh.indices.size() != shapes[0].mesh.indices.size())) {
+            fprintf(stderr, "ERROR: Cache contents differ from the parsed model.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    cache_ms /= iterations;
+
+    size_t num_indices = 0;
+    for (size_t i = 0; i < shapes.size(); ++i)
+        num_indices += shapes[i].mesh.indices.size();
+
+    printf("%s: %zu vertices, %zu indices, %d iterations\n",
+           filename, attrib.vertices.size() / 3, num_indices, iterations);
+    printf("  tinyobj::LoadObj  %9.3f ms\n", parse_ms);
+    printf("  MeshCache_Load    %9.3f ms\n", cache_ms);
+    printf("  speedup           %9.1fx\n", parse_ms / cache_ms);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// OBJ parser benchmark: tinyobj::LoadObj() against ObjLoader_Load() with
+// JobSystems of 1, 2, 4, ... threads, on the models of the game (the text
+// parse, the mesh cache is not involved). Also checks that both give the
+// same shapes and indices, and how far apart their floats are.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_objloader [runs] [file.obj ...]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "tiny_obj_loader.h"
+#include "jobsystem.hpp"
+#include "objloader.hpp"
+
+struct Model {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+};
+
+static bool SameIndex(const tinyobj::index_t& a, const tinyobj::index_t& b) {
+    return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+}
+
+// Largest difference between two float arrays, relative to the magnitude of
+// the values; -1 if the sizes differ
+static double FloatDifference(const std::vector<float>& a, const std::vector<float>& b, size_t* different) {
+    if (a.size() != b.size())
+        return -1.0;
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] == b[i])
+            continue;
+        ++*different;
+        double scale = std::max(1.0, (double)std::max(std::fabs(a[i]), std::fabs(b[i])));
+        worst = std::max(worst, std::fabs((double)a[i] - (double)b[i]) / scale);
+    }
+    return worst;
+}
+
+// Everything but the floats must be identical
+static bool SameTopology(const Model& a, const Model& b) {
+    if (a.shapes.size() != b.shapes.size() || a.materials.size() != b.materials.size() ||
+        a.attrib.colors != b.attrib.colors)
+        return false;
+    for (size_t s = 0; s < a.shapes.size(); ++s) {
+        const tinyobj::mesh_t& ma = a.shapes[s].mesh;
+        const tinyobj::mesh_t& mb = b.shapes[s].mesh;
+        if (a.shapes[s].name != b.shapes[s].name || ma.indices.size() != mb.indices.size() ||
+            ma.num_face_vertices != mb.num_face_vertices || ma.material_ids != mb.material_ids ||
+            ma.smoothing_group_ids != mb.smoothing_group_ids)
+            return false;
+        for (size_t i = 0; i < ma.indices.size(); ++i)
+            if (!SameIndex(ma.indices[i], mb.indices[i]))
+                return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 5;
+    if (runs < 1)
+        runs = 1;
+    std::vector<std::string> filenames;
+    for (int i = 2; i < argc; ++i)
+        filenames.push_back(argv[i]);
+    if (filenames.empty()) {
+        filenames.push_back("../../assets/objects/golf_ball.obj");
+        filenames.push_back("../../assets/objects/golf_club.obj");
+        filenames.push_back("../../assets/objects/tee.obj");
+    }
+
+    std::vector<unsigned> thread_counts;
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; t < cores; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(cores);
+    std::vector<JobSystem*> job_systems;
+    for (size_t i = 0; i < thread_counts.size(); ++i)
+        job_systems.push_back(new JobSystem(thread_counts[i]));
+
+    int status = EXIT_SUCCESS;
+    for (size_t f = 0; f < filenames.size(); ++f) {
+        const char* filename = filenames[f].c_str();
+        std::string basepath(filename);
+        size_t slash = basepath.find_last_of("/");
+        basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+
+        // Melhor de "runs" leituras de cada um
+        Model reference;
+        double tinyobj_ms = 1e30;
+        for (int r = 0; r < runs; ++r) {
+            Model model;
+            std::string warn, err;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool ok = tinyobj::LoadObj(&model.attrib, &model.shapes, &model.materials, &warn, &err, filename, basepath.c_str(), true);
+            tinyobj_ms = std::min(tinyobj_ms, ElapsedMs(start));
+            if (!ok) {
+                fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+                return EXIT_FAILURE;
+            }
+            reference = model;
+        }
+        size_t triangles = 0;
+        for (size_t s = 0; s < reference.shapes.size(); ++s)
+            triangles += reference.shapes[s].mesh.num_face_vertices.size();
+        printf("%s: %zu vertices, %zu triangles, %zu shapes, best of %d runs\n", filename,
+               reference.attrib.vertices.size() / 3, triangles, reference.shapes.size(), runs);
+        printf("  tinyobj::LoadObj  %9.3f ms\n", tinyobj_ms);
+
+        for (size_t j = 0; j < job_systems.size(); ++j) {
+            Model model;
+            double best_ms = 1e30;
+            for (int r = 0; r < runs; ++r) {
+                Model run;
+                std::string warn;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                bool ok = ObjLoader_Load(filename, basepath.c_str(), &run.attrib, &run.shapes, &run.materials, &warn, job_systems[j]);
+                best_ms = std::min(best_ms, ElapsedMs(start));
+                if (!ok) {
+                    fprintf(stderr, "ERROR: ObjLoader_Load() does not handle \"%s\".\n", filename);
+                    return EXIT_FAILURE;
+                }
+                model = run;
+            }
+            if (!SameTopology(reference, model)) {
+                fprintf(stderr, "ERROR: \"%s\": shapes differ from tinyobj with %u threads.\n", filename, thread_counts[j]);
+                status = EXIT_FAILURE;
+            }
+            size_t different = 0;
+            double worst = std::max(FloatDifference(reference.attrib.vertices, model.attrib.vertices, &different),
+                                    std::max(FloatDifference(reference.attrib.normals, model.attrib.normals, &different),
+                                             FloatDifference(reference.attrib.texcoords, model.attrib.texcoords, &different)));
+            if (worst < 0.0 || worst > 1e-6) {
+                fprintf(stderr, "ERROR: \"%s\": floats differ from tinyobj by %g.\n", filename, worst);
+                status = EXIT_FAILURE;
+            }
+            printf("  ObjLoader %2u thr  %9.3f ms  %5.1fx  (%zu floats differ, by at most %.1e relative)\n",
+                   thread_counts[j], best_ms, tinyobj_ms / best_ms, different, worst);
+        }
+    }
+
+    for (size_t i = 0; i < job_systems.size(); ++i)
+        delete job_systems[i];
+    return status;
+}
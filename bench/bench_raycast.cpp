@@ -0,0 +1,146 @@
+// Scene ray cast benchmark: the course of main() plus a grid of copies of a
+// mesh, cast through SceneQuery (one thread and a JobSystem) and against
+// every object one by one. Also checks that all of them agree.
+//
+// Usage (from bin/Linux, like the game itself):
+//     ./bench_raycast [file.obj] [copies per side] [rays]
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchtimer.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "tiny_obj_loader.h"
+#include "jobsystem.hpp"
+#include "scenequery.hpp"
+#include "simulation.hpp"
+
+static float Random(float low, float high) {
+    return low + (high - low) * (rand() / (float)RAND_MAX);
+}
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : "../../assets/objects/tee.obj";
+    int side = argc > 2 ? atoi(argv[2]) : 8;
+    int count = argc > 3 ? atoi(argv[3]) : 10000;
+    if (side < 1)
+        side = 1;
+    if (count < 1)
+        count = 1;
+
+    std::string basepath(filename);
+    size_t slash = basepath.find_last_of("/");
+    basepath = (slash != std::string::npos) ? basepath.substr(0, slash + 1) : "";
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath.c_str(), true)) {
+        fprintf(stderr, "ERROR: Cannot load \"%s\": %s\n", filename, err.c_str());
+        return EXIT_FAILURE;
+    }
+    std::vector<unsigned> indices;
+    for (size_t s = 0; s < shapes.size(); ++s)
+        for (size_t i = 0; i < shapes[s].mesh.indices.size(); ++i)
+            indices.push_back(static_cast<unsigned>(shapes[s].mesh.indices[i].vertex_index));
+    MeshBVH bvh;
+    bvh.build(attrib.vertices, indices);
+    if (bvh.empty()) {
+        fprintf(stderr, "ERROR: \"%s\" has no triangles.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    // Campo de GolfSimulation e as cópias da malha, com 1 m no maior lado
+    SceneQuery scene;
+    const float d = COURSE_WALL_DISTANCE;
+    CollisionPlane planes[5] = {
+        { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f) },
+        { glm::vec4(0.0f, COURSE_WALL_Y, -d, 1.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) },
+        { glm::vec4(0.0f, COURSE_WALL_Y, d, 1.0f), glm::vec4(0.0f, 0.0f, -1.0f, 0.0f) },
+        { glm::vec4(d, COURSE_WALL_Y, 0.0f, 1.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f) },
+        { glm::vec4(-d, COURSE_WALL_Y, 0.0f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f) }
+    };
+    for (int i = 0; i < 5; ++i)
+        scene.addPlane(planes[i]);
+    CollisionBox void_zone = { glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, COURSE_VOID_ZONE_Y, 0.0f)), COURSE_VOID_ZONE_HALF_SIZE };
+    scene.addBox(void_zone);
+    CollisionCylinder hole = { COURSE_HOLE_CENTER, COURSE_HOLE_RADIUS, COURSE_HOLE_HEIGHT };
+    scene.addCylinder(hole);
+
+    glm::vec3 size = bvh.getBounds().max - bvh.getBounds().min;
+    float scale = 1.0f / std::max(size.x, std::max(size.y, size.z));
+    std::vector<CollisionMesh> meshes;
+    for (int i = 0; i < side; ++i) {
+        for (int j = 0; j < side; ++j) {
+            glm::vec3 position(-d + 2.0f * d * (i + 0.5f) / side, 0.0f, -d + 2.0f * d * (j + 0.5f) / side);
+            glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(scale));
+            CollisionMesh mesh = { &bvh, transform };
+            meshes.push_back(mesh);
+            scene.addMesh(mesh);
+        }
+    }
+
+    // Segmentos de até 20 m a partir de pontos acima do campo, como os de
+    // uma prévia de trajetória ou da câmera
+    std::vector<SceneRay> rays(count);
+    srand(1);
+    for (int i = 0; i < count; ++i) {
+        rays[i].origin = glm::vec4(Random(-d, d), Random(0.1f, 3.0f), Random(-d, d), 1.0f);
+        rays[i].direction = glm::vec4(Random(-10.0f, 10.0f), Random(-3.0f, 1.0f), Random(-10.0f, 10.0f), 0.0f);
+        rays[i].max_t = 1.0f;
+    }
+
+    std::vector<SceneHit> hits(count);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    scene.castRays(rays.data(), rays.size(), hits.data());
+    double scene_ms = ElapsedMs(start);
+
+    JobSystem jobs;
+    std::vector<SceneHit> job_hits(count);
+    start = std::chrono::steady_clock::now();
+    scene.castRays(rays.data(), rays.size(), job_hits.data(), &jobs);
+    double jobs_ms = ElapsedMs(start);
+
+    // Força bruta: cada raio contra todos os objetos, na ordem de registro
+    std::vector<float> brute_t(count, -1.0f);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        SceneRay ray = rays[i];
+        SceneHit hit;
+        bool found = false;
+        for (int p = 0; p < 5; ++p)
+            if (Raycast_Plane(ray, planes[p], &hit)) { ray.max_t = hit.t; found = true; }
+        if (Raycast_Box(ray, void_zone, &hit)) { ray.max_t = hit.t; found = true; }
+        if (Raycast_Cylinder(ray, hole, &hit)) { ray.max_t = hit.t; found = true; }
+        for (size_t m = 0; m < meshes.size(); ++m)
+            if (Raycast_Mesh(ray, meshes[m], &hit)) { ray.max_t = hit.t; found = true; }
+        if (found)
+            brute_t[i] = ray.max_t;
+    }
+    double brute_ms = ElapsedMs(start);
+
+    int num_hits = 0, mesh_hits = 0;
+    for (int i = 0; i < count; ++i) {
+        float t = hits[i].object >= 0 ? hits[i].t : -1.0f;
+        float job_t = job_hits[i].object >= 0 ? job_hits[i].t : -1.0f;
+        if (std::fabs(t - brute_t[i]) > 1e-5f || t != job_t) {
+            fprintf(stderr, "ERROR: Ray %d: SceneQuery t %f, with jobs %f, brute force %f.\n", i, t, job_t, brute_t[i]);
+            return EXIT_FAILURE;
+        }
+        if (hits[i].object >= 0)
+            ++num_hits;
+        if (hits[i].object >= 0 && hits[i].triangle >= 0)
+            ++mesh_hits;
+    }
+
+    printf("%s: %zu objects (%d meshes of %zu triangles), %d rays, %d hits (%d on meshes)\n",
+           filename, scene.size(), side * side, bvh.getTriangleCount(), count, num_hits, mesh_hits);
+    printf("  SceneQuery        %9.3f ms  %7.3f us/ray\n", scene_ms, 1000.0 * scene_ms / count);
+    printf("  %2u threads        %9.3f ms  %7.3f us/ray\n", jobs.getThreadCount(), jobs_ms, 1000.0 * jobs_ms / count);
+    printf("  every object      %9.3f ms  %7.3f us/ray\n", brute_ms, 1000.0 * brute_ms / count);
+    printf("  speedup           %9.1fx\n", brute_ms / scene_ms);
+    return 0;
+}
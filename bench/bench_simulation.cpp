@@ -0,0 +1,145 @@
+// Physics throughput benchmark: GolfSimulation without a window.
+//
+// Usage:
+//     ./bench_simulation [balls] [steps]
+// Without arguments, runs 100, 1k and 10k balls. Reports steps per second,
+// the integration cost per body-step and the collision cost (broad phase,
+// narrow phase and response) per candidate pair, on one thread and on a
+// JobSystem. Then times the same number of balls lying still on the floor,
+// with and without sleeping (RigidBody::isSleeping()).
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "benchtimer.hpp"
+#include "jobsystem.hpp"
+#include "simulation.hpp"
+
+// Balls spread over the floor, thrown in different directions so they hit
+// the walls, roll over the hole and fall into the void zone.
+static void FillSimulation(GolfSimulation& simulation, size_t balls) {
+    for (size_t i = 0; i < balls; ++i) {
+        float x = -35.0f + 70.0f * static_cast<float>(i % 100) / 100.0f;
+        float z = -35.0f + 70.0f * static_cast<float>((i / 100) % 100) / 100.0f;
+        int ball = simulation.addBall(glm::vec4(x, 0.5f, z, 1.0f));
+        float angle = 0.61803f * static_cast<float>(i) * 6.2832f;
+        simulation.shoot(ball, glm::vec4(8.0f * cosf(angle), 2.0f, 8.0f * sinf(angle), 0.0f));
+    }
+}
+
+struct Timings {
+    double integrate_ms = 0.0;
+    double collide_ms = 0.0;
+    size_t pairs = 0;
+};
+
+static Timings Run(GolfSimulation& simulation, size_t balls, int steps, JobSystem* jobs) {
+    const float dt = 1.0f / 60.0f;
+    FillSimulation(simulation, balls);
+    Timings t;
+    for (int s = 0; s < steps; ++s) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        simulation.integrate(dt, jobs);
+        t.integrate_ms += ElapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        simulation.collide(jobs);
+        t.collide_ms += ElapsedMs(start);
+        t.pairs += simulation.getPairCount();
+    }
+    return t;
+}
+
+static bool SameState(const GolfSimulation& a, const GolfSimulation& b) {
+    for (size_t i = 0; i < a.getBallCount(); ++i) {
+        glm::vec4 pa = a.getBody((int)i).getPosition(), pb = b.getBody((int)i).getPosition();
+        glm::vec4 va = a.getBody((int)i).getVelocity(), vb = b.getBody((int)i).getVelocity();
+        if (memcmp(&pa, &pb, sizeof(pa)) != 0 || memcmp(&va, &vb, sizeof(va)) != 0)
+            return false;
+    }
+    return true;
+}
+
+static size_t SleepingCount(const GolfSimulation& simulation) {
+    size_t count = 0;
+    for (size_t i = 0; i < simulation.getBallCount(); ++i)
+        if (simulation.isSleeping((int)i))
+            ++count;
+    return count;
+}
+
+static void Report(const char* label, const Timings& t, size_t balls, int steps) {
+    double total_ms = t.integrate_ms + t.collide_ms;
+    double body_steps = static_cast<double>(balls) * steps;
+    printf("  %-12s %8.1f steps/s  %7.2f ns per body-step  %7.2f ns per pair  (%.1f pairs per step)\n", label,
+           steps * 1000.0 / total_ms, t.integrate_ms * 1e6 / body_steps,
+           t.pairs ? t.collide_ms * 1e6 / t.pairs : 0.0, static_cast<double>(t.pairs) / steps);
+}
+
+static void Bench(size_t balls, int steps, JobSystem& jobs) {
+    GolfSimulation single, threaded;
+    Timings single_t = Run(single, balls, steps, NULL);
+    Timings threaded_t = Run(threaded, balls, steps, &jobs);
+
+    printf("%zu balls x %d steps\n", balls, steps);
+    Report("1 thread:", single_t, balls, steps);
+    char label[32];
+    snprintf(label, sizeof(label), "%u thread%s:", jobs.getThreadCount(), jobs.getThreadCount() == 1 ? "" : "s");
+    Report(label, threaded_t, balls, steps);
+    printf("  results %s, %zu of %zu balls asleep\n", SameState(single, threaded) ? "identical" : "DIFFER",
+           SleepingCount(single), balls);
+}
+
+// Balls at rest on the floor: they soon all fall asleep, and then a
+// step should cost next to nothing compared with integrating and colliding
+// every one of them.
+static double RestingStepMs(size_t balls, int steps, bool sleep, size_t* sleeping) {
+    const float dt = 1.0f / 60.0f;
+    GolfSimulation simulation;
+    simulation.setSleepEnabled(sleep);
+    for (size_t i = 0; i < balls; ++i) {
+        float x = -35.0f + 70.0f * static_cast<float>(i % 100) / 100.0f;
+        float z = -35.0f + 70.0f * static_cast<float>((i / 100) % 100) / 100.0f;
+        simulation.addBall(glm::vec4(x, COURSE_BALL_RADIUS, z, 1.0f));
+    }
+    // O quique no piso leva uns 3 s para cair abaixo de MIN_LIMIAR
+    for (int s = 0; s < static_cast<int>((4.0f + SLEEP_TIME) / dt); ++s)
+        simulation.step(dt);
+    *sleeping = SleepingCount(simulation);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s)
+        simulation.step(dt);
+    return ElapsedMs(start) / steps;
+}
+
+static void BenchResting(size_t balls, int steps) {
+    size_t sleeping = 0, awake_sleeping = 0;
+    double awake_ms = RestingStepMs(balls, steps, false, &awake_sleeping);
+    double sleep_ms = RestingStepMs(balls, steps, true, &sleeping);
+    printf("%zu balls at rest x %d steps\n", balls, steps);
+    printf("  never sleep: %9.4f ms per step\n", awake_ms);
+    printf("  sleeping:    %9.4f ms per step  (%zu asleep, %.1fx faster)\n", sleep_ms, sleeping,
+           sleep_ms > 0.0 ? awake_ms / sleep_ms : 0.0);
+}
+
+int main(int argc, char** argv) {
+    JobSystem jobs;
+    if (argc > 1) {
+        long balls = atol(argv[1]);
+        int steps = argc > 2 ? atoi(argv[2]) : 600;
+        if (balls < 1 || steps < 1) {
+            fprintf(stderr, "Usage: %s [balls] [steps]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        Bench(static_cast<size_t>(balls), steps, jobs);
+        BenchResting(static_cast<size_t>(balls), steps);
+        return EXIT_SUCCESS;
+    }
+    Bench(100, 600, jobs);
+    Bench(1000, 600, jobs);
+    Bench(10000, 60, jobs);
+    BenchResting(1000, 600);
+    BenchResting(10000, 60);
+    return EXIT_SUCCESS;
+}
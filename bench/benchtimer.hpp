@@ -0,0 +1,13 @@
+//Timing helper shared by the benchmarks
+#ifndef _BENCHTIMER_HPP
+#define _BENCHTIMER_HPP
+
+#include <chrono>
+
+// Milliseconds since "start", as a double
+inline double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+}
+
+#endif // _BENCHTIMER_HPP
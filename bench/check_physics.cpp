@@ -0,0 +1,310 @@
+// Headless checks of the physics: runs the simulation without a window and
+// fails (exit code 1) when it does not behave as the game expects.
+//
+// Usage:
+//     ./check_physics
+// Prints one line per check; meant to be run after building, like the
+// benchmarks (from bin/Linux), and by ctest.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "meshbvh.hpp"
+#include "physicsthread.hpp"
+#include "physicsworld.hpp"
+#include "simulation.hpp"
+#include "trajectory.hpp"
+
+static int g_Failures = 0;
+
+static void Report(const char* name, bool ok, const char* detail) {
+    printf("%-44s %s%s%s\n", name, ok ? "ok" : "FAILED", detail[0] ? "  " : "", detail);
+    if (!ok)
+        g_Failures += 1;
+}
+
+static bool SameStates(const std::vector<BodyState>& a, const std::vector<BodyState>& b) {
+    return a.size() == b.size() && (a.empty() || memcmp(&a[0], &b[0], a.size() * sizeof(BodyState)) == 0);
+}
+
+// Balls thrown up from a row, so every step changes every state
+static void FillWorld(PhysicsWorld& world) {
+    world.clear();
+    for (int i = 0; i < 32; ++i) {
+        int id = world.addBody(glm::vec4(0.1f * i, 1.0f, 0.0f, 1.0f), 0.2f);
+        world.setVelocity(id, glm::vec4(0.01f * i, 2.0f, -0.02f * i, 0.0f));
+    }
+}
+
+static void StepWorld(PhysicsWorld& world, float dt) {
+    world.addAccelerationToAll(glm::vec4(0.0f, -9.81f, 0.0f, 0.0f));
+    world.addTorque(0, glm::vec4(0.0f, 0.1f, 0.0f, 0.0f));
+    world.step(dt);
+}
+
+static void Snapshot(const PhysicsWorld& world, std::vector<BodyState>& out) {
+    out.resize(world.size());
+    for (size_t i = 0; i < world.size(); ++i) {
+        out[i].position = world.getPosition((int)i);
+        out[i].rotation = world.getRotation((int)i);
+        out[i].velocity = world.getVelocity((int)i);
+    }
+}
+
+// PhysicsThread: every state read() while the thread runs, and the last one,
+// must be the state of the sequential simulation after the same number of
+// steps, with a command from post() applied before the same step
+static void CheckPhysicsThread() {
+    const float dt = 1.0f / 240.0f;
+    const glm::vec4 shot(0.5f, 3.0f, 0.0f, 0.0f);
+    PhysicsWorld world;
+    FillWorld(world);
+
+    PhysicsThread thread;
+    unsigned long long steps = 0;     // Só a thread da física escreve
+    unsigned long long shot_step = 0; // Passos antes do comando
+    bool shot_done = false;
+    thread.start(dt,
+                 [&world, &steps](float step_dt) { StepWorld(world, step_dt); ++steps; },
+                 [&world](std::vector<BodyState>& out) { Snapshot(world, out); });
+
+    std::vector<std::vector<BodyState> > samples;
+    std::vector<unsigned long long> sample_ticks;
+    std::vector<BodyState> states;
+    for (int i = 0; i < 40; ++i) {
+        if (i == 20)
+            thread.post([&world, &steps, &shot_step, &shot_done, shot]() {
+                shot_step = steps;
+                shot_done = true;
+                world.setVelocity(3, shot);
+            });
+        sample_ticks.push_back(thread.read(states));
+        samples.push_back(states);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    thread.stop();
+    unsigned long long last_tick = thread.read(states);
+    samples.push_back(states);
+    sample_ticks.push_back(last_tick);
+
+    // A mesma simulação, passo a passo nesta thread
+    PhysicsWorld sequential;
+    FillWorld(sequential);
+    std::vector<std::vector<BodyState> > expected(1);
+    Snapshot(sequential, expected[0]);
+    for (unsigned long long s = 0; s < last_tick; ++s) {
+        if (shot_done && s == shot_step)
+            sequential.setVelocity(3, shot);
+        StepWorld(sequential, dt);
+        expected.push_back(std::vector<BodyState>());
+        Snapshot(sequential, expected.back());
+    }
+
+    bool ok = shot_done && last_tick == steps && last_tick > shot_step;
+    for (size_t i = 0; ok && i < samples.size(); ++i)
+        ok = sample_ticks[i] <= last_tick && SameStates(samples[i], expected[sample_ticks[i]]);
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%llu steps, %zu reads, shot before step %llu)", last_tick, samples.size(), shot_step + 1);
+    Report("PhysicsThread matches the sequential steps", ok, detail);
+}
+
+// Continuous tests on their own: whether the sphere touches the shape along
+// "motion", and the time of impact (fraction of "motion") when it does
+static void CheckSweep(const char* name, bool hit, float toi, bool expected_hit, float expected_toi) {
+    bool ok = hit == expected_hit && (!hit || std::fabs(toi - expected_toi) < 1e-5f);
+    char detail[96];
+    if (hit)
+        snprintf(detail, sizeof(detail), "(toi %.5f, expected %s%.5f)", toi, expected_hit ? "" : "a miss, not ", expected_toi);
+    else
+        snprintf(detail, sizeof(detail), "(miss%s)", expected_hit ? ", expected a hit" : "");
+    Report(name, ok, detail);
+}
+
+static void CheckSweeps() {
+    float toi = -1.0f;
+    bool hit;
+
+    // Raio 0.1 a 1 m do piso descendo 2 m: encosta depois de 0.9 m
+    CollisionPlane floor = { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f) };
+    CollisionSphere above = { glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), 0.1f };
+    hit = Collision_SweepSphereToPlane(above, glm::vec4(0.0f, -2.0f, 0.0f, 0.0f), floor, &toi);
+    CheckSweep("Plane sweep: time of impact", hit, toi, true, 0.45f);
+    hit = Collision_SweepSphereToPlane(above, glm::vec4(0.0f, -0.5f, 0.0f, 0.0f), floor, &toi);
+    CheckSweep("Plane sweep: short of the plane", hit, toi, false, 0.0f);
+    hit = Collision_SweepSphereToPlane(above, glm::vec4(0.0f, 2.0f, 0.0f, 0.0f), floor, &toi);
+    CheckSweep("Plane sweep: moving away", hit, toi, false, 0.0f);
+
+    // Caixa de meia aresta 1 na origem; raio 0.5 a partir de x = -3
+    CollisionBox box;
+    box.transform = glm::mat4(1.0f);
+    box.half_size = glm::vec3(1.0f);
+    CollisionSphere left = { glm::vec4(-3.0f, 0.0f, 0.0f, 1.0f), 0.5f };
+    hit = Collision_SweepSphereToBox(left, glm::vec4(4.0f, 0.0f, 0.0f, 0.0f), box, &toi);
+    CheckSweep("Box sweep: time of impact", hit, toi, true, 0.375f);
+    hit = Collision_SweepSphereToBox(left, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), box, &toi);
+    CheckSweep("Box sweep: short of the box", hit, toi, false, 0.0f);
+    hit = Collision_SweepSphereToBox(left, glm::vec4(0.0f, 4.0f, 0.0f, 0.0f), box, &toi);
+    CheckSweep("Box sweep: passing beside it", hit, toi, false, 0.0f);
+
+    // Cilindro de raio 1 no eixo Y; só a distância em XZ conta
+    CollisionCylinder cylinder;
+    cylinder.center = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
+    cylinder.radius = 1.0f;
+    cylinder.height = 2.0f;
+    hit = Collision_SweepSphereToCylinder(left, glm::vec4(4.0f, 3.0f, 0.0f, 0.0f), cylinder, &toi);
+    CheckSweep("Cylinder sweep: time of impact", hit, toi, true, 0.375f);
+    hit = Collision_SweepSphereToCylinder(left, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), cylinder, &toi);
+    CheckSweep("Cylinder sweep: short of the cylinder", hit, toi, false, 0.0f);
+    hit = Collision_SweepSphereToCylinder(left, glm::vec4(0.0f, 0.0f, 4.0f, 0.0f), cylinder, &toi);
+    CheckSweep("Cylinder sweep: passing beside it", hit, toi, false, 0.0f);
+    CollisionSphere touching = { glm::vec4(-1.2f, 5.0f, 0.0f, 1.0f), 0.5f };
+    hit = Collision_SweepSphereToCylinder(touching, glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f), cylinder, &toi);
+    CheckSweep("Cylinder sweep: already touching", hit, toi, true, 0.0f);
+}
+
+// Fast shots: at 60 Hz a ball at "speed" m/s moves up to 17 m per step, but
+// the sweep must stop it at every wall, so it never leaves the course
+static void CheckWalls(const char* name, float speed) {
+    const float dt = 1.0f / 60.0f;
+    const glm::vec4 tee(0.1f, 0.1f, 0.8f, 1.0f);
+    GolfSimulation simulation;
+    for (int i = 0; i < 16; ++i) {
+        int ball = simulation.addBall(tee);
+        float theta = 6.2831853f * static_cast<float>(i) / 16.0f;
+        glm::vec4 direction(std::sin(theta), 0.1f, std::cos(theta), 0.0f);
+        simulation.shoot(ball, glm::normalize(direction) * speed);
+    }
+
+    float farthest = 0.0f;
+    for (int s = 0; s < 300; ++s) {
+        simulation.step(dt);
+        for (size_t i = 0; i < simulation.getBallCount(); ++i) {
+            glm::vec4 p = simulation.getBody(static_cast<int>(i)).getPosition();
+            farthest = std::max(farthest, std::max(std::fabs(p.x), std::fabs(p.z)));
+        }
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(farthest |x|,|z| %.3f, walls at %.1f)", farthest, COURSE_WALL_DISTANCE);
+    Report(name, farthest <= COURSE_WALL_DISTANCE, detail);
+}
+
+// Ball on a triangle mesh: a flat square of two triangles, 10 m wide, in a
+// broad phase of its own. The mesh sweep must stop a fast ball instead of
+// letting it pass through the triangles in one step. Dropped from a little
+// height, its bounces must die out (Collision_RespondToMesh()): after 20 s
+// it stays within the contact tolerance of resting on the mesh, at
+// y = radius.
+static void CheckMesh(const char* name, float height, float speed, bool settles) {
+    const float dt = 1.0f / 60.0f;
+    const float radius = COURSE_BALL_RADIUS;
+    std::vector<float> vertices = {
+        -5.0f, 0.0f, -5.0f,   5.0f, 0.0f, -5.0f,   5.0f, 0.0f, 5.0f,   -5.0f, 0.0f, 5.0f
+    };
+    std::vector<unsigned> indices = { 0, 2, 1, 0, 3, 2 };
+    MeshBVH bvh;
+    bvh.build(vertices, indices);
+    CollisionMesh mesh = { &bvh, glm::mat4(1.0f) };
+
+    RigidBody body;
+    body.setPosition(glm::vec4(0.3f, height, -0.2f, 1.0f));
+    body.setMass(COURSE_BALL_MASS);
+    body.setVelocity(glm::vec4(0.0f, -speed, 0.0f, 0.0f));
+    BroadPhase broad_phase;
+    broad_phase.addMesh(mesh);
+    broad_phase.addBall(&body, radius);
+
+    const int steps = 1200;
+    float lowest = height;
+    float highest_at_end = 0.0f; // No último segundo
+    for (int s = 0; s < steps; ++s) {
+        body.addForce(g * body.getMass());
+        body.update(dt);
+        broad_phase.update();
+        broad_phase.dispatch();
+        float y = body.getPosition().y;
+        lowest = std::min(lowest, y);
+        if (s >= steps - 60)
+            highest_at_end = std::max(highest_at_end, y);
+    }
+    bool ok = lowest > 0.0f && (!settles || highest_at_end < radius + 0.015f);
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(lowest y %.4f, last second up to %.4f, radius %.2f)", lowest, highest_at_end, radius);
+    Report(name, ok, detail);
+}
+
+// Hole: the floor is an infinite plane, but over the hole it must not hold
+// the ball up, neither in the discrete response nor in the sweep. A ball
+// dropped on the hole stays in it; a slow roll falls in on the way across.
+static void CheckHole(const char* name, const glm::vec4& position, const glm::vec4& velocity, bool stays) {
+    const float dt = 1.0f / 60.0f;
+    GolfSimulation simulation;
+    int ball = simulation.addBall(position);
+    if (velocity != glm::vec4(0.0f))
+        simulation.shoot(ball, velocity);
+
+    int entered = -1;
+    for (int s = 0; s < 600; ++s) {
+        simulation.step(dt);
+        if (entered < 0 && simulation.isInHole(ball))
+            entered = s + 1;
+    }
+    bool ok = entered >= 0 && (!stays || simulation.isInHole(ball));
+    glm::vec4 p = simulation.getBody(ball).getPosition();
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(in after step %d, ends at %.3f, %.3f, %.3f)", entered, p.x, p.y, p.z);
+    Report(name, ok, detail);
+}
+
+// Aim preview of the same shot: TrajectoryPredictor must put the ball in the
+// hole, at the same positions as the simulation, step for step
+static void CheckPreviewHole(const char* name, const glm::vec4& position, const glm::vec4& velocity) {
+    const float dt = 1.0f / 60.0f;
+    GolfSimulation simulation;
+    int ball = simulation.addBall(position);
+    if (velocity != glm::vec4(0.0f))
+        simulation.shoot(ball, velocity);
+
+    TrajectoryPredictor predictor(COURSE_BALL_RADIUS);
+    predictor.getBroadPhase().addStatics(simulation.getBroadPhase());
+    std::vector<glm::vec4> points;
+    predictor.predict(simulation.getBody(ball), dt, TRAJECTORY_PREVIEW_STEPS, points);
+
+    int entered = -1;
+    bool same = true;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i > 0)
+            simulation.step(dt);
+        glm::vec4 p = simulation.getBody(ball).getPosition();
+        same = same && memcmp(&p, &points[i], sizeof(p)) == 0;
+        if (entered < 0 && simulation.isInHole(ball))
+            entered = static_cast<int>(i);
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%zu points, in at point %d%s)", points.size(), entered, same ? "" : ", differs");
+    Report(name, same && entered >= 0, detail);
+}
+
+int main() {
+    CheckPhysicsThread();
+    CheckSweeps();
+    CheckWalls("Shots at 50 m/s stay inside the walls", 50.0f);
+    CheckWalls("Shots at 200 m/s stay inside the walls", 200.0f);
+    CheckWalls("Shots at 1000 m/s stay inside the walls", 1000.0f);
+    CheckMesh("Ball dropped on a mesh rests on it", 0.5f, 0.0f, true);
+    CheckMesh("Ball thrown down at 60 m/s stays on a mesh", 1.0f, 60.0f, false);
+    CheckHole("Ball dropped over the hole stays in it", glm::vec4(10.0f, 0.5f, 0.0f, 1.0f), glm::vec4(0.0f), true);
+    CheckHole("Ball rolled at 0.5 m/s falls in the hole", glm::vec4(9.0f, 0.02f, 0.0f, 1.0f), glm::vec4(0.5f, 0.0f, 0.0f, 0.0f), false);
+    CheckHole("Ball rolled at 1 m/s falls in the hole", glm::vec4(9.0f, 0.02f, 0.0f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), false);
+    CheckPreviewHole("Preview of the drop enters the hole", glm::vec4(10.0f, 0.5f, 0.0f, 1.0f), glm::vec4(0.0f));
+    CheckPreviewHole("Preview of the 1 m/s roll enters the hole", glm::vec4(9.0f, 0.02f, 0.0f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+    if (g_Failures > 0) {
+        printf("%d check(s) failed\n", g_Failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+// Headless driver: simulates shots on the course of main() without a window.
+//
+// Usage:
+//     ./headless [shots] [seconds]
+// Hits "shots" balls from the tee of main(), fanned out in direction and
+// strength, simulates them at 60 Hz and prints where each one stopped.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "jobsystem.hpp"
+#include "simulation.hpp"
+
+int main(int argc, char** argv) {
+    int shots = argc > 1 ? atoi(argv[1]) : 16;
+    float seconds = argc > 2 ? static_cast<float>(atof(argv[2])) : 10.0f;
+    if (shots < 1 || seconds <= 0.0f) {
+        fprintf(stderr, "Usage: %s [shots] [seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const float dt = 1.0f / 60.0f;
+    const glm::vec4 tee(0.1f, 0.1f, 0.8f, 1.0f);
+    GolfSimulation simulation;
+    JobSystem jobs;
+
+    // Ângulos como g_CameraTheta/g_CameraPhi de main(), força em passos de 10
+    for (int i = 0; i < shots; ++i) {
+        int ball = simulation.addBall(tee);
+        float theta = 1.5f + 0.2f * static_cast<float>(i % 8) / 8.0f;
+        float phi = 0.1f + 0.05f * static_cast<float>((i / 8) % 4);
+        float strength = 10.0f * static_cast<float>(1 + i % 3);
+        glm::vec4 direction(cosf(phi) * sinf(theta), sinf(phi), cosf(phi) * cosf(theta), 0.0f);
+        simulation.shoot(ball, direction * strength);
+    }
+
+    const int steps = static_cast<int>(seconds / dt + 0.5f);
+    for (int s = 0; s < steps; ++s)
+        simulation.step(dt, &jobs);
+
+    int in_hole = 0;
+    for (int i = 0; i < shots; ++i) {
+        glm::vec4 p = simulation.getBody(i).getPosition();
+        bool hole = simulation.isInHole(i);
+        in_hole += hole ? 1 : 0;
+        printf("shot %3d: (%8.3f, %8.3f, %8.3f)%s\n", i, p.x, p.y, p.z, hole ? "  in the hole" : "");
+    }
+    printf("%d of %d shots in the hole after %d steps (%.1f s)\n", in_hole, shots, steps, steps * dt);
+    return EXIT_SUCCESS;
+}
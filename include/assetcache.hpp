@@ -0,0 +1,119 @@
+//Shared meshes and textures
+#ifndef _ASSETCACHE_HPP
+#define _ASSETCACHE_HPP
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include "glad/glad.h"
+#include "glm/vec3.hpp"
+
+struct ObjModel;
+class AssetLoader;
+
+// Rows of an image sent to the GPU by one upload of AssetLoader
+#define ASSETCACHE_TEXTURE_STRIPE_BYTES (1024 * 1024)
+
+// A texture on the GPU, deleted when its last TextureHandle goes away. While
+// an AssetLoader loads it, "texture_id" is a 1x1 grey placeholder; the image
+// replaces it (with another GL name) when its last stripe is uploaded.
+struct TextureAsset {
+    GLuint texture_id = 0;
+    int width = 0;
+    int height = 0;
+    bool loaded = false;
+    TextureAsset() = default;
+    ~TextureAsset();
+private:
+    TextureAsset(const TextureAsset&);
+    TextureAsset& operator=(const TextureAsset&);
+};
+
+// A sampler object with the wrap mode of its key and trilinear filtering
+struct SamplerAsset {
+    GLuint sampler_id = 0;
+    GLenum wrap = GL_CLAMP_TO_EDGE;
+    SamplerAsset() = default;
+    ~SamplerAsset();
+private:
+    SamplerAsset(const SamplerAsset&);
+    SamplerAsset& operator=(const SamplerAsset&);
+};
+
+// Reference-counted handles: the asset lives while any handle to it does
+typedef std::shared_ptr<const ObjModel> ModelHandle;
+typedef std::shared_ptr<const TextureAsset> TextureHandle;
+typedef std::shared_ptr<const SamplerAsset> SamplerHandle;
+
+struct AssetCacheStats {
+    unsigned int model_loads = 0;   // Models read from a file (or the mesh cache)
+    unsigned int model_prefetches = 0; // Of those, read by an AssetLoader job
+    unsigned int model_imports = 0; // Scaled copies made from a loaded model
+    unsigned int model_hits = 0;
+    unsigned int texture_loads = 0; // Images decoded and uploaded
+    unsigned int texture_hits = 0;
+    unsigned int sampler_creates = 0;
+    unsigned int sampler_hits = 0;
+};
+
+// Hands out the meshes and textures of the game, one copy per key, so every
+// Mesh that asks for an asset already loaded shares it instead of reading,
+// decoding and uploading it again:
+//
+//   - models are keyed by path and scale. A model is imported once per key:
+//     the file at scale 1 (ObjModel, through the mesh cache) and, from it, a
+//     copy with its vertices scaled, both with smooth vertex normals
+//     computed as Mesh used to do on each of its own copies (a uniform scale
+//     does not turn the faces, so its copy keeps the normals). A scaled model
+//     keeps its model at scale 1 alive, so other scales of the same file are
+//     copies, not loads. Mesh::rescale() asks for the model at its new scale
+//     instead of editing the vertices, so shared models are never written;
+//   - textures are keyed by path: one decode, one GL texture;
+//   - samplers are keyed by wrap mode, so meshes that tile a shared texture
+//     and meshes that clamp it each get the right one.
+//
+// The cache itself only keeps weak references: an asset is freed (and its
+// GL objects deleted) when the last Mesh holding a handle releases it, and
+// the next request loads it again. The cache is used from the thread of the
+// GL context only; the work it gives to an AssetLoader runs on the workers.
+class AssetCache {
+public:
+    // Waits for the model if prefetchModel() is still importing it
+    ModelHandle acquireModel(const std::string& path, const glm::vec3& scale = glm::vec3(1.0f));
+    // Starts importing the model at scale 1 (parse and normals) on a worker
+    // of "loader", so the Mesh constructors that ask for it later, and the
+    // other files of the scene, do not wait for each other
+    void prefetchModel(const std::string& path, AssetLoader& loader);
+
+    // With a "loader", returns at once a texture showing a placeholder; the
+    // image is decoded and its mipmaps built on a worker, then uploaded in
+    // stripes of ASSETCACHE_TEXTURE_STRIPE_BYTES by processUploads(). An
+    // image that cannot be read is reported by processUploads() and the
+    // texture keeps the placeholder (loaded stays false); without a loader
+    // the program exits, as it always did
+    TextureHandle acquireTexture(const std::string& path, AssetLoader* loader = NULL);
+    SamplerHandle acquireSampler(GLenum wrap);
+
+    // Forgets the keys whose assets were freed; returns how many
+    size_t prune();
+
+    inline const AssetCacheStats& getStats() const { return stats; }
+
+private:
+    struct ModelKey {
+        std::string path;
+        glm::vec3 scale;
+        bool operator<(const ModelKey& other) const;
+    };
+    std::map<ModelKey, std::weak_ptr<const ObjModel> > models;
+    std::map<std::string, std::shared_future<ModelHandle> > prefetched_models; // Until acquired
+    std::map<std::string, std::weak_ptr<const TextureAsset> > textures;
+    std::map<GLenum, std::weak_ptr<const SamplerAsset> > samplers;
+    AssetCacheStats stats;
+};
+
+// The cache used by Mesh (loadModel(), rescale(), LoadTextureImage())
+extern AssetCache g_AssetCache;
+
+#endif // _ASSETCACHE_HPP
@@ -0,0 +1,94 @@
+//Background loading of assets
+#ifndef _ASSETLOADER_HPP
+#define _ASSETLOADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Uploads waiting for the GL thread at most; a job that queues one more
+// waits for processUploads() to make room, so decoded data that the GPU has
+// not taken yet never piles up in memory
+#define ASSETLOADER_UPLOAD_CAPACITY 16
+
+// Time per frame spent running uploads by default, in milliseconds
+#define ASSETLOADER_UPLOAD_BUDGET_MS 2.0
+
+struct AssetLoaderStats {
+    unsigned int jobs = 0;          // Jobs finished by the workers
+    unsigned int uploads = 0;       // Uploads run by processUploads()/finish()
+    unsigned int full_waits = 0;    // Times a job waited for room in the upload queue
+    double upload_ms = 0.0;         // Time spent running uploads
+    double max_frame_upload_ms = 0.0; // Longest processUploads() call
+};
+
+// Loads assets in two halves, so the window can show a frame while they
+// load instead of waiting for all of them:
+//
+//   - jobs (submit()) run on worker threads: reading and parsing files,
+//     decoding images, computing normals, building vertex and index arrays.
+//     They must not call OpenGL, whose context belongs to one thread;
+//   - uploads (queueUpload(), from a job) are the GL calls that hand the
+//     result to the GPU (glBufferData, glTexImage2D). They wait in a bounded
+//     queue for the thread of the context, which runs them in
+//     processUploads() once per frame, within a time budget, so a big asset
+//     costs a few frames a little time each instead of one long stall.
+//
+// Meanwhile the assets are drawn with placeholders (see
+// Mesh::addToVirtualScene() and AssetCache::acquireTexture()). Jobs start in
+// the order they were submitted and must not throw.
+//
+// Created and destroyed on the thread of the GL context. The destructor
+// drops the jobs that have not started and the uploads that have not run.
+class AssetLoader {
+public:
+    // "threads" workers; 0 uses one per hardware core but the calling one
+    explicit AssetLoader(unsigned threads = 0, size_t upload_capacity = ASSETLOADER_UPLOAD_CAPACITY);
+    ~AssetLoader();
+
+    void submit(const std::function<void()>& job);
+
+    // For jobs: queues "upload" for the GL thread, waiting while the queue is
+    // full. Called on the GL thread itself, it runs "upload" at once.
+    void queueUpload(const std::function<void()>& upload);
+
+    // Runs queued uploads until "budget_ms" has passed (at least one, if
+    // any is queued). Returns how many ran.
+    size_t processUploads(double budget_ms = ASSETLOADER_UPLOAD_BUDGET_MS);
+
+    // Waits for every job, running their uploads as they arrive
+    void finish();
+
+    // Jobs not finished plus uploads not run; 0 once everything is loaded
+    size_t getPending() const;
+    inline bool isIdle() const { return getPending() == 0; }
+
+    // Copy, since the workers update them
+    AssetLoaderStats getStats() const;
+
+private:
+    AssetLoader(const AssetLoader&);
+    AssetLoader& operator=(const AssetLoader&);
+
+    void workerLoop();
+    void runUpload(std::function<void()>& upload);
+
+    std::thread::id gl_thread;
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable job_ready;    // Workers: a job was submitted or quit
+    std::condition_variable upload_room;  // Jobs: an upload left the queue or quit
+    std::condition_variable upload_ready; // finish(): an upload arrived or a job ended
+    std::deque<std::function<void()> > jobs;
+    std::deque<std::function<void()> > uploads;
+    size_t upload_capacity;
+    size_t running_jobs = 0;
+    bool quit = false;
+    AssetLoaderStats stats;
+};
+
+#endif // _ASSETLOADER_HPP
@@ -0,0 +1,60 @@
+//Bounding volumes and view frustum tests
+#ifndef _BOUNDS_HPP
+#define _BOUNDS_HPP
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include <vector>
+
+// Axis-aligned bounding box. An empty box has min > max.
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct BoundingSphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// Box that contains nothing; AABB_Extend() grows it
+AABB AABB_Empty();
+bool AABB_IsEmpty(const AABB& box);
+void AABB_Extend(AABB& box, const glm::vec3& point);
+void AABB_Extend(AABB& box, const AABB& other);
+// Box of "count" xyz triples (e.g. tinyobj::attrib_t::vertices)
+AABB AABB_FromPoints(const float* xyz, size_t count);
+// Box containing the transformed box (Arvo's method: exact for the eight
+// corners, without transforming them one by one).
+AABB AABB_Transform(const AABB& box, const glm::mat4& M);
+// Ray origin + t * direction against the box (slab test), given 1 / direction.
+// True if it enters the box for some t in [0, max_t]; "t_enter" is the
+// first such t (0 when the origin is inside).
+bool AABB_IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_t, float* t_enter);
+
+// Sphere around the box. Not the tightest sphere, but cheap and stable.
+BoundingSphere BoundingSphere_FromAABB(const AABB& box);
+// Sphere centered on "box" (the AABB_FromPoints() of the same points)
+// through the farthest of them: as stable, and much tighter for round
+// models (r instead of r * sqrt(3) for a ball).
+BoundingSphere BoundingSphere_FromPoints(const float* xyz, size_t count, const AABB& box);
+// Sphere containing the transformed sphere (radius scaled by the largest
+// axis scale of M).
+BoundingSphere BoundingSphere_Transform(const BoundingSphere& sphere, const glm::mat4& M);
+
+// The six planes of a view frustum, pointing inwards: a point p is inside
+// when dot(plane, vec4(p, 1)) >= 0 for all of them.
+struct Frustum {
+    enum { Left, Right, Bottom, Top, Near, Far };
+    glm::vec4 planes[6];
+};
+
+// Extracts the planes of the clip matrix projection * view (Gribb-Hartmann).
+// Works for both projections of Camera::getProjection().
+Frustum Frustum_FromMatrix(const glm::mat4& view_projection);
+// Conservative tests: false means certainly outside, true means maybe visible.
+bool Frustum_Intersects(const Frustum& frustum, const BoundingSphere& sphere);
+bool Frustum_Intersects(const Frustum& frustum, const AABB& box);
+
+#endif // _BOUNDS_HPP
@@ -6,6 +6,8 @@
 //Camera related definitions
 #include "matrices.hpp"
 #include "utils.h"
+#include "uniformbuffers.hpp"
+#include "bounds.hpp"
 extern float g_CameraTheta; // Ângulo no plano ZX em relação ao eixo Z
 extern float g_CameraPhi;   // Ângulo em relação ao eixo Y
 extern float camera_distance; // Distância da câmera para a origem
@@ -35,10 +37,18 @@ public:
         return glm::vec4(pitch, yaw, roll, 1.0f);
     }
     inline glm::mat4 getView() { return Matrix_Camera_View(position, view_vector, up_vector); }
-    inline void sendToGPU(GLuint view_program_id, GLuint projection_program_id) {
-        glUniformMatrix4fv(view_program_id, 1, GL_FALSE, glm::value_ptr(getView()));
-        glUniformMatrix4fv(projection_program_id, 1, GL_FALSE, glm::value_ptr(getProjection()));
+    // Writes view, projection, view*projection and the camera position to the
+    // per-frame uniform buffer and uploads it.
+    inline void sendToGPU(FrameUniformBuffer& frame_uniforms) {
+        frame_uniforms.setCamera(getView(), getProjection(), position);
+        frame_uniforms.upload();
     }
+    // Planes of the view volume in world space, for frustum culling
+    inline Frustum getFrustum() { return Frustum_FromMatrix(getProjection() * getView()); }
+    // How many pixels of a viewport "viewport_height" pixels tall one world
+    // unit covers at "point", for level of detail selection. Works for both
+    // projections; very large for points at or behind the camera.
+    float getPixelsPerUnit(const glm::vec4& point, float viewport_height);
     inline void setPosition(glm::vec4 pos) { position = pos; }
     inline glm::vec4 getPosition() { return position; }
     inline glm::vec4 getViewVector()    { return view_vector; }
@@ -85,4 +95,4 @@ public:
 };
 
 
-#endif // _CAMERA_H
\ No newline at end of file
+#endif // _CAMERA_H
@@ -1,19 +1,208 @@
 //Collisions tests
 #pragma once
+#include "bounds.hpp"
+#include "meshbvh.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include <cstddef>
+#include <vector>
 // Forward declarations
-class Ball;
-class Cube;
-class Plane;
-class Cylinder;
+class RigidBody;
+class JobSystem;
 
-class collisor {
+// This header and collisions.cpp do not depend on OpenGL or on the Mesh
+// classes: the shapes below are plain copies of the values the tests read,
+// so the physics can run in headless tools. geometrics.hpp builds them from
+// the meshes (Ball::getCollisionSphere(), Plane::getCollisionPlane(), ...).
+
+struct CollisionSphere {
+    glm::vec4 center; // w = 1
+    float radius;
+};
+
+// Infinite plane through "point"
+struct CollisionPlane {
+    glm::vec4 point;  // w = 1
+    glm::vec4 normal; // w = 0
+};
+
+// Box of half-dimensions "half_size" in the local space of "transform"
+struct CollisionBox {
+    glm::mat4 transform;
+    glm::vec3 half_size;
+};
+
+// Cylinder along Y, centered at "center"
+struct CollisionCylinder {
+    glm::vec4 center; // w = 1
+    float radius;
+    float height;
+};
+
+// Triangle mesh: a MeshBVH, shared with its Mesh, placed in the world by
+// "transform", which must not scale (distances are measured in the space
+// of the BVH).
+struct CollisionMesh {
+    const MeshBVH* bvh;
+    glm::mat4 transform;
+};
+
+// Narrow phase. The sphere-to-plane test checks the position the sphere
+// reaches after moving by "displacement" (RigidBody::getFuturePosition()).
+bool Collision_SphereToPlane(const CollisionSphere& sphere, const glm::vec4& displacement, const CollisionPlane& plane);
+bool Collision_SphereToBox(const CollisionSphere& sphere, const CollisionBox& box);
+// Only the distance in the XZ plane: the cylinder is infinite along Y
+bool Collision_SphereToCylinder(const CollisionSphere& sphere, const CollisionCylinder& cylinder);
+// Sphere inside the radius and below the bottom of the cylinder (in the hole)
+bool Collision_SphereToCylinderBottom(const CollisionSphere& sphere, const CollisionCylinder& cylinder);
+bool Collision_SphereToSphere(const CollisionSphere& sphere1, const CollisionSphere& sphere2);
+// Closest point of the mesh, in world space, if it touches the sphere
+bool Collision_SphereToMesh(const CollisionSphere& sphere, const CollisionMesh& mesh, MeshContact* contact);
+
+// Continuous tests: the sphere moves by "motion" from its center. Return
+// true and the time of impact in [0, 1] (fraction of "motion", 0 if they
+// already touch) when the sphere touches the shape along the way. The box
+// test sweeps the box grown by the radius, so it reports contact a little
+// early near the corners; its transform must not scale.
+bool Collision_SweepSphereToPlane(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionPlane& plane, float* toi);
+bool Collision_SweepSphereToBox(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionBox& box, float* toi);
+bool Collision_SweepSphereToCylinder(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionCylinder& cylinder, float* toi);
+
+// Bounce of a body off a plane: reflects the normal component of the
+// velocity and adds the normal force, which cancels gravity along the normal.
+void Collision_BounceOffPlane(RigidBody& body, const glm::vec4& normal);
+
+// Narrow phase plus response, as done for the ball. Each one only changes
+// "body", and returns true if the sphere touched the other shape.
+//
+// Plane: Collision_BounceOffPlane()
+bool Collision_RespondToPlane(RigidBody& body, const CollisionSphere& sphere, const CollisionPlane& plane);
+// Box: the box is a kill zone, the body is moved back to "respawn" at rest
+// (the ball uses BALL_RESPAWN_POSITION).
+#define BALL_RESPAWN_POSITION glm::vec4(0.0f, 3.0f, 0.0f, 1.0f)
+bool Collision_RespondToBox(RigidBody& body, const CollisionSphere& sphere, const CollisionBox& box, const glm::vec4& respawn);
+// Cylinder (the hole): inside its radius only gravity acts, so the body
+// falls through the floor; below its bottom the body bounces on it.
+bool Collision_RespondToCylinder(RigidBody& body, const CollisionSphere& sphere, const CollisionCylinder& cylinder);
+// Mesh: the body is pushed out of the closest triangle and bounces off the
+// plane tangent there, so it rolls over ramps and bumps like over a plane.
+// The bounce loses the energy the push out gave, so the body comes to rest.
+bool Collision_RespondToMesh(RigidBody& body, const CollisionSphere& sphere, const CollisionMesh& mesh);
+
+// Shapes known by the broad phase, one per narrow-phase test above
+enum ColliderShape {
+    ColliderSphere,   // Moving ball
+    ColliderPlane,    // Plane, infinite like in Collision_SphereToPlane
+    ColliderBox,      // Box, oriented by its transform like in Collision_SphereToBox
+    ColliderCylinder, // Cylinder, infinite along Y like in Collision_SphereToCylinder
+    ColliderMesh      // Triangle mesh, bounded by its BVH like in Collision_SphereToMesh
+};
+
+// Two colliders whose bounds overlap, by id (order of registration), first < second
+struct CollisionPair {
+    int first;
+    int second;
+};
+
+// Sweep-and-prune broad phase. Every collider gets a world AABB that contains
+// every position where its narrow-phase test can succeed (planes and
+// cylinders are unbounded along the directions their tests ignore). The
+// boxes are sorted by their minimum along one axis and swept once, so only
+// colliders whose intervals overlap on that axis are compared, instead of
+// every body against everything. The order is kept between updates, so the
+// insertion sort runs in about linear time while objects move a little.
+//
+// Only balls move; pairs of two static colliders are never reported. The
+// pairs are handed to the Collision_RespondTo* functions in registration
+// order, which is the order the physics loop used to test them by hand.
+//
+// Every response only changes the ball of its pair, so with a job system the
+// balls are dispatched in parallel, each one running its own pairs in that
+// same order: the result is identical to the sequential dispatch.
+//
+// Before the discrete tests, dispatch() sweeps each ball along the motion of
+// its last RigidBody::update() (continuous collision detection). A ball that
+// crossed a plane within one step, which the discrete test can no longer
+// see, is moved back to the time of impact, bounced, and moved for the rest
+// of the step, up to BROAD_PHASE_MAX_SUBSTEPS times. Not over a cylinder
+// (the hole): there the plane does not hold the ball up, and the discrete
+// response lets it fall. A ball whose path crossed a box (kill zone) is
+// respawned. Fast shots stay on the course with the usual 60 Hz step.
+// Meshes are swept like planes, against the triangle the center of the ball
+// crossed (MeshBVH::intersectRay()).
+//
+// Sleeping balls (RigidBody::isSleeping()) keep their last bounds and get no
+// pairs against static colliders, so they are neither swept nor responded
+// to; when every ball sleeps, update() returns at once. dispatch() wakes a
+// sleeping ball touched by an awake one. They are moved out of the sweep
+// when they fall asleep and back when they wake, so a step costs about the
+// same whatever the number of balls asleep.
+#define BROAD_PHASE_MAX_SUBSTEPS 4
+
+class BroadPhase {
 public:
-    collisor() = default;
-    ~collisor() = default;
-    bool SphereToPlane(Ball &ball, Plane &plane);
-    bool SphereToCube(Ball &ball, Cube &cube);
-    bool SphereToCylinder(Ball &ball, Cylinder &cylinder);
-    bool SphereToSphere(Ball &ball1, Ball &ball2);
-    bool SphereToCylinderBottom(Ball &ball, Cylinder &cylinder);
-
-};
\ No newline at end of file
+    BroadPhase() = default;
+
+    // Registers a collider and returns its id. A ball is centered at the
+    // position of "body"; "grounded", if given, is set when it touches a
+    // plane. Static colliders are copied and must be registered again if
+    // they move.
+    int addBall(RigidBody* body, float radius, bool* grounded = NULL);
+    int addPlane(const CollisionPlane& plane);
+    int addBox(const CollisionBox& box, const glm::vec4& respawn);
+    int addCylinder(const CollisionCylinder& cylinder);
+    // The BVH is not copied: it must outlive the broad phase
+    int addMesh(const CollisionMesh& mesh);
+    // Registers a copy of every static collider of "other", in its order
+    void addStatics(const BroadPhase& other);
+
+    // Recomputes the bounds of the balls and the candidate pairs
+    void update();
+    // Runs the narrow phase and collision response of every candidate pair.
+    // Refreshes the pairs if a response teleports a ball.
+    void dispatch(JobSystem* jobs = NULL);
+
+    inline const std::vector<CollisionPair>& getPairs() const { return pairs; }
+    inline size_t size() const { return colliders.size(); }
+
+private:
+    struct Collider {
+        ColliderShape shape;
+        RigidBody* body = NULL;    // Ball
+        float radius = 0.0f;       // Ball
+        bool* grounded = NULL;     // Ball
+        CollisionPlane plane;
+        CollisionBox box;
+        glm::vec4 respawn;         // Box
+        CollisionCylinder cylinder;
+        CollisionMesh mesh;
+        AABB bounds;
+    };
+
+    int add(const Collider& collider);
+    AABB computeBounds(const Collider& collider) const;
+    bool respond(const CollisionPair& pair) const;
+    bool dispatchBall(int ball, std::vector<CollisionPair>& ball_pairs) const;
+    bool sweepBall(int ball, const std::vector<CollisionPair>& ball_pairs, std::vector<int>& bounced) const;
+    // Whether a ball centered at "center" is over one of the cylinders of its pairs
+    bool crossesCylinder(const std::vector<CollisionPair>& ball_pairs, int ball, const glm::vec4& center) const;
+    void findBallPairs(int ball, std::vector<CollisionPair>& ball_pairs) const;
+
+    std::vector<Collider> colliders;
+    std::vector<int> order;    // Static and awake collider ids sorted by bounds.min[axis]
+    std::vector<int> sleepers; // Sleeping ball ids sorted by bounds.min[axis]
+    std::vector<int> statics;  // Static collider ids, in order of registration
+    std::vector<CollisionPair> pairs;
+    int axis = 0;              // Sweep axis, the one where the balls are most spread out
+    float sleeper_extent = 0.0f; // Largest size of the sleepers along the axis
+    // Centers of the static and sleeping colliders, summed per axis to pick
+    // the sweep axis without visiting them every update()
+    glm::dvec3 rest_sum = glm::dvec3(0.0), rest_sum_sq = glm::dvec3(0.0), rest_count = glm::dvec3(0.0);
+
+    // Buffers of dispatch(), kept between steps
+    std::vector<int> balls;
+    std::vector<int> ball_slot; // Per collider: index in "balls", or -1
+    std::vector<std::vector<CollisionPair> > pairs_by_ball;
+    std::vector<char> ball_moved;
+};
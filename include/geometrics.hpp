@@ -1,8 +1,13 @@
 #ifndef _GEOMETRICS_HPP
 #define _GEOMETRICS_HPP
 #include "glcontext.hpp"
+#include "uniformbuffers.hpp"
+#include "bounds.hpp"
 #include "physics.hpp"
 #include "tiny_obj_loader.h"
+#include "meshcache.hpp"
+#include "objloader.hpp"
+#include "assetcache.hpp"
 #include "collisions.hpp"
 // We define a structure that will store the necessary data to render
 // each object in the virtual scene.
@@ -20,9 +25,22 @@ struct ObjModel {
 
     // This constructor reads the model from a file using the tinyobjloader library.
     // See: https://github.com/syoyo/tinyobjloader
+    //
+    // Triangulated models are first looked up in the binary mesh cache (see
+    // "meshcache.hpp"); the text parse only runs when the cache is missing or
+    // stale, and its result is written back to the cache. The text is parsed
+    // by the parallel ObjLoader_Load(), or by tinyobj when the file uses
+    // something it does not handle.
     ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true) {
         printf("Loading objects from file \"%s\"...\n", filename);
 
+        if (triangulate && MeshCache_Load(filename, &attrib, &shapes)) {
+            printf("- Loaded from cache \"%s\"\n", MeshCache_Path(filename).c_str());
+            checkShapeNames(filename);
+            printf("OK.\n");
+            return;
+        }
+
         // If basepath == NULL, set basepath as the dirname of filename,
         // so that MTL files are correctly loaded if they are in the same directory as the OBJ files.
         std::string fullpath(filename);
@@ -37,7 +55,9 @@ struct ObjModel {
 
         std::string warn;
         std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
+        bool ret = triangulate && ObjLoader_Load(filename, basepath, &attrib, &shapes, &materials, &warn);
+        if (!ret)
+            ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
 
         if (!err.empty())
             fprintf(stderr, "\n%s\n", err.c_str());
@@ -45,6 +65,15 @@ struct ObjModel {
         if (!ret)
             throw std::runtime_error("Error loading model.");
 
+        checkShapeNames(filename);
+
+        if (triangulate && !MeshCache_Save(filename, attrib, shapes))
+            fprintf(stderr, "WARNING: Cannot write mesh cache \"%s\".\n", MeshCache_Path(filename).c_str());
+
+        printf("OK.\n");
+    }
+
+    void checkShapeNames(const char* filename) {
         for (size_t shape = 0; shape < shapes.size(); ++shape) {
             if (shapes[shape].name.empty()) {
                 fprintf(stderr,
@@ -57,106 +86,92 @@ struct ObjModel {
             }
             printf("- Object '%s'\n", shapes[shape].name.c_str());
         }
-
-        printf("OK.\n");
     }
 
 
 
 };
 
-class BezierCurve {
-private:
-    GLuint vao, vbo;
-    std::vector<glm::vec4> interpolated_points; // Coefficients of the Bezier curve
-    std::vector<glm::vec4> control_points = {
-        {0.0f, 3.0f, 0.0f, 1.0f}, // P0
-        {1.0f, 3.0f, 0.0f, 1.0f}, // P1
-        {2.0f, 3.0f, 0.0f, 1.0f}, // P2
-        {3.0f, 3.0f, 0.0f, 1.0f}  // P3
-    };
+// Line strip through the points of a TrajectoryPredictor, in world space.
+// The VBO is allocated once with room for "capacity" points and rewritten
+// each update(): glBufferData with NULL orphans the old storage, so the
+// driver hands out a fresh block instead of waiting for the draw of the
+// previous frame, and glBufferSubData fills it. Points past the capacity are
+// not drawn.
+class TrajectoryPreview {
 public:
-    glm::mat4 transform;
-    BezierCurve() {
-        setPoints(control_points);
-        computeInterpolatedPoints(0.01f); // Default step for interpolation
-        config();
-    }
-    BezierCurve(std::vector<glm::vec4> control_points) {
-        setPoints(control_points);
-        computeInterpolatedPoints(0.01f); // Default step for interpolation
-        config();
-    }
-    BezierCurve(std::vector<glm::vec4> control_points, float step) {
-        setPoints(control_points);
-        computeInterpolatedPoints(step);
-        config();
-    }
-    ~BezierCurve() = default;
-
-    inline void printInterpolatedPoints() {
-        for (const auto& point : interpolated_points) {
-            printf("Interpolated Point: (%f, %f, %f, %f)\n", point.x, point.y, point.z, point.w);
-        }
-    }
-    
-    inline void setPoints(std::vector<glm::vec4> points){
-        control_points.clear();
-        if (points.size() < 4) {
-            fprintf(stderr, "Error: Bezier cubic Curve requires at least 4 control points.\n");
-            return;
-        }
-        for (const auto& point : points) 
-            control_points.push_back(point);
-    }
-    inline void computeInterpolatedPoints(float step){
-        interpolated_points.clear();
-        glm::vec4 B, P0 = control_points[0], P1 = control_points[1], P2 = control_points[2], P3 = control_points[3];
-        for(float t = 0; t <= 1; t += step) {
-            B = static_cast<float>(pow((1-t),3))*P0 + 3*static_cast<float>(pow((1-t),2))*t*P1 + 3*static_cast<float>((1-t)*t*t)*P2 + static_cast<float>(t*t*t)*P3;
-            interpolated_points.push_back(B);
-        }
-        
-    }
+    explicit TrajectoryPreview(size_t capacity);
+    ~TrajectoryPreview();
 
-    inline void config() {
-        glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
-        glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, interpolated_points.size() * sizeof(glm::vec4), interpolated_points.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
-        glBindVertexArray(0);
+    void update(const std::vector<glm::vec4>& points);
+    void draw(ShaderProgram& program);
 
-    }
+private:
+    TrajectoryPreview(const TrajectoryPreview&);
+    TrajectoryPreview& operator=(const TrajectoryPreview&);
+
+    GLuint vao = 0, vbo = 0;
+    GLsizei capacity;
+    GLsizei count = 0;
+    ObjectUniformBuffer object_uniforms; // Identity model matrix: the points are in world space
+    UniformSlot render_as_black_uniform{"render_as_black"};
+    UniformSlot use_instancing_uniform{"use_instancing"};
+};
 
-    inline void draw(GLuint program_id) {
-        
-        glUniform1i(glGetUniformLocation(program_id, "render_as_black"), true);
-        glBindVertexArray(vao);
-        glLineWidth(10.0f); // Define linha com 3 pixels de espessura
-        glDrawArrays(GL_LINE_STRIP, 0, interpolated_points.size()); 
-        glBindVertexArray(0);
-        
-    }
-    void setTrajectoryFromVelocity(glm::vec4 p0, glm::vec4 v0, glm::vec4 a, float bounce_factor);
 
-};
 
+// Levels of detail built for each shape of a Mesh, see Mesh::setLodLevels()
+#define MESH_LOD_LEVELS 6
 
+// Vertex of the compact interleaved layout (Mesh::Compact): 20 bytes instead
+// of the 40 bytes of the separate vec4/vec4/vec2 float buffers.
+struct CompactVertex {
+    GLfloat  position[3]; // vec3, w = 1 is implied by the vertex shader
+    GLuint   normal;      // GL_INT_2_10_10_10_REV, normalized (w unused)
+    GLushort texcoord[2]; // GL_HALF_FLOAT
+};
 
 class Mesh {
+public:
+    // Vertex buffer layout used by BuildTrianglesAndAddToVirtualScene()
+    enum VertexLayout {
+        Separate, // Three float VBOs: position vec4, normal vec4, texcoord vec2
+        Compact   // One interleaved VBO of CompactVertex
+    };
 protected:
     Mesh() = default;
-    ObjModel* model = nullptr; // Pointer to the model loaded from a file
+    ModelHandle model; // Shared with every Mesh of the same file and scale (g_AssetCache)
+    std::string model_path; // File of the model, see loadModel()
+    glm::vec3 model_scale = glm::vec3(1.0f); // Scale of the vertices, see rescale()
+    void loadModel(const std::string& filename);
     std::string name;
     bool has_color = true; // If true, render the mesh as black
     int id;
+    // Normal of the first triangle. The vertex normals themselves are
+    // computed by the AssetCache when the model is imported.
     glm::vec4 ComputeNormals();
     glm::vec4 ComputeNormals(bool force);
     void BuildTrianglesAndAddToVirtualScene(VirtualScene& scene);
+    void LoadAndAddToVirtualScene(VirtualScene& scene, AssetLoader& loader);
     GLuint texture_id = 0; // Texture ID for the mesh
+    SceneHandle scene_handle = INVALID_SCENE_HANDLE; // Object drawn for the mesh (its last shape)
+    AABB local_bounds = AABB_Empty(); // Bounds of the model vertices, see updateLocalBounds()
+    BoundingSphere local_sphere = BoundingSphere_FromAABB(AABB_Empty());
+    glm::vec4 local_center = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Mean of the model vertices (the pivot)
+    AABB world_bounds = AABB_Empty(); // Local bounds moved by "transform" in updateTransform()
+    BoundingSphere world_sphere = BoundingSphere_FromAABB(AABB_Empty());
+    void updateLocalBounds();
+    GLuint sampler_id = 0; // Sampler object with the wrap/filter modes of the texture
+    TextureHandle texture; // Keep the shared texture and sampler alive (g_AssetCache)
+    SamplerHandle sampler;
+    ObjectUniformBuffer object_uniforms; // Model and normal matrices, see updateTransform()
+    int material_index = 0; // Index into the MaterialTable; 0 is the default material
+    bool optimize_vertex_cache = true; // Reorder triangles for the GPU vertex cache when building the VAO
+    VertexLayout vertex_layout = Compact; // Vertex buffer layout used when building the VAO
+    int lod_levels = MESH_LOD_LEVELS; // Coarser versions built with the VAO (MeshOpt_BuildLodChain())
+    int current_lod = 0; // Level drawn last frame, see selectLod()
+    MeshBVH* collision_bvh = nullptr; // Triangles for collision, see getCollisionMesh()
+    void buildCollisionBVH();
     
     public:
     bool use_texture = false;
@@ -165,34 +180,77 @@ protected:
     Mesh(std::string filename);
     virtual ~Mesh();
     void rescale(float sx, float sy, float sz);
-    inline void addToVirtualScene(VirtualScene& scene) {
+    // With a "loader", the mesh is drawn as its bounding box until a worker
+    // has built its vertex and index buffers (welding, vertex cache order,
+    // levels of detail) and processUploads() has sent them to the GPU
+    inline void addToVirtualScene(VirtualScene& scene, AssetLoader* loader = NULL) {
         id = scene.getNextId();
-        BuildTrianglesAndAddToVirtualScene(scene);
+        if (loader != NULL)
+            LoadAndAddToVirtualScene(scene, *loader);
+        else
+            BuildTrianglesAndAddToVirtualScene(scene);
     }
-    inline ObjModel* getModel() { return model; }
-    inline std::string getName() { return name; }
+    inline const ObjModel* getModel() const { return model.get(); }
+    inline const std::string& getName() const { return name; }
+    inline SceneHandle getSceneHandle() const { return scene_handle; }
+    inline const AABB& getLocalBounds() const { return local_bounds; }
+    inline const BoundingSphere& getLocalSphere() const { return local_sphere; }
+    inline const AABB& getWorldBounds() const { return world_bounds; }
+    inline const BoundingSphere& getWorldSphere() const { return world_sphere; }
     inline glm::mat4 getTransform() const { return transform; }
     inline void setColor(bool color) { has_color = color; }
     void updateTransform();
+    // Transform at the given position and rotation instead of the body's
+    // (e.g. interpolated between two physics steps)
+    void updateTransform(const glm::vec4& position, const glm::vec4& rotation);
     inline void setTransform(glm::mat4 transform) { this->transform = transform; }
-    void sendTransform(GLint program_id);
-    inline glm::vec4 getMeshCenter() { return body->ComputeRigidBodyCenter(this->model); }
-    inline glm::vec4 getCenter() { return getMeshCenter() + (body->getPosition() - getMeshCenter()); }
+    void sendTransform();
+    // Cached by updateLocalBounds() when the model is loaded or rescaled:
+    // collision tests call these every physics step
+    inline glm::vec4 getMeshCenter() const { return local_center; }
+    // The body is placed by its pivot, the mesh center
+    inline glm::vec4 getCenter() const { return body->getPosition(); }
     inline void setPivot(const glm::vec4& p) { this->body->setPivot(p); }
+    // The triangles of the model as a collider (BroadPhase::addMesh()), for
+    // course pieces with no analytic shape. The BVH is built on the first
+    // call and again by rescale(); the transform must not scale.
+    CollisionMesh getCollisionMesh();
     inline glm::mat4 getTransform() { return transform; }
     inline void setName(const std::string& n) { name = n; }
     glm::vec3 compute_bbox_min(const tinyobj::attrib_t& attrib);
     glm::vec3 compute_bbox_max(const tinyobj::attrib_t& attrib);
-    inline glm::vec3 getMeshSize(ObjModel* model) {
+    inline glm::vec3 getMeshSize(const ObjModel* model) {
         glm::vec3 min = compute_bbox_min(model->attrib);
         glm::vec3 max = compute_bbox_max(model->attrib);
         return max - min;
     }
     inline void setID(int newid) { id = newid; }
-    void LoadTextureImage(const char* filename);
+    inline void setMaterial(int index) {
+        material_index = index;
+        object_uniforms.setMaterial(index);
+    }
+    inline int getMaterial() const { return material_index; }
+    inline void setVertexCacheOptimization(bool enabled) { optimize_vertex_cache = enabled; }
+    inline void setVertexLayout(VertexLayout layout) { vertex_layout = layout; }
+    // Must be called before addToVirtualScene(); 0 disables levels of detail
+    inline void setLodLevels(int levels) { lod_levels = levels; }
+    inline int getLod() const { return current_lod; }
+    // Level of detail of "object" (the mesh's own, from the scene) to draw
+    // when one world unit covers "pixels_per_unit" pixels at the mesh
+    // (Camera::getPixelsPerUnit()). The errors of the levels are in model
+    // units, so they are scaled by the transform like the bounding sphere.
+    inline int selectLod(const SceneObject& object, float pixels_per_unit) {
+        float scale = local_sphere.radius > 0.0f ? world_sphere.radius / local_sphere.radius : 1.0f;
+        current_lod = SceneObject_SelectLod(object, pixels_per_unit * scale, current_lod);
+        return current_lod;
+    }
+    // Texture of the mesh, shared with every Mesh that loads the same file.
+    // With a "loader", a placeholder until the image is decoded and uploaded.
+    void LoadTextureImage(const char* filename, AssetLoader* loader = NULL);
     inline void setTexture(GLuint texid) {
         use_texture = true;
         texture_id = texid;
+        texture.reset();
     }
 
     inline void disableTexture() {
@@ -203,8 +261,23 @@ protected:
         return use_texture;
     }
 
+    // Read from the shared texture, whose GL name changes when it is loaded
     inline GLuint getTextureId() const {
-        return texture_id;
+        return texture ? texture->texture_id : texture_id;
+    }
+
+    inline GLuint getSamplerId() const {
+        return sampler_id;
+    }
+
+    // Wrap mode of the texture (GL_CLAMP_TO_EDGE by default). Set once after
+    // LoadTextureImage(), not per draw: picks the shared sampler of the mode.
+    void setTextureWrap(GLenum wrap);
+
+    // ObjectData of the mesh, synced with "transform", for RenderQueue items
+    inline ObjectUniformBuffer* getObjectUniforms() {
+        object_uniforms.setModel(transform);
+        return &object_uniforms;
     }
 
 };
@@ -220,6 +293,10 @@ public:
     Cube(float size, std::string model_filename);
     Cube(float size, std::string model_filename, glm::vec4 position);
     Cube(float width, float height, float depth, std::string model_filename, glm::vec4 position);
+    inline CollisionBox getCollisionBox() const {
+        CollisionBox box = { transform, glm::vec3(width, height, depth) * 0.5f };
+        return box;
+    }
 };
 
 class Plane : public Mesh {
@@ -230,9 +307,14 @@ public:
     Plane() = default; // Default constructor is deleted to prevent instantiation without parameters
     Plane(float width, float height, std::string model_filename);
     Plane(float width, float height, glm::vec4 position, std::string model_filename);
+    inline CollisionPlane getCollisionPlane() {
+        CollisionPlane plane = { getCenter(), normal };
+        return plane;
+    }
 };
 
 
+class Cylinder; // Forward declaration, for Ball::testCollisionWithCylinder
 class Ball : public Mesh {
 private:
     // The ball is a sphere with a radius, position, rotation, and scale.
@@ -248,6 +330,10 @@ public:
     void testCollisionWithPlane(Plane* plane);
     void testCollisionWithCube(Cube* cube);
     void testCollisionWithCylinder(Cylinder* cylinder);
+    inline CollisionSphere getCollisionSphere() {
+        CollisionSphere sphere = { getCenter(), radius };
+        return sphere;
+    }
 };
 class Cylinder : public Mesh {
 public:
@@ -256,6 +342,22 @@ public:
     Cylinder() = default; // Default constructor is deleted to prevent instantiation without parameters
     Cylinder(float radius, float height, std::string model_filename);
     Cylinder(float radius, float height, glm::vec4 position, std::string model_filename);
+    inline CollisionCylinder getCollisionCylinder() {
+        CollisionCylinder cylinder = { getCenter(), radius, height };
+        return cylinder;
+    }
+};
+
+// Collision tests between meshes, on top of the Collision_* functions
+class collisor {
+public:
+    collisor() = default;
+    ~collisor() = default;
+    bool SphereToPlane(Ball &ball, Plane &plane);
+    bool SphereToCube(Ball &ball, Cube &cube);
+    bool SphereToCylinder(Ball &ball, Cylinder &cylinder);
+    bool SphereToSphere(Ball &ball1, Ball &ball2);
+    bool SphereToCylinderBottom(Ball &ball, Cylinder &cylinder);
 
 };
 
@@ -287,4 +389,4 @@ public:
     void animate(float deltaTime, GLFWwindow* window); // Animate the golf club
     void move(GLFWwindow* window); // Move the golf club based on user input
 };
-#endif // _GEOMETRICS_HPPs
\ No newline at end of file
+#endif // _GEOMETRICS_HPPs
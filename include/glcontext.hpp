@@ -6,37 +6,125 @@
 #include "tiny_obj_loader.h"
 #include "utils.h"
 #include "matrices.hpp"
+#include "shaderprogram.hpp"
+#include "glm/mat3x3.hpp"
 #include <sstream>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 #include <string>
 #include <map>
+#include <cstdint>
 
 
+// Coarser version of a SceneObject (MeshOpt_BuildLodChain()): another range
+// of the same index buffer, drawn with the same VAO
+struct SceneLod {
+    size_t first_index;
+    int num_indices;
+    float error; // How far the surface moved from the full model, in model units
+};
+
+// A level of detail is drawn while its error covers at most LOD_PIXEL_ERROR
+// pixels. Switching to a coarser level than the current one needs the error
+// LOD_HYSTERESIS below that, so an object right at the threshold distance
+// does not flip between two levels every frame.
+#define LOD_PIXEL_ERROR 0.5f
+#define LOD_HYSTERESIS 0.25f
+
 struct SceneObject {
     std::string name;        // Object name
     size_t first_index; // Index of the first vertex within the indices[] vector defined in BuildTriangles()
     int num_indices; // Number of indices of the object within the indices[] vector defined in BuildTriangles()
+    std::vector<SceneLod> lods; // Levels of detail 1, 2, ... (level 0 is first_index/num_indices), finest first
     GLuint vao; // ID of the VAO where the model attributes are stored
     GLenum rendering_mode; // Rasterization mode (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
     bool has_color = true; // Indicates if the object has an associated color
     GLfloat line_width = 4.0f; // Line width for objects of type GL_LINES
+    GLuint instance_vbo = 0; // Buffer with one InstanceData per instance (see VirtualScene::setInstances)
+    GLsizei instance_count = 0; // Number of instances stored in instance_vbo
+    GLsizei instance_capacity = 0; // Number of matrices the instance_vbo can hold without reallocation
+    uint32_t generation = 0; // Generation of the slot holding the object (see SceneHandle)
+    bool alive = false; // False for free slots of VirtualScene
+};
+
+// Stable reference to a SceneObject of a VirtualScene: the slot index in its
+// dense object array plus the generation of that slot. Removing an object
+// bumps the generation, so handles to it become stale instead of silently
+// pointing at whatever object reuses the slot.
+struct SceneHandle {
+    uint32_t index;
+    uint32_t generation;
 };
+#define INVALID_SCENE_HANDLE SceneHandle{ 0xFFFFFFFFu, 0 }
 
+// Per-instance vertex attributes of instanced draws. The normal matrix is
+// precomputed here for the same reason as in ObjectUniforms.
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normal_matrix;
+};
+
+// Vertex attribute locations of InstanceData (a matN takes N consecutive
+// locations). Must match "instance_model" and "instance_normal_matrix" in
+// shader_vertex.glsl.
+#define INSTANCE_MODEL_LOCATION 4
+#define INSTANCE_NORMAL_MATRIX_LOCATION 8
+
+// Objects are kept in one contiguous array and addressed by SceneHandle, so
+// the render loop never compares strings. Names are only indexed for tooling
+// and debugging (find()).
 class VirtualScene {
 private:
     int id_count = 0;
+    std::vector<SceneObject> objects;     // Dense array of slots, free ones have alive == false
+    std::vector<uint32_t> free_slots;     // Slots to reuse before growing "objects"
+    std::map<std::string, SceneHandle> names; // Name index, not used while drawing
+    UniformSlot render_as_black_uniform{"render_as_black"};
+    UniformSlot use_instancing_uniform{"use_instancing"};
 public:
-    std::map<std::string, SceneObject> scene_objects; // Map of objects in the virtual scene
-
     VirtualScene() = default;
     ~VirtualScene() = default;
     inline int getNextId() { return id_count++; }
-    void drawAll(GLuint program_id);
-    void draw(GLuint program_id, const std::string& object_name);
+
+    // Stores an object and returns its handle. An object with the same name
+    // stays in the scene, but find() returns the new one.
+    SceneHandle add(const SceneObject& object);
+    // Removes an object; its handle (and copies of it) become invalid.
+    void remove(SceneHandle handle);
+    bool isValid(SceneHandle handle) const;
+    // Handle of an object by name, or INVALID_SCENE_HANDLE. Not for the render loop.
+    SceneHandle find(const std::string& object_name) const;
+
+    // Object of a handle, for RenderQueue items. Throws if the handle is stale.
+    const SceneObject& getObject(SceneHandle handle) const;
+
+    // Replaces the VAO, index range and levels of detail of an object,
+    // keeping its name, handle and instances (a placeholder swapped for the
+    // mesh an AssetLoader finished). The old VAO is not deleted.
+    void setGeometry(SceneHandle handle, GLuint vao, size_t first_index, int num_indices, const std::vector<SceneLod>& lods);
+
+    void drawAll(ShaderProgram& program);
+    void draw(ShaderProgram& program, SceneHandle handle);
+
+    // Stores one model matrix (and its normal matrix) per instance of the object, in a buffer attached
+    // to the object's VAO as a per-instance attribute. The VAO is shared by
+    // all shapes of a Mesh, so only one of them should be instanced.
+    void setInstances(SceneHandle handle, const std::vector<glm::mat4>& transforms);
+    // Draws every instance stored by setInstances() with a single call.
+    void drawInstanced(ShaderProgram& program, SceneHandle handle);
+
+private:
+    SceneObject& checkedObject(SceneHandle handle);
 };
 
+// Level of detail of "object" to draw when one model unit covers
+// "pixels_per_unit" pixels on screen: the coarsest one whose error stays
+// under LOD_PIXEL_ERROR pixels. "current" is the level drawn last frame.
+int SceneObject_SelectLod(const SceneObject& object, float pixels_per_unit, int current);
+// Index range of a level of detail (0 = the full object)
+void SceneObject_LodRange(const SceneObject& object, int lod, size_t* first_index, int* num_indices);
+
 class Callback {
 public:
     virtual ~Callback() {}
@@ -0,0 +1,60 @@
+//Small work-stealing job system
+#ifndef _JOBSYSTEM_HPP
+#define _JOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed pool of worker threads, each with its own queue of jobs. A worker
+// takes jobs from the front of its queue and, when it runs dry, steals from
+// the back of the others, so uneven chunks still keep every core busy. The
+// thread that submits the work also runs jobs while it waits, so a system
+// with one thread runs everything inline, without any worker.
+//
+// parallelFor() splits [0, count) in chunks whose boundaries depend only on
+// "count" and "chunk", never on the number of threads: as long as each chunk
+// writes only its own data, the result is the same with 1 or 16 threads.
+class JobSystem {
+public:
+    // "threads" counts the calling thread; 0 uses one per hardware core
+    explicit JobSystem(unsigned threads = 0);
+    ~JobSystem();
+
+    // Calls job(first, last) for consecutive chunks of at most "chunk" items
+    // covering [0, count), and returns when all of them have finished.
+    void parallelFor(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& job);
+
+    inline unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+private:
+    JobSystem(const JobSystem&);
+    JobSystem& operator=(const JobSystem&);
+
+    struct Job {
+        std::function<void()> run;
+        std::atomic<size_t>* pending; // Decremented when the job is done
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    bool popJob(size_t queue, Job& job);
+    bool stealJob(size_t thief, Job& job);
+    void workerLoop(size_t index);
+
+    std::vector<std::thread> workers;
+    std::vector<Queue*> queues;         // One per worker, plus one for the callers
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued_jobs;    // Jobs waiting in any queue
+    bool quit = false;
+};
+
+#endif // _JOBSYSTEM_HPP
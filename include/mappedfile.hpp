@@ -0,0 +1,28 @@
+//Read-only view of a whole file
+#ifndef _MAPPEDFILE_HPP
+#define _MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <vector>
+
+// The bytes of a file, for loaders that parse it in place (the mesh cache,
+// the OBJ parser). Uses mmap() where available, so reading costs no copy
+// beyond the page cache; elsewhere the file is read into a buffer. "data" is
+// NULL when the file cannot be read or is empty.
+class MappedFile {
+public:
+    explicit MappedFile(const char* filename);
+    ~MappedFile();
+
+    const char* data = NULL;
+    size_t size = 0;
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    bool mapped = false;
+    std::vector<char> buffer; // Contents when the file could not be mapped
+};
+
+#endif // _MAPPEDFILE_HPP
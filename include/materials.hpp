@@ -0,0 +1,64 @@
+//Surface materials shared by all draws through a uniform buffer
+#ifndef _MATERIALS_HPP
+#define _MATERIALS_HPP
+
+#include "glad/glad.h"
+#include "glm/vec4.hpp"
+#include <string>
+#include <vector>
+
+// Binding point of the "MaterialData" uniform block in shader_fragment.glsl
+#define MATERIAL_UNIFORM_BINDING 2
+// Size of the material array in the shader. Must match MAX_MATERIALS in
+// shader_fragment.glsl; raising it is the only change that needs the shader.
+#define MAX_MATERIALS 64
+// Material index that makes the fragment shader output the vertex color
+// instead of lighting the surface.
+#define MATERIAL_VERTEX_COLOR -1
+
+// Phong parameters of a surface. Same layout as the std140 struct "Material"
+// in shader_fragment.glsl (three vec4, no padding).
+struct Material {
+    glm::vec4 diffuse;   // rgb = Kd, w = multiplier applied to the texture color
+    glm::vec4 specular;  // rgb = Ks, w = specular exponent q
+    glm::vec4 ambient;   // rgb = Ka, w unused
+};
+
+// The table of every material of the scene, uploaded once into a UBO that the
+// fragment shader indexes with the material index of each draw (see
+// ObjectUniforms::material). Materials are read from a text file, so adding a
+// surface type does not touch the shaders.
+class MaterialTable {
+public:
+    MaterialTable() = default;
+    ~MaterialTable();
+
+    // Reads materials from a text file, one per line:
+    //   name  Kd.r Kd.g Kd.b  Ks.r Ks.g Ks.b  Ka.r Ka.g Ka.b  q  texture_scale
+    // Empty lines and lines starting with '#' are ignored. Returns false if the
+    // file cannot be opened; malformed lines are reported and skipped.
+    bool loadFromFile(const char* filename);
+
+    // Adds (or replaces) a material and returns its index, or -1 if the
+    // table is full.
+    int add(const std::string& name, const Material& material);
+    // Index of a material by name, or MATERIAL_VERTEX_COLOR if there is none.
+    int find(const std::string& name) const;
+
+    inline size_t size() const { return materials.size(); }
+    inline const Material& get(int index) const { return materials[index]; }
+
+    // Uploads the table if it changed and binds it to MATERIAL_UNIFORM_BINDING
+    void bind();
+
+private:
+    MaterialTable(const MaterialTable&);
+    MaterialTable& operator=(const MaterialTable&);
+
+    std::vector<std::string> names;
+    std::vector<Material> materials;
+    GLuint ubo = 0;
+    bool dirty = true;
+};
+
+#endif // _MATERIALS_HPP
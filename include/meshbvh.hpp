@@ -0,0 +1,93 @@
+//Bounding volume hierarchy of triangle meshes
+#ifndef _MESHBVH_HPP
+#define _MESHBVH_HPP
+
+#include "bounds.hpp"
+#include "glm/vec3.hpp"
+#include <cstddef>
+#include <vector>
+
+// Closest point of a mesh to a query point
+struct MeshContact {
+    glm::vec3 point;  // On the surface of the mesh
+    glm::vec3 normal; // Unit, from "point" towards the query point (the face normal if they coincide)
+    float distance;
+    int triangle;     // Index of the triangle in the order given to MeshBVH::build()
+};
+
+// First triangle hit by a ray
+struct MeshHit {
+    float t;          // The hit point is origin + t * direction
+    glm::vec3 point;
+    glm::vec3 normal; // Unit face normal, against the direction of the ray
+    int triangle;     // Index of the triangle in the order given to MeshBVH::build()
+};
+
+// Point of the triangle abc closest to p (Ericson, Real-Time Collision
+// Detection, 5.1.5): works for points over the faces, edges and corners.
+glm::vec3 Triangle_ClosestPoint(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+// Construction parameters. The build stops splitting at MESHBVH_MAX_DEPTH,
+// so the traversal stack of the queries has a fixed size.
+#define MESHBVH_BINS 12
+#define MESHBVH_LEAF_SIZE 4
+#define MESHBVH_MAX_DEPTH 48
+
+// BVH over the triangles of a model, built once when the model is loaded
+// (and again if its vertices change, e.g. Mesh::rescale()). Each node is
+// split where the binned surface area heuristic is cheapest: the centroids
+// are dropped in MESHBVH_BINS bins along each axis and every boundary
+// between bins is evaluated, in linear time per level. A node stays a leaf
+// when splitting would cost more than testing its triangles.
+//
+// The nodes are stored depth first (the left child right after its parent)
+// and the triangles are copied in leaf order, so a query walks memory
+// mostly forward. The BVH is in the space of the vertices it was built
+// from; CollisionMesh places it in the world.
+class MeshBVH {
+public:
+    MeshBVH() = default;
+
+    // "vertices" holds xyz triples (tinyobj::attrib_t::vertices) and
+    // "indices" three vertex indices per triangle. Replaces any previous tree.
+    void build(const std::vector<float>& vertices, const std::vector<unsigned>& indices);
+
+    // Closest point of the mesh to "point", if it is not farther than
+    // "max_distance". Subtrees whose boxes are farther than the best
+    // triangle found so far are skipped, nearest child first.
+    bool closestPoint(const glm::vec3& point, float max_distance, MeshContact* contact) const;
+    // Same result testing every triangle; for checks and benchmarks
+    bool closestPointBruteForce(const glm::vec3& point, float max_distance, MeshContact* contact) const;
+
+    // First triangle hit by origin + t * direction, 0 <= t <= max_t, from
+    // either side (direction = motion and max_t = 1 for a segment). Only
+    // subtrees the ray enters before the best hit so far are visited.
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float max_t, MeshHit* hit) const;
+
+    inline const AABB& getBounds() const { return bounds; }
+    inline bool empty() const { return triangles.empty(); }
+    inline size_t getTriangleCount() const { return triangles.size(); }
+    inline size_t getNodeCount() const { return nodes.size(); }
+
+private:
+    // Leaf when count > 0, with the triangles [first, first + count).
+    // Otherwise the children are the next node and node "first".
+    struct Node {
+        AABB bounds;
+        int first;
+        int count;
+    };
+    struct Triangle {
+        glm::vec3 a, b, c;
+    };
+
+    void testTriangle(int index, const glm::vec3& point, float& best_sq, MeshContact* contact) const;
+    void intersectTriangle(int index, const glm::vec3& origin, const glm::vec3& direction, float& best_t, MeshHit* hit) const;
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+    std::vector<int> triangle_ids; // Index given to build() of each entry of "triangles"
+    AABB bounds = AABB_Empty();
+};
+
+#endif // _MESHBVH_HPP
@@ -0,0 +1,49 @@
+//Binary mesh cache for ".obj" models
+#ifndef _MESHCACHE_HPP
+#define _MESHCACHE_HPP
+
+#include <string>
+#include <vector>
+#include "tiny_obj_loader.h"
+
+// Parsing a large OBJ file as text (e.g. golf_ball.obj, ~84k lines) dominates
+// the startup time of the game. After the first successful parse we dump the
+// tinyobj structures to a flat binary file next to the OBJ ("<file>.meshcache")
+// and, on the next runs, read that file back instead of parsing the text.
+//
+// File layout (version MESHCACHE_VERSION, little-endian, every section aligned
+// to 16 bytes so the file can be memory-mapped and read in place):
+//
+//   MeshCacheHeader
+//   MeshCacheShape[num_shapes]
+//   float   positions[3 * num_positions]  // attrib.vertices
+//   float   normals[3 * num_normals]      // attrib.normals
+//   float   texcoords[2 * num_texcoords]  // attrib.texcoords
+//   per shape:
+//     char          name[name_length]
+//     index_t       indices[num_indices]  // interleaved (v, vn, vt) triples
+//     unsigned char num_face_vertices[num_faces]
+//     int           material_ids[num_faces]
+//
+// Positions, normals and texcoords are kept as separate streams because
+// tinyobj indexes them independently; welding them into one vertex stream
+// happens later, when the mesh is uploaded to the GPU.
+//
+// The cache is only used when it was written from a source OBJ with the same
+// size and modification time, and when it is not older than the OBJ itself.
+// Materials are not cached (no code path reads ObjModel::materials).
+
+#define MESHCACHE_VERSION 1
+
+// Path of the cache file associated with an OBJ file.
+std::string MeshCache_Path(const char* obj_filename);
+
+// Fills "attrib" and "shapes" from the cache of "obj_filename". Returns false
+// (leaving the outputs untouched) if the cache is missing, stale, or invalid.
+bool MeshCache_Load(const char* obj_filename, tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes);
+
+// Writes the cache of "obj_filename". Returns false if the file could not be
+// written (e.g. read-only asset directory); the caller can simply go on.
+bool MeshCache_Save(const char* obj_filename, const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes);
+
+#endif // _MESHCACHE_HPP
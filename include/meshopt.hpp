@@ -0,0 +1,72 @@
+//Index buffer optimizations for triangle meshes
+#ifndef _MESHOPT_HPP
+#define _MESHOPT_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Size of the post-transform vertex cache assumed by the functions below. Real
+// GPUs do not expose theirs; 32 entries is a common middle ground between the
+// FIFO caches of older hardware and the batch-based reuse of recent ones.
+#define MESHOPT_VERTEX_CACHE_SIZE 32
+
+// Welds identical vertices. "vertices" holds one record of "stride" floats per
+// vertex (e.g. position, normal and texture coordinates side by side), and
+// "indices" references those records. Records with bitwise identical contents
+// are merged: on return "vertices" only holds the unique records (in order of
+// first use) and "indices" is remapped to them. Returns the number of unique
+// vertices.
+size_t MeshOpt_WeldVertices(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices);
+
+// Reorders the triangles in indices[first, first + count) so that consecutive
+// triangles reuse recently transformed vertices, using Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation" heuristic. Only the order of the
+// triangles changes: each one keeps its three indices as they were, so the
+// winding is preserved.
+void MeshOpt_OptimizeVertexCache(std::vector<unsigned int>& indices, size_t first, size_t count, size_t num_vertices);
+
+// Number of vertex shader invocations needed to draw indices[first, first +
+// count), simulating a FIFO post-transform cache with "cache_size" entries.
+size_t MeshOpt_VertexShaderInvocations(const std::vector<unsigned int>& indices, size_t first, size_t count, size_t cache_size = MESHOPT_VERTEX_CACHE_SIZE);
+
+// Simplifies the triangles indices[first, first + count) of a welded mesh to
+// at most "target_count" indices (fewer triangles make it stop earlier only
+// when no edge can be collapsed without flipping a triangle). Edges are
+// collapsed cheapest first by the quadric error metric of Garland and
+// Heckbert (1997): each vertex accumulates the planes of its triangles, and
+// moving it onto a neighbor costs the sum of squared distances to them.
+//
+// Every collapse moves a vertex onto the other end of its edge instead of a
+// new optimal position, so the result indexes the same "vertices" (records
+// of "stride" floats, the position first) and all levels of detail of a mesh
+// share one vertex buffer. Records with the same position (seams of normals
+// or texture coordinates) collapse together; border and non-manifold
+// vertices never move. Appends the indices to "out" and returns the error of
+// the result: the largest distance (in the units of the positions) from a
+// moved vertex to the planes of its original triangles, as an estimate of
+// how far the surface moved.
+float MeshOpt_Simplify(const std::vector<float>& vertices, size_t stride, const std::vector<unsigned int>& indices,
+                       size_t first, size_t count, size_t target_count, std::vector<unsigned int>& out);
+
+// One level of detail built by MeshOpt_BuildLodChain(): its range of the
+// index buffer and the MeshOpt_Simplify() error accumulated from the full model
+struct MeshOptLod {
+    size_t first;
+    size_t count;
+    float error;
+};
+
+// Each level keeps about this fraction of the triangles of the previous one
+#define MESHOPT_LOD_REDUCTION 0.5f
+// Smallest level worth building
+#define MESHOPT_LOD_MIN_TRIANGLES 32
+
+// Builds up to "max_levels" coarser versions of indices[first, first + count),
+// each simplified from the previous one, and appends them to "indices" (so
+// they share its vertex buffer). Stops early when a level would be too small
+// or barely simpler than the last. Appends one MeshOptLod per level to "lods"
+// and returns how many were built.
+size_t MeshOpt_BuildLodChain(const std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+                             size_t first, size_t count, int max_levels, std::vector<MeshOptLod>& lods);
+
+#endif // _MESHOPT_HPP
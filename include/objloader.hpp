@@ -0,0 +1,62 @@
+//Parallel ".obj" parser
+#ifndef _OBJLOADER_HPP
+#define _OBJLOADER_HPP
+
+#include <string>
+#include <vector>
+#include "tiny_obj_loader.h"
+
+class JobSystem;
+
+// tinyobj::LoadObj() reads an OBJ file line by line through an istream and
+// parses every number with its own digit loop, on one thread; for
+// golf_ball.obj (~84k lines) that is most of the time ObjModel spends when
+// the mesh cache is cold. ObjLoader_Load() maps the file (MappedFile) and
+// splits it in chunks of about OBJLOADER_CHUNK_BYTES, cut at line ends, that
+// the threads of a JobSystem parse at the same time:
+//
+//   1. each chunk reads its "v", "vn" and "vt" lines into its own arrays and
+//      its faces as raw corners; negative (relative) indices are kept
+//      relative to the chunk, whose first vertex is not known yet, and
+//      "g", "o", "s", "usemtl" and "mtllib" lines are kept as commands at
+//      their position among the faces;
+//   2. the vertex counts of the chunks, added up in order, say where each
+//      chunk's arrays go in tinyobj::attrib_t, and each chunk copies them
+//      there;
+//   3. each chunk resolves its relative indices, checks them against the
+//      final counts and splits its quads into triangles, exactly as
+//      tinyobj does (along the shorter diagonal);
+//   4. one thread replays the commands in file order: materials, smoothing
+//      groups and shape boundaries, appending each run of triangles to the
+//      current shape.
+//
+// The chunk boundaries depend only on the file, never on the number of
+// threads, and the result is the one tinyobj::LoadObj() gives with
+// triangulation on (the same shapes, indices, material ids and smoothing
+// groups) except for the last bit of some floats: numbers are parsed as a
+// 64-bit integer mantissa scaled once by an exact power of ten, instead of
+// tinyobj's digit by digit sum, and never through strtod() or the C locale.
+//
+// Only the subset of OBJ used by 3D tools for polygon meshes is parsed.
+// The function returns false for anything else (lines "l", points "p", tags
+// "t", skin weights "vw", vertex colors, polygons of more than four corners,
+// indices out of range, lone '\r' line ends) and for unreadable files;
+// callers then fall back to tinyobj::LoadObj(), which handles all of it and
+// reports the errors.
+
+#define OBJLOADER_CHUNK_BYTES (64 * 1024)
+
+// Fills "attrib", "shapes" and "materials" (from the "mtllib" files, looked
+// up in "mtl_basedir") like tinyobj::LoadObj(..., triangulate = true).
+// Warnings (unknown materials, degenerate faces) are appended to "warn".
+// Uses "jobs", or a JobSystem shared by all calls when it is NULL.
+bool ObjLoader_Load(const char* filename, const char* mtl_basedir, tinyobj::attrib_t* attrib,
+                    std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                    std::string* warn, JobSystem* jobs = NULL);
+
+// Parses a decimal number ("-1.25", "3e-2", ".5") at "s", not reading past
+// "end". Returns the character after it, or "s" itself when there is no
+// number there (and then sets "value" to 0).
+const char* ObjLoader_ParseFloat(const char* s, const char* end, float* value);
+
+#endif // _OBJLOADER_HPP
@@ -1,12 +1,40 @@
 //Generic Physics (gravity, projectile motion, etc.)
 
 #pragma once
-#include "utils.h"
+// Sem OpenGL: usado também pelas ferramentas sem janela (bench/)
+#include <vector>
 #include "matrices.hpp"
-#define MIN_LIMIAR 0.001f
+#define MIN_LIMIAR 0.001f // Kinetic energy per unit mass (J/kg) below which a body is at rest
+#define SLEEP_TIME 0.5f   // Seconds at rest before a body falls asleep
 
 extern glm::vec4 g; // Gravitational acceleration vector
 
+// State of one body as seen by the renderer
+struct BodyState {
+    glm::vec4 position;
+    glm::vec4 rotation;
+    glm::vec4 velocity;
+};
+
+// State "alpha" of the way from "previous" to "current" (alpha in [0, 1]).
+// Rotations are pitch/yaw/roll, blended per angle: fine for the small
+// change of one physics step.
+inline BodyState BodyState_Interpolate(const BodyState& previous, const BodyState& current, float alpha) {
+    BodyState state;
+    state.position = previous.position + (current.position - previous.position) * alpha;
+    state.rotation = previous.rotation + (current.rotation - previous.rotation) * alpha;
+    state.velocity = previous.velocity + (current.velocity - previous.velocity) * alpha;
+    return state;
+}
+
+// Sleeping: a body whose linear and angular kinetic energies per unit mass
+// (|v|²/2 and |w|²/2) stay below MIN_LIMIAR for SLEEP_TIME seconds stops
+// moving. update() then only discards the forces of the step, and the
+// BroadPhase neither sweeps nor responds for it, so a course full of balls
+// at rest costs almost nothing. setPosition(), wake() and a nonzero
+// velocity or torque wake it, as does an awake ball touching it; addForce()
+// does not, since gravity and the normal force of the floor are added on
+// every step.
 class RigidBody {
 private:
     float mass;          // Mass of the rigid body
@@ -14,6 +42,7 @@ private:
     float angular_damping = 0.4f; // Damping factor for angular motion
     float linear_damping = 0.4f; // Damping factor for linear motion
     glm::vec4 position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);  // Position in 3D space
+    glm::vec4 previous_position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Position before the last update(), swept by the CCD
     glm::vec4 rotation = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);  // pitch, yaw, roll, w in radians
     glm::vec4 scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);     // Scale factors in 3D space
     glm::vec4 velocity = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);  // Linear velocity
@@ -24,6 +53,9 @@ private:
     glm::vec4 torque = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f); // Torque acting on the body
     glm::vec4 pivot = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Pivot point for rotation
     glm::vec4 center_of_mass = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // Center of mass of the rigid body
+    bool sleeping = false;   // Not integrated until woken
+    bool can_sleep = true;
+    float sleep_timer = 0.0f; // Time at rest so far
     public:
     float deltaTime = 0.0f; // Time step for updates
 
@@ -40,15 +72,15 @@ private:
 
 
     RigidBody(float m, glm::vec4 pos, glm::vec4 rot, glm::vec4 scl)
-        : mass(m), position(pos), rotation(rot), scale(scl) {}
+        : mass(m), position(pos), previous_position(pos), rotation(rot), scale(scl) {}
 
     RigidBody(glm::vec4 pos, glm::vec4 rot, glm::vec4 scl)
-        : mass(1.0f), position(pos), rotation(rot), scale(scl) {}
+        : mass(1.0f), position(pos), previous_position(pos), rotation(rot), scale(scl) {}
 
 
     void update(float dt);
     // Setters for position, rotation, and scale
-    inline void setPosition(glm::vec4 pos) { position = pos; }
+    inline void setPosition(glm::vec4 pos) { position = pos; previous_position = pos; if (sleeping) wake(); } // Teleports: nothing to sweep
     inline void setRotation(glm::vec4 rot) { rotation = rot; }
     inline void setScale(glm::vec4 scl) { scale = scl; }
     inline void setMass(float m) { mass = m; } // Set the mass of the rigid body
@@ -56,6 +88,8 @@ private:
     inline void setAngularDamping(float damping) { angular_damping = damping; } // Set the angular damping factor
     inline void setVelocity (glm::vec4 vel) {
         velocity = vel; // Set the linear velocity
+        if (sleeping && vel != glm::vec4(0.0f))
+            wake();
     }
     inline void setCenterOfMass(glm::vec4 p) { center_of_mass = p; }
     // Apply a force to the rigid body
@@ -70,6 +104,8 @@ private:
     }
     inline void setAngularAcceleration(glm::vec4 acc) {
         angular_acceleration = acc; // Set the angular acceleration
+        if (sleeping && acc != glm::vec4(0.0f))
+            wake();
     }
     inline void resetForce() {
         force = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f); // Reset the force to zero
@@ -92,12 +128,25 @@ private:
     inline void applyTorqueAtPoint(glm::vec4 point, glm::vec4 force_vec) {
         glm::vec4 r = point - pivot; // vetor do centro até o ponto de aplicação
         torque = crossproduct(r, force_vec);
+        if (sleeping && torque != glm::vec4(0.0f))
+            wake();
     }
     inline void applyTorque(glm::vec4 torque_vec) {
         torque += torque_vec; // Add the torque to the current torque
+        if (sleeping && torque_vec != glm::vec4(0.0f))
+            wake();
     }
+    inline void wake() { sleeping = false; sleep_timer = 0.0f; }
+    inline bool isSleeping() const { return sleeping; }
+    // Bodies that must never stop (e.g. driven by hand every frame)
+    inline void setSleepEnabled(bool enabled) { can_sleep = enabled; if (!enabled) wake(); }
     inline float getMass() const { return mass; } // Get the mass of the rigid body
     inline glm::vec4 getPosition() const { return position; } // Get the current position
+    inline glm::vec4 getPreviousPosition() const { return previous_position; } // Start of the motion of the last update()
+    inline BodyState getState() const {
+        BodyState state = { position, rotation, velocity };
+        return state;
+    }
     inline glm::vec4 getRotation() const { return rotation; } // Get the current rotation
     inline glm::vec4 getScale() const { return scale; } // Get the current scale
     inline glm::vec4 getVelocity() const { return velocity; } // Get the current linear velocity
@@ -109,7 +158,7 @@ private:
     inline float getAngularDamping() const { return angular_damping; } // Get the
     inline void setPivot(const glm::vec4& p) { pivot = p; }
     inline glm::vec4 getPivot() const { return pivot; }
-    glm::vec4 ComputeRigidBodyCenter(const struct ObjModel* model);
+    glm::vec4 ComputeRigidBodyCenter(const std::vector<float>& vertices); // Mean of xyz triples (e.g. ObjModel::attrib.vertices)
     glm::vec4 getFuturePosition() const {
         return (getVelocity() * deltaTime);
     }
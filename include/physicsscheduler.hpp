@@ -0,0 +1,46 @@
+//Fixed-step scheduler for the physics loop
+#ifndef _PHYSICSSCHEDULER_HPP
+#define _PHYSICSSCHEDULER_HPP
+
+// Turns the variable frame time into a whole number of fixed physics steps
+// (the "fix your timestep" accumulator). Three guards keep a slow frame from
+// snowballing into slower ones:
+//   - a frame longer than "max_frame_time" (a stall, a dragged window) only
+//     counts as "max_frame_time";
+//   - at most "max_substeps" steps run per frame;
+//   - when that cap is hit, the whole steps left in the accumulator are
+//     dropped instead of carried to the next frame, so the simulation runs
+//     a little slower for that frame and then continues in real time.
+// The time thrown away is reported by getDroppedTime().
+//
+// What is left in the accumulator is less than one step: getAlpha() says how
+// far the frame is between the last two physics states, so the renderer can
+// interpolate them (BodyState_Interpolate) and stay smooth at any refresh
+// rate without running the physics at that rate.
+class PhysicsScheduler {
+public:
+    explicit PhysicsScheduler(float tick_rate = 60.0f, int max_substeps = 4, double max_frame_time = 0.25);
+
+    // Adds the duration of a frame, in seconds, and returns how many steps
+    // of getStepTime() to run for it.
+    int advance(double frame_time);
+
+    void setTickRate(float tick_rate);
+    inline void setMaxSubsteps(int substeps) { max_substeps = substeps > 0 ? substeps : 1; }
+    inline void setMaxFrameTime(double seconds) { max_frame_time = seconds; }
+
+    inline float getTickRate() const { return tick_rate; }
+    inline float getStepTime() const { return step_time; }
+    inline float getAlpha() const { return static_cast<float>(accumulator / step_time); }
+    inline double getDroppedTime() const { return dropped_time; }
+
+private:
+    float tick_rate;
+    float step_time;
+    int max_substeps;
+    double max_frame_time;
+    double accumulator = 0.0;
+    double dropped_time = 0.0;
+};
+
+#endif // _PHYSICSSCHEDULER_HPP
@@ -0,0 +1,60 @@
+//Fixed-step physics on its own thread
+#ifndef _PHYSICSTHREAD_HPP
+#define _PHYSICSTHREAD_HPP
+
+#include "physics.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a fixed-step simulation on a dedicated thread, so the physics rate
+// does not depend on how long glfwSwapBuffers() blocks the render thread.
+//
+// After every step the thread copies the body states into the back buffer
+// and swaps it with the front buffer; the renderer reads the front buffer
+// with read(), so it always sees one whole step, never a half-updated one.
+// Anything else that changes the simulation from another thread (a shot, a
+// reset) must go through post(): the commands run on the physics thread, in
+// order, right before the next step.
+class PhysicsThread {
+public:
+    typedef std::function<void(float)> StepFunction;                        // Advances the simulation by dt
+    typedef std::function<void(std::vector<BodyState>&)> SnapshotFunction; // Copies the body states out
+
+    PhysicsThread() = default;
+    ~PhysicsThread();
+
+    void start(float dt, const StepFunction& step, const SnapshotFunction& snapshot);
+    void stop();
+    inline bool isRunning() const { return running.load(); }
+
+    void post(const std::function<void()>& command);
+
+    // Copies the latest published states into "out" and returns the number
+    // of steps run so far (0 means the states from before the first step).
+    unsigned long long read(std::vector<BodyState>& out) const;
+
+private:
+    PhysicsThread(const PhysicsThread&);
+    PhysicsThread& operator=(const PhysicsThread&);
+
+    void loop();
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    float dt = 1.0f / 60.0f;
+    StepFunction step;
+    SnapshotFunction snapshot;
+
+    std::mutex command_mutex;
+    std::vector<std::function<void()> > commands;
+
+    mutable std::mutex state_mutex;
+    std::vector<BodyState> states[2]; // Front buffer is states[front]
+    int front = 0;
+    unsigned long long tick = 0;
+};
+
+#endif // _PHYSICSTHREAD_HPP
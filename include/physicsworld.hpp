@@ -0,0 +1,91 @@
+//Structure-of-arrays rigid body world, integrated in batches
+#ifndef _PHYSICSWORLD_HPP
+#define _PHYSICSWORLD_HPP
+
+#include "glm/vec4.hpp"
+#include <cstddef>
+#include <vector>
+
+class JobSystem;
+
+// Bodies integrated by each job of a parallel step. A multiple of 8, so every
+// chunk but the last runs entirely on the SIMD path.
+#define PHYSICSWORLD_CHUNK_SIZE 2048
+
+// Many rigid bodies (e.g. simultaneous players or shot previews) integrated
+// together. Each quantity lives in its own contiguous float array, one entry
+// per body, so step() runs the same arithmetic over long runs of memory: the
+// SSE path integrates four bodies per instruction (eight with AVX), and the
+// scalar loop is also easy for the compiler to vectorize.
+//
+// step() applies the integration of RigidBody::update() with the same
+// operation order, so the scalar and SIMD paths agree bit for bit (as long as
+// the compiler does not contract them into FMAs differently, e.g. with
+// -march=native). Only what update() reads or writes is stored; the
+// acceleration is not kept after the step.
+//
+// This header does not depend on OpenGL, so it can be used by headless tools.
+class PhysicsWorld {
+public:
+    PhysicsWorld() = default;
+
+    // Adds a body at rest and returns its index. Indices are stable.
+    int addBody(const glm::vec4& position, float mass, float linear_damping = 0.4f,
+                float angular_damping = 0.4f, float inertia = 0.5f);
+    void reserve(size_t count);
+    void clear();
+    inline size_t size() const { return mass.size(); }
+
+    // Integrates every body by "dt" and clears the accumulated forces and
+    // torques, like RigidBody::update(). With a job system, the bodies are
+    // split in chunks of PHYSICSWORLD_CHUNK_SIZE integrated in parallel; each
+    // body only depends on itself, so the result is the same for any number
+    // of threads.
+    void step(float dt, JobSystem* jobs = NULL);
+
+    inline void addForce(int body, const glm::vec4& f) {
+        fx[body] += f.x; fy[body] += f.y; fz[body] += f.z;
+    }
+    inline void addTorque(int body, const glm::vec4& t) {
+        tx[body] += t.x; ty[body] += t.y; tz[body] += t.z;
+    }
+    // Adds mass * acceleration to the force of every body (e.g. gravity)
+    void addAccelerationToAll(const glm::vec4& acceleration);
+
+    inline glm::vec4 getPosition(int body) const { return glm::vec4(px[body], py[body], pz[body], 1.0f); }
+    inline glm::vec4 getVelocity(int body) const { return glm::vec4(vx[body], vy[body], vz[body], 0.0f); }
+    inline glm::vec4 getRotation(int body) const { return glm::vec4(rx[body], ry[body], rz[body], 0.0f); }
+    inline glm::vec4 getAngularVelocity(int body) const { return glm::vec4(wx[body], wy[body], wz[body], 0.0f); }
+    inline float getMass(int body) const { return mass[body]; }
+
+    inline void setPosition(int body, const glm::vec4& p) { px[body] = p.x; py[body] = p.y; pz[body] = p.z; }
+    inline void setVelocity(int body, const glm::vec4& v) { vx[body] = v.x; vy[body] = v.y; vz[body] = v.z; }
+    inline void setAngularVelocity(int body, const glm::vec4& w) { wx[body] = w.x; wy[body] = w.y; wz[body] = w.z; }
+
+    // Integrates bodies [first, last) only. step() calls it for all of them;
+    // it is exposed so callers can split the world into independent chunks.
+    void stepRange(size_t first, size_t last, float dt);
+
+    // The SIMD path is used when it was compiled in (SSE2 on x86-64, AVX with
+    // -mavx); disabling it is only useful to compare both in benchmarks.
+    inline void setSimdEnabled(bool enabled) { simd_enabled = enabled; }
+    static const char* SimdName();
+
+private:
+    size_t stepRangeSimd(size_t first, size_t last, float dt);
+
+    // Linear state
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> fx, fy, fz;
+    std::vector<float> mass, linear_damping;
+    // Angular state (rotation as pitch/yaw/roll, like RigidBody)
+    std::vector<float> rx, ry, rz;
+    std::vector<float> wx, wy, wz;
+    std::vector<float> tx, ty, tz;
+    std::vector<float> inertia, angular_damping;
+
+    bool simd_enabled = true;
+};
+
+#endif // _PHYSICSWORLD_HPP
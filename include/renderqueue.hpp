@@ -0,0 +1,97 @@
+//Sorted render queue that minimizes OpenGL state changes
+#ifndef _RENDERQUEUE_HPP
+#define _RENDERQUEUE_HPP
+
+#include "glad/glad.h"
+#include "glcontext.hpp"
+#include "shaderprogram.hpp"
+#include "uniformbuffers.hpp"
+#include "bounds.hpp"
+#include <cstdint>
+#include <vector>
+
+// One draw call and the state it needs. Textures always go to unit 0 together
+// with their sampler object, which holds the wrap/filter modes set at load time.
+struct DrawItem {
+    ShaderProgram* program;
+    const SceneObject* object;            // VAO, index range and primitive type (VirtualScene::getObject,
+                                          // valid until objects are added to the scene)
+    GLuint texture = 0;                   // 0 = untextured
+    GLuint sampler = 0;
+    ObjectUniformBuffer* object_uniforms = nullptr; // Model/normal matrices and material
+    bool instanced = false;               // Draw every instance stored in the object
+    int lod = 0;                          // Level of detail of the object (SceneObject_SelectLod)
+    bool blended = false;                 // Alpha blended, drawn after all opaque items
+    bool has_bounds = false;              // If false the item is never culled
+    AABB bounds;                          // World space bounds (of all instances, if instanced)
+    BoundingSphere sphere;                // World space sphere around "bounds"
+    uint64_t key = 0;                     // Filled by RenderQueue::submit()
+};
+
+// Work done by one RenderQueue::flush(). Every counter is a call that actually
+// reached OpenGL; redundant ones are skipped and not counted.
+struct RenderStats {
+    unsigned int draw_calls = 0;
+    unsigned int program_binds = 0;      // glUseProgram
+    unsigned int vao_binds = 0;          // glBindVertexArray
+    unsigned int texture_binds = 0;      // glBindTexture + glBindSampler
+    unsigned int buffer_binds = 0;       // glBindBufferBase of ObjectData
+    unsigned int blend_changes = 0;      // glEnable/glDisable(GL_BLEND)
+    unsigned int uniform_uploads = 0;    // glUniform* issued by ShaderProgram::set
+    unsigned int culled = 0;             // Items outside the view frustum, not drawn
+    unsigned int triangles = 0;          // Drawn, all instances and levels of detail included
+
+    inline unsigned int stateChanges() const {
+        return program_binds + vao_binds + texture_binds + buffer_binds + blend_changes + uniform_uploads;
+    }
+};
+
+// Collects the draws of a frame and issues them sorted by a 64-bit state key,
+// so each program, texture and VAO is bound once per run of items sharing it
+// instead of once per draw. Key layout, most significant field first:
+//
+//   [63]     pass      0 = opaque, 1 = blended
+//   [62..52] program   GL name of the program (11 bits)
+//   [51..36] texture   GL name of the texture (16 bits, 0 = none)
+//   [35..20] vao       GL name of the VAO (16 bits)
+//   [19..0]  sequence  submission order, keeps the sort stable
+//
+// Texture changes cost more than VAO changes in most drivers, hence the order.
+// Blended items are only sorted by state too, which is fine while they do not
+// overlap each other (the clouds).
+class RenderQueue {
+public:
+    RenderQueue() = default;
+
+    inline void clear() { items.clear(); culled = 0; }
+    // Items with bounds outside the frustum are dropped here. Returns false
+    // for those.
+    bool submit(const DrawItem& item);
+
+    // Frustum used to cull the next submitted items, usually
+    // Camera::getFrustum() once per frame.
+    inline void setFrustum(const Frustum& f) { frustum = f; culling = true; }
+    inline void disableCulling() { culling = false; }
+    // Sorts and draws every submitted item, then clears the queue. Leaves
+    // blending disabled and no VAO bound.
+    void flush();
+
+    // Counters of the last flush()
+    inline const RenderStats& getStats() const { return stats; }
+    inline size_t size() const { return items.size(); }
+
+    static uint64_t MakeKey(const DrawItem& item, uint32_t sequence);
+
+private:
+    std::vector<DrawItem> items;
+    RenderStats stats;
+    Frustum frustum;
+    bool culling = false;
+    unsigned int culled = 0;   // Since the last flush()
+    UniformSlot render_as_black_uniform{"render_as_black"};
+    UniformSlot use_instancing_uniform{"use_instancing"};
+    UniformSlot use_texture_uniform{"use_texture"};
+    UniformSlot texture_diffuse_uniform{"texture_diffuse"};
+};
+
+#endif // _RENDERQUEUE_HPP
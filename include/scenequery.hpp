@@ -0,0 +1,108 @@
+//Ray and segment casts against the static scene
+#ifndef _SCENEQUERY_HPP
+#define _SCENEQUERY_HPP
+
+#include "collisions.hpp"
+#include <cstddef>
+#include <vector>
+
+class JobSystem;
+
+// Ray origin + t * direction, for 0 <= t <= max_t. With direction = to - from
+// and max_t = 1 it is the segment from "from" to "to".
+struct SceneRay {
+    glm::vec4 origin;    // w = 1
+    glm::vec4 direction; // w = 0, any length
+    float max_t;
+};
+
+struct SceneHit {
+    float t;          // In units of the ray direction
+    glm::vec4 point;  // w = 1
+    glm::vec4 normal; // Unit, w = 0, against the direction of the ray
+    int object;       // Id returned by SceneQuery::add*()
+    int triangle;     // Triangle of a mesh (MeshHit::triangle), -1 for other shapes
+};
+
+// Single-shape casts, also used by SceneQuery. Return true and fill "hit"
+// (except "object") for the first hit with 0 <= t <= max_t, from either side.
+// The plane is infinite like in Collision_SphereToPlane; the cylinder is
+// closed by its caps (unlike Collision_SphereToCylinder, infinite along Y,
+// a ray has to stop somewhere). Boxes and meshes may scale.
+bool Raycast_Plane(const SceneRay& ray, const CollisionPlane& plane, SceneHit* hit);
+bool Raycast_Box(const SceneRay& ray, const CollisionBox& box, SceneHit* hit);
+bool Raycast_Cylinder(const SceneRay& ray, const CollisionCylinder& cylinder, SceneHit* hit);
+bool Raycast_Sphere(const SceneRay& ray, const CollisionSphere& sphere, SceneHit* hit);
+bool Raycast_Mesh(const SceneRay& ray, const CollisionMesh& mesh, SceneHit* hit);
+
+// The collidable objects of the course, for queries that are not physics:
+// aiming and trajectory prediction, mouse picking, camera occlusion. The
+// shapes are the ones registered in the BroadPhase (Plane::getCollisionPlane(),
+// Mesh::getCollisionMesh(), ...), and the ids returned by add*() identify
+// the hit object, in registration order like BroadPhase ids.
+//
+// The objects are static: after each add*() the bounded ones are arranged in
+// a BVH of their world boxes (median split on the longest axis; there are
+// few objects, each mesh has its own MeshBVH below it). A cast visits the
+// nodes nearest first and skips those the ray enters after the best hit so
+// far; infinite planes are tested one by one. Casts only read the scene, so
+// any number of threads can cast at the same time, and castRays() splits a
+// batch across a JobSystem.
+class SceneQuery {
+public:
+    SceneQuery() = default;
+
+    int addPlane(const CollisionPlane& plane);
+    int addBox(const CollisionBox& box);
+    int addCylinder(const CollisionCylinder& cylinder);
+    int addSphere(const CollisionSphere& sphere);
+    // The BVH is not copied: it must outlive the scene
+    int addMesh(const CollisionMesh& mesh);
+
+    // First object hit by the ray
+    bool raycast(const SceneRay& ray, SceneHit* hit) const;
+    // First object hit between two points
+    bool segmentCast(const glm::vec4& from, const glm::vec4& to, SceneHit* hit) const;
+    // Whether anything is hit at all; stops at the first hit found, so it is
+    // cheaper than raycast() for visibility tests
+    bool anyHit(const SceneRay& ray) const;
+    // raycast() of "count" rays; hits[i].object is -1 when ray i hits nothing
+    void castRays(const SceneRay* rays, size_t count, SceneHit* hits, JobSystem* jobs = NULL) const;
+
+    // Path p0 + v0 t + a t²/2 for t in [0, max_time], cast as "segments"
+    // straight pieces. Returns the first hit and, in "time", when it happens.
+    bool castParabola(const glm::vec4& p0, const glm::vec4& v0, const glm::vec4& a, float max_time, int segments,
+                      SceneHit* hit, float* time) const;
+
+    inline size_t size() const { return objects.size(); }
+
+private:
+    struct Object {
+        ColliderShape shape;
+        CollisionPlane plane;
+        CollisionBox box;
+        CollisionCylinder cylinder;
+        CollisionSphere sphere;
+        CollisionMesh mesh;
+        AABB bounds;
+    };
+    // Leaf when count > 0, with the objects bounded[first, first + count).
+    // Otherwise the children are the next node and node "first".
+    struct Node {
+        AABB bounds;
+        int first;
+        int count;
+    };
+
+    int add(const Object& object);
+    void build();
+    bool castObject(int id, const SceneRay& ray, SceneHit* hit) const;
+    bool cast(const SceneRay& ray, SceneHit* hit, bool any) const;
+
+    std::vector<Object> objects;
+    std::vector<int> bounded;   // Ids of the finite objects, in leaf order
+    std::vector<int> unbounded; // Ids of the infinite ones (planes)
+    std::vector<Node> nodes;
+};
+
+#endif // _SCENEQUERY_HPP
@@ -0,0 +1,93 @@
+#ifndef _SHADERPROGRAM_HPP
+#define _SHADERPROGRAM_HPP
+
+#include "glad/glad.h"
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+#include <string>
+#include <vector>
+
+// Wrapper around a linked GPU program. All active uniforms are reflected once
+// (glGetActiveUniform) into a small table; afterwards each uniform is
+// addressed by an integer handle instead of a name, and the typed setters
+// skip the glUniform* call when the value did not change since the last
+// upload.
+//
+// The cached values assume that every upload to this program goes through
+// these setters, and the setters assume the program is the one in use
+// (glUseProgram), as glUniform* always writes to the current program.
+class ShaderProgram {
+public:
+    ShaderProgram() = default;
+    explicit ShaderProgram(GLuint program_id) { reflect(program_id); }
+
+    // (Re)builds the uniform table. Must be called again after relinking.
+    void reflect(GLuint program_id);
+
+    inline GLuint id() const { return program_id; }
+    inline void use() const { glUseProgram(program_id); }
+    // Incremented by each reflect(), so cached handles can detect a relink
+    inline unsigned int getGeneration() const { return generation; }
+    // Number of glUniform* calls issued so far (skipped redundant ones excluded)
+    inline unsigned int getUploadCount() const { return upload_count; }
+
+    // Handle of an active uniform, or -1 if the program does not use it (the
+    // GLSL compiler removes unused uniforms). Setters ignore handle -1, just
+    // like glUniform* ignores location -1. Not meant for the render loop:
+    // resolve handles once and keep them.
+    int uniform(const char* name) const;
+
+    void set(int handle, bool value);
+    void set(int handle, GLint value);
+    void set(int handle, GLfloat value);
+    void set(int handle, const glm::vec4& value);
+    void set(int handle, const glm::mat4& value);
+
+    // Forgets the cached values, e.g. after another program changed them
+    void invalidate();
+
+    // Assigns a binding point to a uniform block (GLSL 3.30 has no
+    // layout(binding = N)). Returns false if the program has no such block.
+    bool bindUniformBlock(const char* block_name, GLuint binding);
+
+private:
+    struct Uniform {
+        std::string name;    // Without the "[0]" suffix of arrays
+        GLint location;
+        GLenum type;
+        GLint size;          // Array size (1 for non-arrays)
+        bool cached;         // "value" holds the last upload
+        unsigned char value[sizeof(glm::mat4)];
+    };
+
+    // Returns true (and updates the cache) if "bytes" differs from the last upload
+    bool changed(int handle, const void* bytes, size_t length);
+
+    GLuint program_id = 0;
+    unsigned int generation = 0;
+    unsigned int upload_count = 0;
+    std::vector<Uniform> uniforms; // Sorted by name
+};
+
+// Uniform handle resolved lazily, for classes that draw with whatever program
+// they are given: the name lookup runs on the first use with each program
+// (or after it is relinked) instead of on every draw.
+class UniformSlot {
+public:
+    explicit UniformSlot(const char* name) : name(name) {}
+    inline int get(const ShaderProgram& program) {
+        if (&program != resolved_program || program.getGeneration() != resolved_generation) {
+            handle = program.uniform(name);
+            resolved_program = &program;
+            resolved_generation = program.getGeneration();
+        }
+        return handle;
+    }
+private:
+    const char* name;
+    const ShaderProgram* resolved_program = nullptr;
+    unsigned int resolved_generation = 0;
+    int handle = -1;
+};
+
+#endif // _SHADERPROGRAM_HPP
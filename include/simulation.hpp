@@ -0,0 +1,79 @@
+//Headless golf course simulation
+#ifndef _SIMULATION_HPP
+#define _SIMULATION_HPP
+
+#include "collisions.hpp"
+#include "physics.hpp"
+#include <cstddef>
+#include <deque>
+
+class JobSystem;
+
+// Dimensions of the course: floor at y = 0, four walls, the void zone below
+// the floor and the hole. main() places its meshes with them, and its broad
+// phase and GolfSimulation's both come from GolfCourse_AddColliders(), so
+// the headless tools simulate the course the game draws.
+#define COURSE_WALL_DISTANCE 40.0f        // wall_width * 4
+#define COURSE_WALL_Y (-0.5f)             // -wall_height / 4
+#define COURSE_VOID_ZONE_Y (-30.0f)
+#define COURSE_VOID_ZONE_HALF_SIZE glm::vec3(250.0f, 5.0f, 250.0f)
+#define COURSE_HOLE_CENTER glm::vec4(10.0f, -1.49f, 0.0f, 1.0f)
+#define COURSE_HOLE_RADIUS 0.6f
+#define COURSE_HOLE_HEIGHT 1.5f
+#define COURSE_BALL_RADIUS 0.02f
+#define COURSE_BALL_MASS 0.2f
+
+// Registers the static colliders of the course, in the order their pairs are
+// resolved: floor, walls (north, south, east, west), void zone, hole
+void GolfCourse_AddColliders(BroadPhase& broad_phase);
+// The hole registered by GolfCourse_AddColliders()
+CollisionCylinder GolfCourse_GetHole();
+
+// The physics of the game without a window: balls on the course of main(),
+// integrated with RigidBody::update() and collided with the same broad phase
+// and responses. Only uses GL-free code, so it runs in tests, benchmarks
+// and on machines with no display.
+//
+// Gravity is added on every physics step, like in main() and in
+// TrajectoryPredictor, so the result does not depend on a frame rate.
+class GolfSimulation {
+public:
+    GolfSimulation();
+
+    // Adds a ball at rest and returns its index
+    int addBall(const glm::vec4& position);
+    inline size_t getBallCount() const { return bodies.size(); }
+
+    // Hits a ball, like the shot of main(): sets its velocity and leaves the ground
+    void shoot(int ball, const glm::vec4& velocity);
+
+    // One physics step: gravity, integration, then collisions
+    void step(float dt, JobSystem* jobs = NULL);
+    // The two halves of step(), separate so they can be timed
+    void integrate(float dt, JobSystem* jobs = NULL);
+    void collide(JobSystem* jobs = NULL);
+
+    inline const RigidBody& getBody(int ball) const { return bodies[ball]; }
+    inline bool isGrounded(int ball) const { return grounded[ball]; }
+    inline bool isSleeping(int ball) const { return bodies[ball].isSleeping(); }
+    // RigidBody::setSleepEnabled() of every ball, now and added later
+    void setSleepEnabled(bool enabled);
+    // Below the floor, inside the radius of the hole
+    bool isInHole(int ball) const;
+    // Candidate pairs handed to the narrow phase by the last collide()
+    inline size_t getPairCount() const { return broad_phase.getPairs().size(); }
+    // The course and the balls, e.g. for BroadPhase::addStatics()
+    inline const BroadPhase& getBroadPhase() const { return broad_phase; }
+
+private:
+    GolfSimulation(const GolfSimulation&);
+    GolfSimulation& operator=(const GolfSimulation&);
+
+    std::deque<RigidBody> bodies; // deque: the broad phase keeps pointers to them
+    std::deque<bool> grounded;
+    bool sleep_enabled = true;
+    BroadPhase broad_phase;
+    CollisionCylinder hole;
+};
+
+#endif // _SIMULATION_HPP
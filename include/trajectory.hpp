@@ -0,0 +1,41 @@
+//Trajectory prediction with the physics step
+#ifndef _TRAJECTORY_HPP
+#define _TRAJECTORY_HPP
+
+#include "collisions.hpp"
+#include "physics.hpp"
+#include <vector>
+
+// Steps of the aim preview: 3 s at 60 Hz
+#define TRAJECTORY_PREVIEW_STEPS 180
+
+// Predicts where a shot goes by running the same physics step as the game
+// (gravity, RigidBody::update(), then the broad phase with its sweeps and
+// responses) on a copy of the ball, so the prediction follows the real ball
+// step for step: it bounces off the walls, drops through the floor over the
+// hole (no sweep holds it up there) and slows down with the damping. The
+// copy is a plain RigidBody: nothing of the game is touched.
+//
+// The colliders are copied from the broad phase of the game
+// (BroadPhase::addStatics()) and must be added again if they move.
+class TrajectoryPredictor {
+public:
+    explicit TrajectoryPredictor(float radius);
+
+    inline BroadPhase& getBroadPhase() { return broad_phase; }
+
+    // Positions of "start" (included) and after each of at most "steps"
+    // steps of "dt". Stops early when the ball is respawned by a kill zone
+    // (the respawn position is left out) or comes to rest (slow on two steps
+    // in a row). Returns the number of points.
+    size_t predict(const RigidBody& start, float dt, int steps, std::vector<glm::vec4>& points);
+
+private:
+    TrajectoryPredictor(const TrajectoryPredictor&);
+    TrajectoryPredictor& operator=(const TrajectoryPredictor&);
+
+    RigidBody body;         // The copy; the broad phase points to it
+    BroadPhase broad_phase;
+};
+
+#endif // _TRAJECTORY_HPP
@@ -0,0 +1,80 @@
+//Uniform buffer objects shared by the shaders
+#ifndef _UNIFORMBUFFERS_HPP
+#define _UNIFORMBUFFERS_HPP
+
+#include "glad/glad.h"
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+#include "glm/gtc/type_precision.hpp"
+
+// Binding points of the uniform blocks declared in shader_vertex.glsl and
+// shader_fragment.glsl. GLSL 3.30 cannot declare them in the shader, so they
+// are assigned with ShaderProgram::bindUniformBlock() after linking.
+#define FRAME_UNIFORM_BINDING  0
+#define OBJECT_UNIFORM_BINDING 1
+
+// Per-frame data, uploaded once per frame. Same layout as the std140 block
+// "FrameData" in the shaders (only mat4/vec4 members, so no padding).
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec4 camera_position;  // World space, w = 1
+    glm::vec4 light_direction;  // World space, normalized, towards the light
+};
+
+// Per-object data. Same layout as the std140 block "ObjectData". The normal
+// matrix is inverse(transpose(model)), computed on the CPU once per change of
+// the model matrix instead of once per vertex.
+struct ObjectUniforms {
+    glm::mat4 model;
+    glm::mat4 normal_matrix;
+    glm::ivec4 material;        // x = index into the MaterialTable, yzw unused
+};
+
+// The UBO holding FrameUniforms. Bound to FRAME_UNIFORM_BINDING on upload.
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer() = default;
+    ~FrameUniformBuffer();
+
+    inline void setLightDirection(const glm::vec4& direction) { data.light_direction = direction; }
+    void setCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& camera_position);
+    void upload();
+    inline const FrameUniforms& getData() const { return data; }
+
+private:
+    FrameUniformBuffer(const FrameUniformBuffer&);
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&);
+
+    FrameUniforms data = FrameUniforms();
+    GLuint ubo = 0;
+};
+
+// Small UBO owned by each drawable object. The model matrix is only
+// re-uploaded when it changes, so static objects cost a single
+// glBindBufferBase per draw.
+class ObjectUniformBuffer {
+public:
+    ObjectUniformBuffer() = default;
+    ~ObjectUniformBuffer();
+
+    // Stores a new model matrix and precomputes its normal matrix. No-op if
+    // the matrix did not change.
+    void setModel(const glm::mat4& model);
+    // Index of the material used to shade the object (see MaterialTable)
+    void setMaterial(int material_index);
+    // Uploads pending changes and binds the UBO to OBJECT_UNIFORM_BINDING
+    void bind();
+    inline const ObjectUniforms& getData() const { return data; }
+
+private:
+    ObjectUniformBuffer(const ObjectUniformBuffer&);
+    ObjectUniformBuffer& operator=(const ObjectUniformBuffer&);
+
+    ObjectUniforms data = ObjectUniforms();
+    GLuint ubo = 0;
+    bool dirty = true;
+};
+
+#endif // _UNIFORMBUFFERS_HPP
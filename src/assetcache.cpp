@@ -0,0 +1,383 @@
+//Shared meshes and textures
+#include "../include/assetcache.hpp"
+#include "../include/assetloader.hpp"
+#include "../include/geometrics.hpp"
+#include "../include/matrices.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <vector>
+
+AssetCache g_AssetCache;
+
+TextureAsset::~TextureAsset() {
+    glDeleteTextures(1, &texture_id);
+}
+
+SamplerAsset::~SamplerAsset() {
+    glDeleteSamplers(1, &sampler_id);
+}
+
+bool AssetCache::ModelKey::operator<(const ModelKey& other) const {
+    if (path != other.path)
+        return path < other.path;
+    if (scale.x != other.scale.x)
+        return scale.x < other.scale.x;
+    if (scale.y != other.scale.y)
+        return scale.y < other.scale.y;
+    return scale.z < other.scale.z;
+}
+
+// Normais suaves por vértice: a média das normais dos triângulos que usam o
+// vértice (o modelo é carregado triangulado). O índice da normal de cada
+// canto passa a ser o do vértice.
+static void ComputeSmoothNormals(ObjModel* model) {
+    size_t num_vertices = model->attrib.vertices.size() / 3;
+
+    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
+    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
+        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+
+        for (size_t triangle = 0; triangle < num_triangles; ++triangle) {
+            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+
+            glm::vec4  vertices[3];
+            for (size_t vertex = 0; vertex < 3; ++vertex) {
+                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
+                const float vx = model->attrib.vertices[3 * idx.vertex_index + 0];
+                const float vy = model->attrib.vertices[3 * idx.vertex_index + 1];
+                const float vz = model->attrib.vertices[3 * idx.vertex_index + 2];
+                vertices[vertex] = glm::vec4(vx, vy, vz, 1.0);
+            }
+
+            const glm::vec4  a = vertices[0];
+            const glm::vec4  b = vertices[1];
+            const glm::vec4  c = vertices[2];
+
+            const glm::vec4  n = normalize(crossproduct((b - a), (c - a)));
+
+            for (size_t vertex = 0; vertex < 3; ++vertex) {
+                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
+                num_triangles_per_vertex[idx.vertex_index] += 1;
+                vertex_normals[idx.vertex_index] += n;
+                model->shapes[shape].mesh.indices[3 * triangle + vertex].normal_index = idx.vertex_index;
+            }
+        }
+    }
+
+    model->attrib.normals.resize(3 * num_vertices);
+
+    for (size_t i = 0; i < vertex_normals.size(); ++i) {
+        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
+        n /= norm(n);
+        model->attrib.normals[3 * i + 0] = n.x;
+        model->attrib.normals[3 * i + 1] = n.y;
+        model->attrib.normals[3 * i + 2] = n.z;
+    }
+}
+
+static ModelHandle ImportModel(const std::string& path) {
+    ObjModel* imported = new ObjModel(path.c_str());
+    ComputeSmoothNormals(imported);
+    return ModelHandle(imported);
+}
+
+ModelHandle AssetCache::acquireModel(const std::string& path, const glm::vec3& scale) {
+    ModelKey key = { path, scale };
+    std::weak_ptr<const ObjModel>& entry = models[key];
+    ModelHandle model = entry.lock();
+    if (model) {
+        stats.model_hits += 1;
+        return model;
+    }
+
+    ObjModel* imported;
+    if (scale == glm::vec3(1.0f)) {
+        std::map<std::string, std::shared_future<ModelHandle> >::iterator prefetched = prefetched_models.find(path);
+        if (prefetched != prefetched_models.end()) {
+            std::shared_future<ModelHandle> future = prefetched->second;
+            prefetched_models.erase(prefetched);
+            model = future.get(); // Relança a exceção do ObjModel, se houve
+            stats.model_prefetches += 1;
+        } else {
+            model = ImportModel(path);
+        }
+        stats.model_loads += 1;
+    } else {
+        // Cópia do modelo em escala 1, que fica vivo enquanto esta existir
+        ModelHandle source = acquireModel(path);
+        imported = new ObjModel(*source);
+        std::vector<tinyobj::real_t>& verts = imported->attrib.vertices;
+        for (size_t i = 0; i + 2 < verts.size(); i += 3) {
+            verts[i + 0] *= scale.x;
+            verts[i + 1] *= scale.y;
+            verts[i + 2] *= scale.z;
+        }
+        if (scale.x != scale.y || scale.y != scale.z)
+            ComputeSmoothNormals(imported);
+        // O deleter é guardado até a última weak_ptr sumir: solta "source" já
+        // ao apagar a cópia, não quando a chave for podada
+        model = ModelHandle(imported, [source](const ObjModel* m) mutable { delete m; source.reset(); });
+        stats.model_imports += 1;
+    }
+    entry = model; // Referências a elementos de std::map sobrevivem a inserções
+    return model;
+}
+
+void AssetCache::prefetchModel(const std::string& path, AssetLoader& loader) {
+    ModelKey key = { path, glm::vec3(1.0f) };
+    std::map<ModelKey, std::weak_ptr<const ObjModel> >::iterator loaded = models.find(key);
+    if ((loaded != models.end() && !loaded->second.expired()) || prefetched_models.count(path) != 0)
+        return;
+
+    std::shared_ptr<std::promise<ModelHandle> > promise(new std::promise<ModelHandle>());
+    prefetched_models[path] = promise->get_future().share();
+    loader.submit([path, promise]() {
+        try {
+            promise->set_value(ImportModel(path));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+}
+
+// Imagem RGB decodificada pelo stb_image (o nível 0, liberado com ele) e,
+// quando carregada por um AssetLoader, os demais níveis de mipmap
+struct DecodedImage {
+    unsigned char* data = NULL;
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<unsigned char> > mipmaps; // Níveis 1, 2, ... até 1x1
+    ~DecodedImage() { stbi_image_free(data); }
+
+    inline int levelCount() const { return 1 + static_cast<int>(mipmaps.size()); }
+    inline int levelWidth(int level) const { return std::max(1, width >> level); }
+    inline int levelHeight(int level) const { return std::max(1, height >> level); }
+    inline const unsigned char* levelData(int level) const { return level == 0 ? data : &mipmaps[level - 1][0]; }
+};
+
+// Roda em qualquer thread: stbi_set_flip_vertically_on_load() é global no
+// stb_image, então quem chama já deve ter ligado a inversão. Não encerra o
+// programa se a leitura falhar; quem chama decide (ver ReportImageError).
+static bool DecodeImage(const std::string& path, DecodedImage* image) {
+    int channels;
+    image->data = stbi_load(path.c_str(), &image->width, &image->height, &channels, 3);
+    if (image->data == NULL)
+        return false;
+
+    printf("Carregando imagem \"%s\"... OK (%dx%d).\n", path.c_str(), image->width, image->height);
+    return true;
+}
+
+static void ReportImageError(const std::string& path) {
+    fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", path.c_str());
+}
+
+// Conversões sRGB <-> linear por tabela: 256 entradas para ida, 4096 para a
+// volta (precisão de sobra para 8 bits)
+struct SrgbTables {
+    float to_linear[256];
+    unsigned char to_srgb[4096];
+    SrgbTables() {
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            to_linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; ++i) {
+            float l = i / 4095.0f;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            to_srgb[i] = static_cast<unsigned char>(std::min(255.0f, c * 255.0f + 0.5f));
+        }
+    }
+};
+
+// Cadeia de mipmaps feita no worker, para que o glGenerateMipmap() (que em
+// alguns drivers roda na CPU e leva dezenas de ms numa imagem 2k) não caia
+// na thread do GL. Cada texel é a média de 2x2 texels do nível anterior em
+// espaço linear, como o glGenerateMipmap() faz com texturas GL_SRGB8.
+static void BuildMipmaps(DecodedImage* image) {
+    static const SrgbTables tables;
+    int levels = 1;
+    while (image->levelWidth(levels - 1) > 1 || image->levelHeight(levels - 1) > 1)
+        ++levels;
+    image->mipmaps.reserve(levels - 1);
+
+    for (int level = 1; level < levels; ++level) {
+        const unsigned char* src = image->levelData(level - 1);
+        const int sw = image->levelWidth(level - 1);
+        const int sh = image->levelHeight(level - 1);
+        const int dw = image->levelWidth(level);
+        const int dh = image->levelHeight(level);
+        std::vector<unsigned char> dst(3 * static_cast<size_t>(dw) * dh);
+        for (int y = 0; y < dh; ++y) {
+            const unsigned char* row0 = src + 3 * static_cast<size_t>(std::min(2 * y, sh - 1)) * sw;
+            const unsigned char* row1 = src + 3 * static_cast<size_t>(std::min(2 * y + 1, sh - 1)) * sw;
+            for (int x = 0; x < dw; ++x) {
+                const int x0 = 3 * std::min(2 * x, sw - 1);
+                const int x1 = 3 * std::min(2 * x + 1, sw - 1);
+                for (int c = 0; c < 3; ++c) {
+                    float sum = tables.to_linear[row0[x0 + c]] + tables.to_linear[row0[x1 + c]]
+                              + tables.to_linear[row1[x0 + c]] + tables.to_linear[row1[x1 + c]];
+                    dst[3 * (static_cast<size_t>(y) * dw + x) + c] = tables.to_srgb[static_cast<int>(sum * (4095.0f / 4.0f) + 0.5f)];
+                }
+            }
+        }
+        image->mipmaps.push_back(std::vector<unsigned char>());
+        image->mipmaps.back().swap(dst);
+    }
+}
+
+// Liga "texture" na unidade 0 para um envio: o RenderQueue liga a textura
+// de cada desenho nela de qualquer forma
+static void BindTextureForUpload(GLuint texture) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+// Job do AssetLoader: decodifica a imagem, monta os mipmaps e envia cada
+// nível em faixas de linhas para uma textura nova, que substitui a
+// provisória de "target" no último envio
+static void LoadTextureJob(const std::string& path, std::weak_ptr<TextureAsset> target, AssetLoader* loader) {
+    std::shared_ptr<DecodedImage> image(new DecodedImage());
+    if (!DecodeImage(path, image.get())) {
+        // Avisa pela thread do GL, como os outros envios; a textura fica
+        // com o cinza provisório em vez de derrubar o jogo de um worker
+        loader->queueUpload(std::bind(ReportImageError, path));
+        return;
+    }
+    BuildMipmaps(image.get());
+
+    std::shared_ptr<GLuint> staging(new GLuint(0));
+    for (int level = 0; level < image->levelCount(); ++level) {
+        const int width = image->levelWidth(level);
+        const int height = image->levelHeight(level);
+        const size_t row_bytes = 3 * static_cast<size_t>(width);
+        const int stripe_rows = static_cast<int>(std::max<size_t>(1, ASSETCACHE_TEXTURE_STRIPE_BYTES / row_bytes));
+        for (int first_row = 0; first_row < height; first_row += stripe_rows) {
+            int rows = std::min(stripe_rows, height - first_row);
+            loader->queueUpload([image, staging, level, width, first_row, rows, row_bytes]() {
+                if (*staging == 0) {
+                    // Todos os níveis alocados no primeiro envio
+                    glGenTextures(1, staging.get());
+                    BindTextureForUpload(*staging);
+                    for (int l = 0; l < image->levelCount(); ++l)
+                        glTexImage2D(GL_TEXTURE_2D, l, GL_SRGB8, image->levelWidth(l), image->levelHeight(l), 0,
+                                     GL_RGB, GL_UNSIGNED_BYTE, NULL);
+                } else {
+                    BindTextureForUpload(*staging);
+                }
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, first_row, width, rows, GL_RGB, GL_UNSIGNED_BYTE,
+                                image->levelData(level) + first_row * row_bytes);
+            });
+        }
+    }
+    loader->queueUpload([image, staging, target]() {
+        std::shared_ptr<TextureAsset> asset = target.lock();
+        if (!asset) {
+            glDeleteTextures(1, staging.get()); // Ninguém mais usa a textura
+            return;
+        }
+        glDeleteTextures(1, &asset->texture_id);
+        asset->texture_id = *staging;
+        asset->width = image->width;
+        asset->height = image->height;
+        asset->loaded = true;
+    });
+}
+
+TextureHandle AssetCache::acquireTexture(const std::string& path, AssetLoader* loader) {
+    std::weak_ptr<const TextureAsset>& entry = textures[path];
+    TextureHandle texture = entry.lock();
+    if (texture) {
+        stats.texture_hits += 1;
+        return texture;
+    }
+
+    std::shared_ptr<TextureAsset> asset(new TextureAsset());
+    glGenTextures(1, &asset->texture_id);
+    BindTextureForUpload(asset->texture_id);
+    stbi_set_flip_vertically_on_load(true);
+
+    if (loader != NULL) {
+        // Um texel cinza (1x1 já é uma cadeia de mipmaps completa) até a
+        // imagem chegar
+        static const unsigned char grey[3] = { 128, 128, 128 };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+        asset->width = 1;
+        asset->height = 1;
+        loader->submit(std::bind(LoadTextureJob, path, std::weak_ptr<TextureAsset>(asset), loader));
+    } else {
+        // Primeiro fazemos a leitura da imagem do disco, depois a enviamos para a GPU
+        DecodedImage image;
+        if (!DecodeImage(path, &image)) {
+            ReportImageError(path);
+            std::exit(EXIT_FAILURE);
+        }
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        asset->width = image.width;
+        asset->height = image.height;
+        asset->loaded = true;
+    }
+
+    g_NumLoadedTextures += 1;
+    stats.texture_loads += 1;
+    texture = asset;
+    entry = texture;
+    return texture;
+}
+
+SamplerHandle AssetCache::acquireSampler(GLenum wrap) {
+    std::weak_ptr<const SamplerAsset>& entry = samplers[wrap];
+    SamplerHandle sampler = entry.lock();
+    if (sampler) {
+        stats.sampler_hits += 1;
+        return sampler;
+    }
+
+    SamplerAsset* asset = new SamplerAsset();
+    asset->wrap = wrap;
+    glGenSamplers(1, &asset->sampler_id);
+
+    // Veja slides 95-96 do documento Aula_20_Mapeamento_de_Texturas.pdf
+    glSamplerParameteri(asset->sampler_id, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(asset->sampler_id, GL_TEXTURE_WRAP_T, wrap);
+
+    // Parâmetros de amostragem da textura.
+    glSamplerParameteri(asset->sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(asset->sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stats.sampler_creates += 1;
+    sampler = SamplerHandle(asset);
+    entry = sampler;
+    return sampler;
+}
+
+template <typename Map>
+static size_t PruneExpired(Map& map) {
+    size_t pruned = 0;
+    for (typename Map::iterator it = map.begin(); it != map.end();) {
+        if (it->second.expired()) {
+            it = map.erase(it);
+            ++pruned;
+        } else {
+            ++it;
+        }
+    }
+    return pruned;
+}
+
+size_t AssetCache::prune() {
+    return PruneExpired(models) + PruneExpired(textures) + PruneExpired(samplers);
+}
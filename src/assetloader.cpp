@@ -0,0 +1,137 @@
+//Background loading of assets
+#include "../include/assetloader.hpp"
+#include <algorithm>
+#include <chrono>
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+}
+
+AssetLoader::AssetLoader(unsigned threads, size_t upload_capacity)
+    : gl_thread(std::this_thread::get_id()), upload_capacity(std::max<size_t>(1, upload_capacity)) {
+    if (threads == 0) {
+        unsigned cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    for (unsigned i = 0; i < threads; ++i)
+        workers.push_back(std::thread(&AssetLoader::workerLoop, this));
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        jobs.clear();
+    }
+    job_ready.notify_all();
+    upload_room.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
+
+void AssetLoader::submit(const std::function<void()>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    job_ready.notify_one();
+}
+
+void AssetLoader::queueUpload(const std::function<void()>& upload) {
+    if (std::this_thread::get_id() == gl_thread) {
+        std::function<void()> now = upload;
+        runUpload(now);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (uploads.size() >= upload_capacity) {
+            stats.full_waits += 1;
+            upload_room.wait(lock, [this]() { return quit || uploads.size() < upload_capacity; });
+        }
+        if (quit)
+            return; // Ninguém mais vai rodar uploads
+        uploads.push_back(upload);
+    }
+    upload_ready.notify_all();
+}
+
+void AssetLoader::runUpload(std::function<void()>& upload) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    upload();
+    double ms = ElapsedMs(start);
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.uploads += 1;
+    stats.upload_ms += ms;
+}
+
+size_t AssetLoader::processUploads(double budget_ms) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    for (;;) {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploads.empty())
+                break;
+            upload.swap(uploads.front());
+            uploads.pop_front();
+        }
+        upload_room.notify_one();
+        runUpload(upload);
+        ++count;
+        if (ElapsedMs(start) >= budget_ms)
+            break;
+    }
+    if (count > 0) {
+        double ms = ElapsedMs(start);
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.max_frame_upload_ms = std::max(stats.max_frame_upload_ms, ms);
+    }
+    return count;
+}
+
+void AssetLoader::finish() {
+    for (;;) {
+        processUploads(1e30);
+        std::unique_lock<std::mutex> lock(mutex);
+        if (jobs.empty() && running_jobs == 0 && uploads.empty())
+            return;
+        upload_ready.wait(lock, [this]() {
+            return !uploads.empty() || (jobs.empty() && running_jobs == 0);
+        });
+    }
+}
+
+size_t AssetLoader::getPending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size() + running_jobs + uploads.size();
+}
+
+AssetLoaderStats AssetLoader::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void AssetLoader::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_ready.wait(lock, [this]() { return quit || !jobs.empty(); });
+            if (quit)
+                return;
+            job.swap(jobs.front());
+            jobs.pop_front();
+            running_jobs += 1;
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running_jobs -= 1;
+            stats.jobs += 1;
+        }
+        upload_ready.notify_all();
+    }
+}
@@ -0,0 +1,156 @@
+//Bounding volumes and view frustum tests
+#include "../include/bounds.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+AABB AABB_Empty() {
+    const float inf = std::numeric_limits<float>::max();
+    AABB box = { glm::vec3(inf), glm::vec3(-inf) };
+    return box;
+}
+
+bool AABB_IsEmpty(const AABB& box) {
+    return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z;
+}
+
+void AABB_Extend(AABB& box, const glm::vec3& point) {
+    box.min = glm::min(box.min, point);
+    box.max = glm::max(box.max, point);
+}
+
+void AABB_Extend(AABB& box, const AABB& other) {
+    if (AABB_IsEmpty(other))
+        return;
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+AABB AABB_FromPoints(const float* xyz, size_t count) {
+    AABB box = AABB_Empty();
+    for (size_t i = 0; i < count; ++i)
+        AABB_Extend(box, glm::vec3(xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]));
+    return box;
+}
+
+AABB AABB_Transform(const AABB& box, const glm::mat4& M) {
+    if (AABB_IsEmpty(box))
+        return box;
+    // Cada coordenada do resultado é a translação mais a soma, por eixo, do
+    // menor/maior produto entre a coluna da matriz e o intervalo da caixa.
+    glm::vec3 translation(M[3]);
+    AABB result = { translation, translation };
+    for (int column = 0; column < 3; ++column) {
+        glm::vec3 a = glm::vec3(M[column]) * box.min[column];
+        glm::vec3 b = glm::vec3(M[column]) * box.max[column];
+        result.min += glm::min(a, b);
+        result.max += glm::max(a, b);
+    }
+    return result;
+}
+
+bool AABB_IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_t, float* t_enter) {
+    float t0 = 0.0f;
+    float t1 = max_t;
+    for (int k = 0; k < 3; ++k) {
+        float near_t = (box.min[k] - origin[k]) * inverse_direction[k];
+        float far_t = (box.max[k] - origin[k]) * inverse_direction[k];
+        if (near_t > far_t)
+            std::swap(near_t, far_t);
+        // Com direção zero no eixo, inf/-inf já descartam ou aceitam o eixo;
+        // 0 * inf (origem na face) vira NaN e é ignorado pelas comparações
+        if (near_t > t0)
+            t0 = near_t;
+        if (far_t < t1)
+            t1 = far_t;
+        if (t0 > t1)
+            return false;
+    }
+    *t_enter = t0;
+    return true;
+}
+
+BoundingSphere BoundingSphere_FromAABB(const AABB& box) {
+    BoundingSphere sphere;
+    if (AABB_IsEmpty(box)) {
+        sphere.center = glm::vec3(0.0f);
+        sphere.radius = -1.0f;
+        return sphere;
+    }
+    sphere.center = 0.5f * (box.min + box.max);
+    sphere.radius = 0.5f * glm::length(box.max - box.min);
+    return sphere;
+}
+
+BoundingSphere BoundingSphere_FromPoints(const float* xyz, size_t count, const AABB& box) {
+    BoundingSphere sphere = BoundingSphere_FromAABB(box);
+    if (count == 0)
+        return sphere;
+    float max_sq = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 d = glm::vec3(xyz[3 * i + 0], xyz[3 * i + 1], xyz[3 * i + 2]) - sphere.center;
+        max_sq = std::max(max_sq, glm::dot(d, d));
+    }
+    sphere.radius = std::sqrt(max_sq);
+    return sphere;
+}
+
+BoundingSphere BoundingSphere_Transform(const BoundingSphere& sphere, const glm::mat4& M) {
+    BoundingSphere result;
+    result.center = glm::vec3(M * glm::vec4(sphere.center, 1.0f));
+    float sx = glm::dot(glm::vec3(M[0]), glm::vec3(M[0]));
+    float sy = glm::dot(glm::vec3(M[1]), glm::vec3(M[1]));
+    float sz = glm::dot(glm::vec3(M[2]), glm::vec3(M[2]));
+    result.radius = sphere.radius * std::sqrt(std::max(sx, std::max(sy, sz)));
+    return result;
+}
+
+Frustum Frustum_FromMatrix(const glm::mat4& view_projection) {
+    // glm guarda colunas: a linha i da matriz é (M[0][i], M[1][i], M[2][i], M[3][i])
+    const glm::mat4& M = view_projection;
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i)
+        row[i] = glm::vec4(M[0][i], M[1][i], M[2][i], M[3][i]);
+
+    Frustum frustum;
+    frustum.planes[Frustum::Left]   = row[3] + row[0];
+    frustum.planes[Frustum::Right]  = row[3] - row[0];
+    frustum.planes[Frustum::Bottom] = row[3] + row[1];
+    frustum.planes[Frustum::Top]    = row[3] - row[1];
+    frustum.planes[Frustum::Near]   = row[3] + row[2];
+    frustum.planes[Frustum::Far]    = row[3] - row[2];
+
+    // Normaliza para que dot(plano, p) seja a distância com sinal até o plano
+    for (int i = 0; i < 6; ++i) {
+        float length = glm::length(glm::vec3(frustum.planes[i]));
+        if (length > 0.0f)
+            frustum.planes[i] /= length;
+    }
+    return frustum;
+}
+
+bool Frustum_Intersects(const Frustum& frustum, const BoundingSphere& sphere) {
+    if (sphere.radius < 0.0f)
+        return false;
+    for (int i = 0; i < 6; ++i) {
+        const glm::vec4& plane = frustum.planes[i];
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum_Intersects(const Frustum& frustum, const AABB& box) {
+    if (AABB_IsEmpty(box))
+        return false;
+    for (int i = 0; i < 6; ++i) {
+        const glm::vec4& plane = frustum.planes[i];
+        // Canto da caixa mais adiante na direção da normal do plano
+        glm::vec3 p(plane.x >= 0.0f ? box.max.x : box.min.x,
+                    plane.y >= 0.0f ? box.max.y : box.min.y,
+                    plane.z >= 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
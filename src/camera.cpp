@@ -1,6 +1,8 @@
 //Camera classes and functions
 #include "../include/camera.hpp"
 #include "../include/timer.hpp"
+#include <cmath>
+#include <limits>
 
 float g_CameraTheta = 0.0f; // Angle in the ZX plane relative to the Z axis
 float g_CameraPhi = 0.0f;   // Angle relative to the Y axis
@@ -26,6 +28,16 @@ glm::mat4 Camera::getProjection() {
         return Matrix_Perspective(field_of_view, screen_ratio, nearplane, farplane);
     }
 }
+float Camera::getPixelsPerUnit(const glm::vec4& point, float viewport_height) {
+    // Um segmento de uma unidade "em pé" diante da câmera, na profundidade do ponto
+    glm::mat4 projection = getProjection();
+    glm::vec4 p = getView() * point;
+    glm::vec4 a = projection * p;
+    glm::vec4 b = projection * (p + glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+    if (a.w <= 1e-6f || b.w <= 1e-6f)
+        return std::numeric_limits<float>::max();
+    return std::fabs(b.y / b.w - a.y / a.w) * 0.5f * viewport_height;
+}
 void Camera::setCameraAxis() {
     if (invert_yaxis) {
         camera_axis.y = 1.0f;
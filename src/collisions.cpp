@@ -1,97 +1,745 @@
 //Collisions tests classes and functions
 
 #include "../include/collisions.hpp"
-#include "../include/geometrics.hpp"
-#include "../include/utils.h"
-#include "glm/gtx/string_cast.hpp" // For glm::to_string
-#include <iostream>
+#include "../include/jobsystem.hpp"
+#include "../include/physics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-bool collisor::SphereToPlane(Ball &ball, Plane &plane) {
-    glm::vec4 ball_center = ball.getCenter() + ball.body->getFuturePosition(); // Future position of the ball
-    glm::vec4 plane_center = plane.getCenter();  
-    float epsilon = 0.1f; // Tolerance for floating point comparison
+// Tolerances of the narrow-phase tests. The broad phase pads the bounds of
+// the balls by the largest of them, so it never rejects a pair these accept.
+static const float SPHERE_TO_PLANE_TOLERANCE = 0.1f;
+static const float SPHERE_TO_CUBE_TOLERANCE = 0.01f;
+static const float SPHERE_TO_MESH_TOLERANCE = 0.01f;
+static const float BROAD_PHASE_PADDING = std::max(SPHERE_TO_PLANE_TOLERANCE, std::max(SPHERE_TO_CUBE_TOLERANCE, SPHERE_TO_MESH_TOLERANCE));
+// Balls dispatched by each job of a parallel BroadPhase::dispatch()
+static const size_t BROAD_PHASE_BALLS_PER_JOB = 16;
 
-    // Normal do plano
-    glm::vec4 plane_normal = plane.normal;
+bool Collision_SphereToPlane(const CollisionSphere& sphere, const glm::vec4& displacement, const CollisionPlane& plane) {
+    glm::vec4 ball_center = sphere.center + displacement; // Future position of the ball
+    float epsilon = SPHERE_TO_PLANE_TOLERANCE; // Tolerance for floating point comparison
 
     // Distância do centro da esfera ao plano
-    float distance = glm::dot(ball_center - plane_center, plane_normal);
+    float distance = glm::dot(ball_center - plane.point, plane.normal);
     // Verifica se a distância é menor ou igual ao raio da esfera
-    return std::abs(distance) <= ball.radius + epsilon; // Use epsilon to avoid floating point precision issues
+    return std::abs(distance) <= sphere.radius + epsilon; // Use epsilon to avoid floating point precision issues
 }
 
-bool collisor::SphereToCube(Ball& ball, Cube& cube) {
-    float epsilon = 0.01f; // ou zero, se quiser precisão exata
+bool Collision_SphereToBox(const CollisionSphere& sphere, const CollisionBox& box) {
+    float epsilon = SPHERE_TO_CUBE_TOLERANCE; // ou zero, se quiser precisão exata
 
-// 1) Centro da bola (mundo)
-glm::vec4 ball_center_world = ball.getCenter(); // w = 1
+    // 1) Centro da bola no espaço local da caixa
+    glm::vec4 ball_local = glm::inverse(box.transform) * sphere.center;
 
-// 2) Transformação do cubo
-glm::mat4 cube_transform = cube.transform;
-glm::mat4 cube_inv_transform = glm::inverse(cube_transform);
+    // 2) Ponto mais próximo no AABB local
+    const glm::vec3& h = box.half_size;
+    float cx = glm::clamp(ball_local.x, -h.x, h.x);
+    float cy = glm::clamp(ball_local.y, -h.y, h.y);
+    float cz = glm::clamp(ball_local.z, -h.z, h.z);
+    glm::vec4 closest_local = glm::vec4(cx, cy, cz, 1.0f);
 
-// 3) Centro da bola no espaço local do cubo
-glm::vec4 ball_local = cube_inv_transform * ball_center_world;
-
-// 4) Metade das dimensões
-float hw = cube.width * 0.5f;
-float hh = cube.height * 0.5f;
-float hd = cube.depth * 0.5f;
-
-// 5) Ponto mais próximo no AABB local
-float cx = glm::clamp(ball_local.x, -hw, hw);
-float cy = glm::clamp(ball_local.y, -hh, hh);
-float cz = glm::clamp(ball_local.z, -hd, hd);
-glm::vec4 closest_local = glm::vec4(cx, cy, cz, 1.0f);
-
-// 6) Transforma de volta para o mundo
-glm::vec4 closest_world = cube_transform * closest_local;
-
-// 7) Vetor do ponto mais próximo até o centro da bola
-glm::vec4 d = ball_center_world - closest_world;
-d.w = 0.0f;
-float dist = glm::length(d);
-
-// 8) Atualiza normal se houver contato
-if (dist > 0.0001f)
-    cube.normal = glm::normalize(d);
-else
-    cube.normal = glm::vec4(0, 1, 0, 0); // fallback
-
-// 9) Teste de colisão
-return dist <= (ball.radius + epsilon);
+    // 3) De volta para o mundo, vetor do ponto mais próximo até o centro
+    glm::vec4 d = sphere.center - box.transform * closest_local;
+    d.w = 0.0f;
+    float dist = glm::length(d);
 
+    // 4) Teste de colisão. Não grava normal nenhuma: a mesma caixa pode ser
+    // testada ao mesmo tempo contra várias bolas (BroadPhase::dispatch).
+    return dist <= (sphere.radius + epsilon);
 }
 
-
 //Test if the sphere is inside the radius of the cylinder
-bool collisor::SphereToCylinder(Ball &ball, Cylinder &cylinder) {
-    glm::vec4 ball_center = ball.getCenter();
-    glm::vec4 cylinder_center = cylinder.getCenter();
+bool Collision_SphereToCylinder(const CollisionSphere& sphere, const CollisionCylinder& cylinder) {
     // Calculate the distance from the ball's center to the cylinder's center in the XZ plane
-    float distance = glm::length(glm::vec3(ball_center.x, 0.0f, ball_center.z) - glm::vec3(cylinder_center.x, 0.0f, cylinder_center.z));
-    return distance <= (ball.radius + cylinder.radius);
+    float distance = glm::length(glm::vec3(sphere.center.x, 0.0f, sphere.center.z) - glm::vec3(cylinder.center.x, 0.0f, cylinder.center.z));
+    return distance <= (sphere.radius + cylinder.radius);
 }
 
 //Check if the ball enters in the hole
-bool collisor::SphereToCylinderBottom(Ball &ball, Cylinder &cylinder) {
-    collisor col;
+bool Collision_SphereToCylinderBottom(const CollisionSphere& sphere, const CollisionCylinder& cylinder) {
     //Check if the ball is inside the radius of the cylinder
-    if(col.SphereToCylinder(ball, cylinder)) {
-        glm::vec4 ball_center = ball.getCenter();
-        glm::vec4 cylinder_center = cylinder.getCenter();
+    if (Collision_SphereToCylinder(sphere, cylinder)) {
         // Check if the ball is below the cylinder's bottom
-        if(ball_center.y < cylinder_center.y - cylinder.height / 2.0f) {
+        if (sphere.center.y < cylinder.center.y - cylinder.height / 2.0f) {
             // Check if the ball is within the radius of the cylinder
-            float distance = glm::length(glm::vec3(ball_center.x, 0.0f, ball_center.z) - glm::vec3(cylinder_center.x, 0.0f, cylinder_center.z));
+            float distance = glm::length(glm::vec3(sphere.center.x, 0.0f, sphere.center.z) - glm::vec3(cylinder.center.x, 0.0f, cylinder.center.z));
             return distance <= cylinder.radius;
         }
     }
     return false;
 }
-bool collisor::SphereToSphere(Ball &ball1, Ball &ball2) {
-    glm::vec4 center1 = ball1.getCenter();
-    glm::vec4 center2 = ball2.getCenter();
-    return glm::length(center1 - center2) <= (ball1.radius + ball2.radius);
 
+bool Collision_SphereToSphere(const CollisionSphere& sphere1, const CollisionSphere& sphere2) {
+    return glm::length(sphere1.center - sphere2.center) <= (sphere1.radius + sphere2.radius);
+}
+
+bool Collision_SphereToMesh(const CollisionSphere& sphere, const CollisionMesh& mesh, MeshContact* contact) {
+    // Consulta no espaço da BVH; sem escala, as distâncias são as mesmas
+    glm::vec3 center_local(glm::inverse(mesh.transform) * sphere.center);
+    if (!mesh.bvh->closestPoint(center_local, sphere.radius + SPHERE_TO_MESH_TOLERANCE, contact))
+        return false;
+    contact->point = glm::vec3(mesh.transform * glm::vec4(contact->point, 1.0f));
+    contact->normal = glm::normalize(glm::vec3(mesh.transform * glm::vec4(contact->normal, 0.0f)));
+    return true;
+}
+
+bool Collision_SweepSphereToPlane(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionPlane& plane, float* toi) {
+    // Distância com sinal ao plano, do lado onde a esfera começa
+    float start = glm::dot(sphere.center - plane.point, plane.normal);
+    float side = start >= 0.0f ? 1.0f : -1.0f;
+    float gap = side * start - sphere.radius;
+    if (gap <= 0.0f) {
+        *toi = 0.0f; // Já encostada
+        return true;
+    }
+    float approach = -side * glm::dot(motion, plane.normal); // Quanto do movimento vai em direção ao plano
+    if (approach <= gap)
+        return false; // Afastando-se, ou não chega até o plano neste passo
+    *toi = gap / approach;
+    return true;
+}
+
+bool Collision_SweepSphereToBox(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionBox& box, float* toi) {
+    // Raio contra a caixa aumentada pelo raio da esfera, no espaço local
+    glm::mat4 inverse = glm::inverse(box.transform);
+    glm::vec4 origin = inverse * sphere.center;
+    glm::vec4 direction = inverse * glm::vec4(glm::vec3(motion), 0.0f);
+
+    float t_enter = 0.0f;
+    float t_exit = 1.0f;
+    for (int k = 0; k < 3; ++k) {
+        float half = std::fabs(box.half_size[k]) + sphere.radius;
+        if (std::fabs(direction[k]) < 1e-12f) {
+            if (origin[k] < -half || origin[k] > half)
+                return false; // Paralelo ao par de faces e fora dele
+            continue;
+        }
+        float t0 = (-half - origin[k]) / direction[k];
+        float t1 = (half - origin[k]) / direction[k];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        t_enter = std::max(t_enter, t0);
+        t_exit = std::min(t_exit, t1);
+        if (t_enter > t_exit)
+            return false;
+    }
+    *toi = t_enter;
+    return true;
+}
+
+bool Collision_SweepSphereToCylinder(const CollisionSphere& sphere, const glm::vec4& motion, const CollisionCylinder& cylinder, float* toi) {
+    // Como Collision_SphereToCylinder, só no plano XZ: círculo de raio somado
+    float ox = sphere.center.x - cylinder.center.x;
+    float oz = sphere.center.z - cylinder.center.z;
+    float reach = sphere.radius + cylinder.radius;
+    float c = ox * ox + oz * oz - reach * reach;
+    if (c <= 0.0f) {
+        *toi = 0.0f;
+        return true;
+    }
+    float a = motion.x * motion.x + motion.z * motion.z;
+    float b = 2.0f * (ox * motion.x + oz * motion.z);
+    if (a <= 0.0f || b >= 0.0f)
+        return false; // Parada ou afastando-se no plano XZ
+    float discriminant = b * b - 4.0f * a * c;
+    if (discriminant < 0.0f)
+        return false;
+    float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if (t > 1.0f)
+        return false;
+    *toi = t;
+    return true;
+}
+
+// Reflete a componente normal da velocidade e aplica a força normal
+void Collision_BounceOffPlane(RigidBody& body, const glm::vec4& normal) {
+    glm::vec4 velocity = body.getVelocity(); // Get the velocity of the ball
+    glm::vec4 v_normal = glm::dot(velocity, normal) * normal;
+    glm::vec4 v_tangential = velocity - v_normal; // Calculate the tangential velocity
+    body.setVelocity(-v_normal + v_tangential);
+
+    glm::vec4 normal_force = -glm::dot(g, normal) * normal * body.getMass();
+    body.addForce(normal_force);
+}
+
+bool Collision_RespondToPlane(RigidBody& body, const CollisionSphere& sphere, const CollisionPlane& plane) {
+    if (!Collision_SphereToPlane(sphere, body.getFuturePosition(), plane))
+        return false;
+    Collision_BounceOffPlane(body, plane.normal);
+    return true;
+}
+
+bool Collision_RespondToBox(RigidBody& body, const CollisionSphere& sphere, const CollisionBox& box, const glm::vec4& respawn) {
+    if (!Collision_SphereToBox(sphere, box))
+        return false;
+    body.setPosition(respawn);
+    body.resetAcceleration();
+    body.resetVelocity();
+    return true;
+}
+
+bool Collision_RespondToCylinder(RigidBody& body, const CollisionSphere& sphere, const CollisionCylinder& cylinder) {
+    //If ball in the radius of the cylinder, turn off the normal force
+    if (!Collision_SphereToCylinder(sphere, cylinder))
+        return false;
+    body.resetForce();
+    body.addForce(g); //Only gravity force
+
+    if (Collision_SphereToCylinderBottom(sphere, cylinder)) {
+        //If ball hit the bottom of the cylinder, turn on normal force
+        Collision_BounceOffPlane(body, glm::normalize(sphere.center - cylinder.center));
+    }
+    return true;
+}
+
+// Como Collision_BounceOffPlane, mas só reflete quem vai contra a
+// superfície e só aplica a força normal onde ela sustenta o corpo (não num
+// teto ou na face de baixo de uma rampa)
+static void BounceOffSurface(RigidBody& body, const glm::vec4& normal) {
+    glm::vec4 velocity = body.getVelocity();
+    float approach = glm::dot(velocity, normal);
+    if (approach < 0.0f)
+        body.setVelocity(velocity - 2.0f * approach * normal);
+    float support = -glm::dot(g, normal);
+    if (support > 0.0f)
+        body.addForce(support * normal * body.getMass());
+}
+
+bool Collision_RespondToMesh(RigidBody& body, const CollisionSphere& sphere, const CollisionMesh& mesh) {
+    MeshContact contact;
+    if (!Collision_SphereToMesh(sphere, mesh, &contact))
+        return false;
+    glm::vec4 normal(contact.normal, 0.0f);
+
+    // Tira a bola de dentro do triângulo mais próximo
+    float penetration = sphere.radius - contact.distance;
+    if (penetration > 0.0f)
+        body.setPosition(body.getPosition() + normal * penetration);
+    BounceOffSurface(body, normal);
+
+    // Subir "penetration" contra a gravidade deu energia à bola; sem tirar a
+    // mesma energia da velocidade de saída, os quiques nunca diminuem e a
+    // bola não para sobre a malha
+    float support = -glm::dot(g, normal);
+    glm::vec4 velocity = body.getVelocity();
+    float away = glm::dot(velocity, normal);
+    if (penetration > 0.0f && support > 0.0f && away > 0.0f) {
+        float reduced = std::sqrt(std::max(0.0f, away * away - 2.0f * support * penetration));
+        body.setVelocity(velocity + (reduced - away) * normal);
+    }
+    return true;
+}
+
+
+static bool PairLess(const CollisionPair& a, const CollisionPair& b) {
+    return a.first != b.first ? a.first < b.first : a.second < b.second;
+}
+
+// Soma (weight 1) ou tira (weight -1) o centro de "bounds" das estatísticas
+// de cada eixo em que ele é finito
+static void AccumulateCenter(const AABB& bounds, double weight, glm::dvec3& sum, glm::dvec3& sum_sq, glm::dvec3& count) {
+    const float huge = std::numeric_limits<float>::max();
+    for (int k = 0; k < 3; ++k) {
+        if (bounds.min[k] > -huge && bounds.max[k] < huge) {
+            double c = 0.5 * (static_cast<double>(bounds.min[k]) + bounds.max[k]);
+            sum[k] += weight * c;
+            sum_sq[k] += weight * c * c;
+            count[k] += weight;
+        }
+    }
+}
+
+int BroadPhase::addBall(RigidBody* body, float radius, bool* grounded) {
+    Collider collider;
+    collider.shape = ColliderSphere;
+    collider.body = body;
+    collider.radius = radius;
+    collider.grounded = grounded;
+    return add(collider);
+}
+
+int BroadPhase::addPlane(const CollisionPlane& plane) {
+    Collider collider;
+    collider.shape = ColliderPlane;
+    collider.plane = plane;
+    return add(collider);
+}
+
+int BroadPhase::addBox(const CollisionBox& box, const glm::vec4& respawn) {
+    Collider collider;
+    collider.shape = ColliderBox;
+    collider.box = box;
+    collider.respawn = respawn;
+    return add(collider);
+}
+
+int BroadPhase::addCylinder(const CollisionCylinder& cylinder) {
+    Collider collider;
+    collider.shape = ColliderCylinder;
+    collider.cylinder = cylinder;
+    return add(collider);
+}
+
+int BroadPhase::addMesh(const CollisionMesh& mesh) {
+    Collider collider;
+    collider.shape = ColliderMesh;
+    collider.mesh = mesh;
+    return add(collider);
+}
+
+void BroadPhase::addStatics(const BroadPhase& other) {
+    for (size_t id = 0; id < other.colliders.size(); ++id)
+        if (other.colliders[id].shape != ColliderSphere)
+            add(other.colliders[id]);
+}
+
+int BroadPhase::add(const Collider& new_collider) {
+    Collider collider = new_collider;
+    collider.bounds = computeBounds(collider);
+    colliders.push_back(collider);
+    ball_slot.push_back(-1);
+    int id = static_cast<int>(colliders.size() - 1);
+    order.push_back(id);
+    if (collider.shape != ColliderSphere) {
+        statics.push_back(id);
+        AccumulateCenter(collider.bounds, 1.0, rest_sum, rest_sum_sq, rest_count);
+    }
+    return id;
+}
+
+AABB BroadPhase::computeBounds(const Collider& collider) const {
+    const float huge = std::numeric_limits<float>::max();
+    AABB unbounded = { glm::vec3(-huge), glm::vec3(huge) };
+
+    switch (collider.shape) {
+    case ColliderSphere: {
+        // Cobre o último passo, o centro atual e a posição futura usada por
+        // Collision_SphereToPlane, com folga de |v|*dt em todas as direções:
+        // as respostas só refletem a velocidade, então a posição futura
+        // nunca sai desta caixa.
+        glm::vec3 center(collider.body->getPosition());
+        glm::vec3 previous(collider.body->getPreviousPosition()); // Início do trecho varrido pela CCD
+        glm::vec3 displacement(collider.body->getFuturePosition());
+        glm::vec3 future = center + displacement;
+        float reach = collider.radius + BROAD_PHASE_PADDING + glm::length(displacement);
+        AABB box = { glm::min(glm::min(center, future), previous) - glm::vec3(reach),
+                     glm::max(glm::max(center, future), previous) + glm::vec3(reach) };
+        return box;
+    }
+    case ColliderPlane: {
+        // Collision_SphereToPlane testa o plano infinito: só um normal alinhado a um eixo
+        // limita a caixa (ao próprio plano; a folga está na caixa da bola).
+        glm::vec3 center(collider.plane.point);
+        glm::vec3 n(collider.plane.normal);
+        AABB box = unbounded;
+        for (int i = 0; i < 3; ++i) {
+            if (std::fabs(n[i]) == 1.0f && n[(i + 1) % 3] == 0.0f && n[(i + 2) % 3] == 0.0f) {
+                box.min[i] = center[i];
+                box.max[i] = center[i];
+            }
+        }
+        return box;
+    }
+    case ColliderBox: {
+        // Mesmo volume de Collision_SphereToBox: meias-dimensões no espaço
+        // local da transformação da caixa.
+        glm::vec3 half = glm::abs(collider.box.half_size);
+        AABB local = { -half, half };
+        AABB box = AABB_Transform(local, collider.box.transform);
+        for (int i = 0; i < 3; ++i)
+            if (!std::isfinite(box.min[i]) || !std::isfinite(box.max[i]))
+                return unbounded;
+        return box;
+    }
+    case ColliderCylinder: {
+        // Collision_SphereToCylinder só olha o plano XZ: infinito em Y
+        const CollisionCylinder& cylinder = collider.cylinder;
+        AABB box = unbounded;
+        box.min.x = cylinder.center.x - cylinder.radius;
+        box.max.x = cylinder.center.x + cylinder.radius;
+        box.min.z = cylinder.center.z - cylinder.radius;
+        box.max.z = cylinder.center.z + cylinder.radius;
+        return box;
+    }
+    case ColliderMesh:
+        // Caixa da raiz da BVH no mundo; a folga está na caixa da bola
+        return AABB_Transform(collider.mesh.bvh->getBounds(), collider.mesh.transform);
+    }
+    return unbounded;
+}
+
+void BroadPhase::update() {
+    // Bolas que acordaram voltam para a varredura. Quem as acorda está fora
+    // da broad phase (tacada, setPosition(), dispatch()), então as que
+    // dormem são conferidas aqui: só um flag por bola.
+    size_t kept = 0;
+    for (size_t i = 0; i < sleepers.size(); ++i) {
+        const Collider& collider = colliders[sleepers[i]];
+        if (collider.body->isSleeping()) {
+            sleepers[kept++] = sleepers[i];
+            continue;
+        }
+        AccumulateCenter(collider.bounds, -1.0, rest_sum, rest_sum_sq, rest_count);
+        order.push_back(sleepers[i]);
+    }
+    sleepers.resize(kept);
+    if (sleepers.empty())
+        sleeper_extent = 0.0f;
+
+    // E as que dormiram saem dela, com a última caixa: bolas dormindo não
+    // saem do lugar. Entram no fim de "sleepers", ordenadas mais abaixo.
+    size_t sorted_sleepers = sleepers.size();
+    size_t awake = 0;
+    kept = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Collider& collider = colliders[order[i]];
+        if (collider.shape == ColliderSphere && collider.body->isSleeping()) {
+            AccumulateCenter(collider.bounds, 1.0, rest_sum, rest_sum_sq, rest_count);
+            sleepers.push_back(order[i]);
+            continue;
+        }
+        if (collider.shape == ColliderSphere)
+            ++awake;
+        order[kept++] = order[i];
+    }
+    order.resize(kept);
+    pairs.clear();
+
+    // Caixas das bolas acordadas; também escolhe o eixo onde os centros
+    // finitos estão mais espalhados (variância), que separa mais intervalos.
+    // Os estáticos e as que dormem já estão somados em rest_*.
+    int best_axis = axis;
+    if (awake > 0) {
+        glm::dvec3 sum = rest_sum, sum_sq = rest_sum_sq, count = rest_count;
+        for (size_t i = 0; i < order.size(); ++i) {
+            Collider& collider = colliders[order[i]];
+            if (collider.shape != ColliderSphere)
+                continue;
+            collider.bounds = computeBounds(collider);
+            AccumulateCenter(collider.bounds, 1.0, sum, sum_sq, count);
+        }
+        double best_variance = -1.0;
+        for (int k = 0; k < 3; ++k) {
+            if (count[k] < 2.0)
+                continue;
+            double mean = sum[k] / count[k];
+            double variance = sum_sq[k] / count[k] - mean * mean;
+            if (variance > best_variance) {
+                best_variance = variance;
+                best_axis = k;
+            }
+        }
+    }
+
+    const int k = best_axis;
+    auto less = [this, k](int a, int b) { return colliders[a].bounds.min[k] < colliders[b].bounds.min[k]; };
+    if (best_axis != axis) {
+        axis = best_axis;
+        std::sort(order.begin(), order.end(), less);
+        std::sort(sleepers.begin(), sleepers.end(), less);
+        sorted_sleepers = 0;
+        sleeper_extent = 0.0f;
+    }
+    else {
+        // Ordenação por inserção: quase linear quando a ordem mudou pouco
+        for (size_t i = 1; i < order.size(); ++i) {
+            int id = order[i];
+            size_t j = i;
+            while (j > 0 && less(id, order[j - 1])) {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = id;
+        }
+        if (sorted_sleepers < sleepers.size()) {
+            std::sort(sleepers.begin() + sorted_sleepers, sleepers.end(), less);
+            std::inplace_merge(sleepers.begin(), sleepers.begin() + sorted_sleepers, sleepers.end(), less);
+        }
+    }
+    // Maior caixa das que dormem no eixo k, só das que entraram agora (ou
+    // de todas, se o eixo mudou)
+    for (size_t i = sorted_sleepers; i < sleepers.size(); ++i) {
+        const AABB& bounds = colliders[sleepers[i]].bounds;
+        sleeper_extent = std::max(sleeper_extent, bounds.max[k] - bounds.min[k]);
+    }
+    if (awake == 0)
+        return; // Tudo parado: nada a testar
+
+    auto add_if_overlap = [this](int first, int second) {
+        const AABB& a = colliders[first].bounds;
+        const AABB& b = colliders[second].bounds;
+        for (int other = 0; other < 3; ++other)
+            if (a.max[other] < b.min[other] || b.max[other] < a.min[other])
+                return;
+        CollisionPair pair = { std::min(first, second), std::max(first, second) };
+        pairs.push_back(pair);
+    };
+
+    // Varredura: cada intervalo só é comparado com os que começam antes de
+    // ele terminar no eixo de varredura.
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Collider& a = colliders[order[i]];
+        for (size_t j = i + 1; j < order.size(); ++j) {
+            const Collider& b = colliders[order[j]];
+            if (b.bounds.min[k] > a.bounds.max[k])
+                break;
+            if (a.shape != ColliderSphere && b.shape != ColliderSphere)
+                continue; // Dois objetos estáticos
+            add_if_overlap(order[i], order[j]);
+        }
+    }
+
+    // Bolas acordadas contra as que dormem: só as que começam a menos de
+    // sleeper_extent antes da bola podem alcançá-la
+    for (size_t i = 0; i < order.size() && !sleepers.empty(); ++i) {
+        const Collider& a = colliders[order[i]];
+        if (a.shape != ColliderSphere)
+            continue;
+        float low = a.bounds.min[k] - sleeper_extent;
+        std::vector<int>::const_iterator it = std::lower_bound(sleepers.begin(), sleepers.end(), low,
+            [this, k](int id, float value) { return colliders[id].bounds.min[k] < value; });
+        for (; it != sleepers.end() && colliders[*it].bounds.min[k] <= a.bounds.max[k]; ++it)
+            add_if_overlap(order[i], *it);
+    }
+
+    // Ordem de registro, a mesma dos testes feitos à mão no loop de física
+    std::sort(pairs.begin(), pairs.end(), PairLess);
+}
+
+bool BroadPhase::respond(const CollisionPair& pair) const {
+    const Collider* a = &colliders[pair.first];
+    const Collider* b = &colliders[pair.second];
+    if (a->shape != ColliderSphere)
+        std::swap(a, b);
+    if (a->shape != ColliderSphere || b->shape == ColliderSphere)
+        return false; // Bola contra bola: ainda não há resposta implementada
+
+    RigidBody& body = *a->body;
+    CollisionSphere sphere = { body.getPosition(), a->radius };
+    switch (b->shape) {
+    case ColliderPlane:
+        if (Collision_RespondToPlane(body, sphere, b->plane) && a->grounded != NULL)
+            *a->grounded = true;
+        return false;
+    case ColliderBox:
+        // Caixa é zona de morte: a bola é teleportada
+        return Collision_RespondToBox(body, sphere, b->box, b->respawn) && body.getPosition() != sphere.center;
+    case ColliderCylinder:
+        Collision_RespondToCylinder(body, sphere, b->cylinder);
+        return false;
+    case ColliderMesh:
+        if (Collision_RespondToMesh(body, sphere, b->mesh) && a->grounded != NULL)
+            *a->grounded = true;
+        return false;
+    default:
+        return false;
+    }
+}
+
+void BroadPhase::dispatch(JobSystem* jobs) {
+    // Uma bola acordada encostando numa que dorme a acorda; ela passa a ser
+    // testada no próximo passo, quando já terá os próprios pares.
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const Collider& a = colliders[pairs[i].first];
+        const Collider& b = colliders[pairs[i].second];
+        if (a.shape != ColliderSphere || b.shape != ColliderSphere || a.body->isSleeping() == b.body->isSleeping())
+            continue;
+        CollisionSphere sphere_a = { a.body->getPosition(), a.radius };
+        CollisionSphere sphere_b = { b.body->getPosition(), b.radius };
+        if (Collision_SphereToSphere(sphere_a, sphere_b))
+            (a.body->isSleeping() ? a.body : b.body)->wake();
+    }
+
+    // As bolas acordadas estão em "order" desde update(); as que acabaram de
+    // acordar ainda não têm pares e só entram no próximo passo
+    balls.clear();
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (colliders[order[i]].shape == ColliderSphere) {
+            ball_slot[order[i]] = static_cast<int>(balls.size());
+            balls.push_back(order[i]);
+        }
+    }
+
+    // Pares de cada bola, na ordem de registro. Bola contra bola não tem
+    // resposta, então cada grupo só altera a própria bola. Os buffers são
+    // reaproveitados de um passo para o outro.
+    if (pairs_by_ball.size() < balls.size())
+        pairs_by_ball.resize(balls.size());
+    for (size_t b = 0; b < balls.size(); ++b)
+        pairs_by_ball[b].clear();
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const CollisionPair& pair = pairs[i];
+        bool first_is_ball = colliders[pair.first].shape == ColliderSphere;
+        bool second_is_ball = colliders[pair.second].shape == ColliderSphere;
+        if (first_is_ball == second_is_ball)
+            continue;
+        int slot = ball_slot[first_is_ball ? pair.first : pair.second];
+        if (slot >= 0) // Bolas dormindo não são testadas
+            pairs_by_ball[slot].push_back(pair);
+    }
+    for (size_t b = 0; b < balls.size(); ++b)
+        ball_slot[balls[b]] = -1;
+
+    ball_moved.assign(balls.size(), 0);
+    auto dispatch_range = [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b)
+            ball_moved[b] = dispatchBall(balls[b], pairs_by_ball[b]) ? 1 : 0;
+    };
+    if (jobs != NULL && balls.size() > 1)
+        jobs->parallelFor(balls.size(), BROAD_PHASE_BALLS_PER_JOB, dispatch_range);
+    else
+        dispatch_range(0, balls.size());
+
+    if (std::find(ball_moved.begin(), ball_moved.end(), 1) != ball_moved.end())
+        update(); // Pares de quem foi teleportada
+}
+
+bool BroadPhase::dispatchBall(int ball, std::vector<CollisionPair>& ball_pairs) const {
+    // Primeiro a CCD; os planos em que ela já quicou a bola ficam de fora
+    // dos testes discretos deste passo, que a refletiriam de volta.
+    std::vector<int> bounced;
+    bool moved = sweepBall(ball, ball_pairs, bounced);
+    if (moved)
+        findBallPairs(ball, ball_pairs);
+
+    size_t i = 0;
+    while (i < ball_pairs.size()) {
+        CollisionPair current = ball_pairs[i++];
+        int other = current.first == ball ? current.second : current.first;
+        if (std::find(bounced.begin(), bounced.end(), other) != bounced.end())
+            continue;
+        if (!respond(current))
+            continue;
+        // A bola saiu do lugar: recalcula os pares e continua depois do atual
+        moved = true;
+        findBallPairs(ball, ball_pairs);
+        i = 0;
+        while (i < ball_pairs.size() && !PairLess(current, ball_pairs[i]))
+            ++i;
+    }
+    return moved;
+}
+
+bool BroadPhase::sweepBall(int ball, const std::vector<CollisionPair>& ball_pairs, std::vector<int>& bounced) const {
+    const Collider& collider = colliders[ball];
+    RigidBody& body = *collider.body;
+    glm::vec4 start = body.getPreviousPosition();
+    float time_left = body.deltaTime; // Tempo do trecho de start até a posição atual
+
+    for (int substep = 0; substep < BROAD_PHASE_MAX_SUBSTEPS; ++substep) {
+        glm::vec4 end = body.getPosition();
+        glm::vec4 motion = end - start;
+        motion.w = 0.0f;
+        if (motion == glm::vec4(0.0f))
+            return false;
+        CollisionSphere sphere = { start, collider.radius };
+
+        // Primeiro contato ao longo do trecho que o teste discreto perderia
+        float first_toi = 2.0f;
+        int first = -1;
+        glm::vec4 first_normal(0.0f); // Planos e malhas: normal do quique
+        for (size_t i = 0; i < ball_pairs.size(); ++i) {
+            int id = ball_pairs[i].first == ball ? ball_pairs[i].second : ball_pairs[i].first;
+            const Collider& other = colliders[id];
+            float toi;
+            glm::vec4 normal(0.0f);
+            if (other.shape == ColliderPlane) {
+                // Só quando o centro atravessou o plano: antes disso o teste
+                // discreto ainda vê a bola e responde como sempre.
+                float side_start = glm::dot(start - other.plane.point, other.plane.normal);
+                float side_end = glm::dot(end - other.plane.point, other.plane.normal);
+                if ((side_start >= 0.0f) == (side_end >= 0.0f))
+                    continue;
+                // Onde o centro atravessa a boca de um cilindro (buraco) o
+                // plano não sustenta a bola: Collision_RespondToCylinder()
+                // tira a força normal e ela tem que poder cair
+                glm::vec4 crossing = start + motion * (side_start / (side_start - side_end));
+                if (crossesCylinder(ball_pairs, ball, crossing))
+                    continue;
+                if (!Collision_SweepSphereToPlane(sphere, motion, other.plane, &toi))
+                    continue;
+                normal = other.plane.normal;
+            }
+            else if (other.shape == ColliderMesh) {
+                // Como nos planos, só quando o centro atravessou um triângulo;
+                // o contato é onde a esfera encosta no plano desse triângulo
+                glm::mat4 inverse = glm::inverse(other.mesh.transform);
+                MeshHit hit;
+                if (!other.mesh.bvh->intersectRay(glm::vec3(inverse * start), glm::vec3(inverse * motion), 1.0f, &hit))
+                    continue;
+                normal = glm::vec4(glm::normalize(glm::vec3(other.mesh.transform * glm::vec4(hit.normal, 0.0f))), 0.0f);
+                glm::vec4 point = other.mesh.transform * glm::vec4(hit.point, 1.0f);
+                float gap = glm::dot(start - point, normal) - collider.radius;
+                float approach = -glm::dot(motion, normal);
+                toi = (gap > 0.0f && approach > 0.0f) ? std::min(gap / approach, hit.t) : 0.0f;
+            }
+            else if (other.shape == ColliderBox) {
+                CollisionSphere at_end = { end, collider.radius };
+                if (Collision_SphereToBox(at_end, other.box))
+                    continue; // O teste discreto pega
+                if (!Collision_SweepSphereToBox(sphere, motion, other.box, &toi))
+                    continue;
+            }
+            else {
+                continue; // Cilindro (buraco) só muda forças: nada a atravessar
+            }
+            if (toi < first_toi) {
+                first_toi = toi;
+                first = id;
+                first_normal = normal;
+            }
+        }
+        if (first < 0)
+            return false;
+
+        const Collider& other = colliders[first];
+        if (other.shape == ColliderBox) {
+            CollisionSphere at_contact = { start + motion * first_toi, collider.radius };
+            return Collision_RespondToBox(body, at_contact, other.box, other.respawn);
+        }
+
+        // Volta ao instante do contato, quica e anda o resto do passo
+        glm::vec4 contact = start + motion * first_toi;
+        if (other.shape == ColliderMesh)
+            BounceOffSurface(body, first_normal);
+        else
+            Collision_BounceOffPlane(body, first_normal);
+        if (std::find(bounced.begin(), bounced.end(), first) == bounced.end())
+            bounced.push_back(first);
+        time_left *= 1.0f - first_toi;
+        body.setPosition(contact + body.getVelocity() * time_left);
+        start = contact;
+    }
+    return false;
+}
+
+bool BroadPhase::crossesCylinder(const std::vector<CollisionPair>& ball_pairs, int ball, const glm::vec4& center) const {
+    CollisionSphere sphere = { center, colliders[ball].radius };
+    for (size_t i = 0; i < ball_pairs.size(); ++i) {
+        int id = ball_pairs[i].first == ball ? ball_pairs[i].second : ball_pairs[i].first;
+        if (colliders[id].shape == ColliderCylinder && Collision_SphereToCylinder(sphere, colliders[id].cylinder))
+            return true;
+    }
+    return false;
+}
+
+void BroadPhase::findBallPairs(int ball, std::vector<CollisionPair>& ball_pairs) const {
+    // Caixa atual da bola contra todos os estáticos; não altera "colliders",
+    // que as outras bolas estão lendo ao mesmo tempo.
+    AABB bounds = computeBounds(colliders[ball]);
+    ball_pairs.clear();
+    for (size_t i = 0; i < statics.size(); ++i) {
+        int id = statics[i];
+        const Collider& other = colliders[id];
+        bool overlap = true;
+        for (int k = 0; k < 3; ++k)
+            if (bounds.max[k] < other.bounds.min[k] || other.bounds.max[k] < bounds.min[k])
+                overlap = false;
+        if (!overlap)
+            continue;
+        CollisionPair pair = { std::min(ball, id), std::max(ball, id) };
+        ball_pairs.push_back(pair);
+    }
+    std::sort(ball_pairs.begin(), ball_pairs.end(), PairLess);
 }
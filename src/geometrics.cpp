@@ -1,8 +1,12 @@
 #include "../include/geometrics.hpp"
 #include "../include/matrices.hpp"
 #include "glm/gtx/string_cast.hpp"
+#include "glm/gtc/packing.hpp"
 #include "physics.hpp"
-#include "stb_image.h"
+#include "meshopt.hpp"
+#include "assetloader.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <vector>
 
@@ -10,7 +14,7 @@ GLuint g_NumLoadedTextures = 0;
 
 glm::vec4 Mesh::ComputeNormals(bool force) {
     if (force) {
-        // Force computation of normals even if they are already present
+        // The face normal, even if vertex normals are present
         return ComputeNormals();
     }
     if (!model->attrib.normals.empty()) {
@@ -23,56 +27,6 @@ glm::vec4 Mesh::ComputeNormals(bool force) {
 }
 
 glm::vec4 Mesh::ComputeNormals() {
-    // This function computes normals for the mesh if needed.
-    // Implementation details would depend on the specific mesh structure.
-
-    {
-
-        size_t num_vertices = model->attrib.vertices.size() / 3;
-
-        std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-        std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
-
-        for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
-            size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
-
-            for (size_t triangle = 0; triangle < num_triangles; ++triangle) {
-                assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
-
-                glm::vec4  vertices[3];
-                for (size_t vertex = 0; vertex < 3; ++vertex) {
-                    tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
-                    const float vx = model->attrib.vertices[3 * idx.vertex_index + 0];
-                    const float vy = model->attrib.vertices[3 * idx.vertex_index + 1];
-                    const float vz = model->attrib.vertices[3 * idx.vertex_index + 2];
-                    vertices[vertex] = glm::vec4(vx, vy, vz, 1.0);
-                }
-
-                const glm::vec4  a = vertices[0];
-                const glm::vec4  b = vertices[1];
-                const glm::vec4  c = vertices[2];
-
-                const glm::vec4  n = normalize(crossproduct((b - a), (c - a)));
-
-                for (size_t vertex = 0; vertex < 3; ++vertex) {
-                    tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
-                    num_triangles_per_vertex[idx.vertex_index] += 1;
-                    vertex_normals[idx.vertex_index] += n;
-                    model->shapes[shape].mesh.indices[3 * triangle + vertex].normal_index = idx.vertex_index;
-                }
-            }
-        }
-
-        model->attrib.normals.resize(3 * num_vertices);
-
-        for (size_t i = 0; i < vertex_normals.size(); ++i) {
-            glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-            n /= norm(n);
-            model->attrib.normals[3 * i + 0] = n.x;
-            model->attrib.normals[3 * i + 1] = n.y;
-            model->attrib.normals[3 * i + 2] = n.z;
-        }
-    }
     if (model->attrib.normals.empty()) {
         fprintf(stderr, "Error: No normals found in the model. Normals will not be computed.\n");
         return glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
@@ -94,53 +48,158 @@ glm::vec4 Mesh::ComputeNormals() {
 }
 
 
-void Mesh::BuildTrianglesAndAddToVirtualScene(VirtualScene& scene) {
-    GLuint vertex_array_object_id;
-    glGenVertexArrays(1, &vertex_array_object_id);
-    glBindVertexArray(vertex_array_object_id);
+// Envia os vértices soldados (registros de "stride" floats: posição vec4,
+// normal vec4, textura vec2) como três VBOs separados de floats, 40 bytes
+// por vértice. Atributos 0, 1 e 2 do VAO atualmente ligado; os nomes dos
+// buffers criados vão para "buffers".
+static void UploadSeparateVertexBuffers(const std::vector<float>& vertices, size_t stride, size_t num_vertices, bool has_normals, bool has_texcoords, std::vector<GLuint>* buffers) {
+    std::vector<float>  model_coefficients(4 * num_vertices);   // posição (vec4)
+    std::vector<float>  normal_coefficients(4 * num_vertices);  // normais (vec4)
+    std::vector<float>  texture_coefficients(2 * num_vertices); // textura (vec2)
+    for (size_t v = 0; v < num_vertices; ++v) {
+        const float* record = &vertices[v * stride];
+        std::copy(record + 0, record + 4, &model_coefficients[4 * v]);
+        std::copy(record + 4, record + 8, &normal_coefficients[4 * v]);
+        std::copy(record + 8, record + 10, &texture_coefficients[2 * v]);
+    }
 
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;   // posição (vec4)
-    std::vector<float>  normal_coefficients;  // normais (vec4)
-    std::vector<float>  texture_coefficients; // textura (vec2)
+    // Posição
+    GLuint VBO_pos;
+    glGenBuffers(1, &VBO_pos);
+    buffers->push_back(VBO_pos);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
+    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), model_coefficients.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
 
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
+    // Normais
+    if (has_normals) {
+        GLuint VBO_norm;
+        glGenBuffers(1, &VBO_norm);
+        buffers->push_back(VBO_norm);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_norm);
+        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), normal_coefficients.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(1);
+    }
+
+    // Coordenadas de textura
+    if (has_texcoords) {
+        GLuint VBO_tex;
+        glGenBuffers(1, &VBO_tex);
+        buffers->push_back(VBO_tex);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_tex);
+        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), texture_coefficients.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(2);
+    }
+}
+
+// Mesmos vértices em um único VBO intercalado de CompactVertex (20 bytes):
+// posição vec3 float, normal GL_INT_2_10_10_10_REV normalizada e textura
+// em half float. O shader recebe vec3/vec3/vec2 nas mesmas localizações.
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex must stay tightly packed");
+
+static void UploadCompactVertexBuffer(const std::vector<float>& vertices, size_t stride, size_t num_vertices, std::vector<GLuint>* buffers) {
+    std::vector<CompactVertex> packed(num_vertices);
+    for (size_t v = 0; v < num_vertices; ++v) {
+        const float* record = &vertices[v * stride];
+        CompactVertex& out = packed[v];
+        out.position[0] = record[0];
+        out.position[1] = record[1];
+        out.position[2] = record[2];
+        out.normal = glm::packSnorm3x10_1x2(glm::vec4(record[4], record[5], record[6], 0.0f));
+        out.texcoord[0] = glm::packHalf1x16(record[8]);
+        out.texcoord[1] = glm::packHalf1x16(record[9]);
+    }
+
+    GLuint VBO;
+    glGenBuffers(1, &VBO);
+    buffers->push_back(VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(CompactVertex), packed.data(), GL_STATIC_DRAW);
+
+    const GLsizei vertex_stride = sizeof(CompactVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertex_stride, (void*)offsetof(CompactVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, vertex_stride, (void*)offsetof(CompactVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, vertex_stride, (void*)offsetof(CompactVertex, texcoord));
+    glEnableVertexAttribArray(2);
+}
+
+// Vértices soldados, índices e objetos (um por shape, com seus níveis de
+// detalhe) de um Mesh, prontos para a GPU. Montados sem OpenGL, então
+// podem ser feitos por um job do AssetLoader.
+struct MeshGeometry {
+    std::vector<float> vertices; // Registros de MESH_GEOMETRY_STRIDE floats
+    std::vector<GLuint> indices;
+    size_t num_vertices = 0;
+    bool has_normals = false;
+    bool has_texcoords = false;
+    std::vector<SceneObject> objects; // Sem VAO ainda
+};
+#define MESH_GEOMETRY_STRIDE (4 + 4 + 2)
+
+// Opções do Mesh usadas para montar a geometria, copiadas para o job
+struct MeshBuildOptions {
+    bool has_color;
+    bool optimize_vertex_cache;
+    int lod_levels;
+    Mesh::VertexLayout vertex_layout;
+};
+
+static void BuildMeshGeometry(const ObjModel& model, const MeshBuildOptions& options, MeshGeometry* geometry) {
+    // Cada canto de triângulo vira um registro intercalado posição (vec4) +
+    // normal (vec4) + textura (vec2). Registros idênticos são soldados logo
+    // abaixo, gerando um index buffer de verdade.
+    const size_t stride = MESH_GEOMETRY_STRIDE;
+    const bool has_normals = !model.attrib.normals.empty();
+    const bool has_texcoords = !model.attrib.texcoords.empty();
+    geometry->has_normals = has_normals;
+    geometry->has_texcoords = has_texcoords;
+
+    std::vector<GLuint>& indices = geometry->indices;
+    std::vector<float>& vertices = geometry->vertices;
+    std::vector<size_t> shape_first_index;
+    std::vector<SceneObject>& objects = geometry->objects;
+
+    for (size_t shape = 0; shape < model.shapes.size(); ++shape) {
         size_t first_index = indices.size();
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        shape_first_index.push_back(first_index);
+        size_t num_triangles = model.shapes[shape].mesh.num_face_vertices.size();
 
         for (size_t triangle = 0; triangle < num_triangles; ++triangle) {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+            assert(model.shapes[shape].mesh.num_face_vertices[triangle] == 3);
 
             for (size_t vertex = 0; vertex < 3; ++vertex) {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
+                tinyobj::index_t idx = model.shapes[shape].mesh.indices[3 * triangle + vertex];
                 indices.push_back(first_index + 3 * triangle + vertex);
 
                 // posição (vec4)
-                const float vx = model->attrib.vertices[3 * idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3 * idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3 * idx.vertex_index + 2];
-                model_coefficients.push_back(vx);
-                model_coefficients.push_back(vy);
-                model_coefficients.push_back(vz);
-                model_coefficients.push_back(1.0f);
+                vertices.push_back(model.attrib.vertices[3 * idx.vertex_index + 0]);
+                vertices.push_back(model.attrib.vertices[3 * idx.vertex_index + 1]);
+                vertices.push_back(model.attrib.vertices[3 * idx.vertex_index + 2]);
+                vertices.push_back(1.0f);
 
                 // normais (vec4)
-                if (idx.normal_index != -1) {
-                    const float nx = model->attrib.normals[3 * idx.normal_index + 0];
-                    const float ny = model->attrib.normals[3 * idx.normal_index + 1];
-                    const float nz = model->attrib.normals[3 * idx.normal_index + 2];
-                    normal_coefficients.push_back(nx);
-                    normal_coefficients.push_back(ny);
-                    normal_coefficients.push_back(nz);
-                    normal_coefficients.push_back(0.0f); // normal homogênea
+                if (has_normals && idx.normal_index != -1) {
+                    vertices.push_back(model.attrib.normals[3 * idx.normal_index + 0]);
+                    vertices.push_back(model.attrib.normals[3 * idx.normal_index + 1]);
+                    vertices.push_back(model.attrib.normals[3 * idx.normal_index + 2]);
+                }
+                else {
+                    vertices.insert(vertices.end(), 3, 0.0f);
                 }
+                vertices.push_back(0.0f); // normal homogênea
 
                 // textura (vec2)
-                if (idx.texcoord_index != -1) {
-                    const float u = model->attrib.texcoords[2 * idx.texcoord_index + 0];
-                    const float v = model->attrib.texcoords[2 * idx.texcoord_index + 1];
-                    texture_coefficients.push_back(u);
-                    texture_coefficients.push_back(v);
+                if (has_texcoords && idx.texcoord_index != -1) {
+                    vertices.push_back(model.attrib.texcoords[2 * idx.texcoord_index + 0]);
+                    vertices.push_back(model.attrib.texcoords[2 * idx.texcoord_index + 1]);
+                }
+                else {
+                    vertices.insert(vertices.end(), 2, 0.0f);
                 }
             }
         }
@@ -148,63 +207,188 @@ void Mesh::BuildTrianglesAndAddToVirtualScene(VirtualScene& scene) {
         size_t last_index = indices.size() - 1;
 
         SceneObject obj;
-        obj.name = model->shapes[shape].name;
+        obj.name = model.shapes[shape].name;
         obj.first_index = first_index;
         obj.num_indices = last_index - first_index + 1;
         obj.rendering_mode = GL_TRIANGLES;
-        obj.vao = vertex_array_object_id;
-        obj.has_color = this->has_color;
-        scene.scene_objects[obj.name] = obj;
-        this->name = obj.name; // atualiza nome do Mesh
+        obj.vao = 0;
+        obj.has_color = options.has_color;
+        objects.push_back(obj);
+    }
+    shape_first_index.push_back(indices.size());
+    const size_t base_index_count = indices.size();
+
+    // Solda de vértices e, opcionalmente, reordenação dos triângulos de cada
+    // shape para aproveitar a cache de vértices transformados da GPU.
+    const size_t separate_bytes_per_vertex = sizeof(float) * (4 + (has_normals ? 4 : 0) + (has_texcoords ? 2 : 0));
+    const size_t bytes_per_vertex = (options.vertex_layout == Mesh::Compact) ? sizeof(CompactVertex) : separate_bytes_per_vertex;
+    const size_t num_corners = indices.size();
+    size_t num_vertices = MeshOpt_WeldVertices(vertices, stride, indices);
+    geometry->num_vertices = num_vertices;
+
+    size_t invocations_welded = 0;
+    size_t invocations_final = 0;
+    size_t lod_triangles = 0;
+    for (size_t shape = 0; shape + 1 < shape_first_index.size(); ++shape) {
+        size_t first = shape_first_index[shape];
+        size_t count = shape_first_index[shape + 1] - first;
+        invocations_welded += MeshOpt_VertexShaderInvocations(indices, first, count);
+        if (options.optimize_vertex_cache)
+            MeshOpt_OptimizeVertexCache(indices, first, count, num_vertices);
+        invocations_final += MeshOpt_VertexShaderInvocations(indices, first, count);
+
+        // Níveis de detalhe: novas faixas no fim do mesmo index buffer,
+        // indexando os mesmos vértices (um VBO só para todos os níveis)
+        if (options.lod_levels <= 0)
+            continue;
+        std::vector<MeshOptLod> lods;
+        MeshOpt_BuildLodChain(vertices, stride, indices, first, count, options.lod_levels, lods);
+        for (size_t l = 0; l < lods.size(); ++l) {
+            if (options.optimize_vertex_cache)
+                MeshOpt_OptimizeVertexCache(indices, lods[l].first, lods[l].count, num_vertices);
+            SceneLod level;
+            level.first_index = lods[l].first;
+            level.num_indices = static_cast<int>(lods[l].count);
+            level.error = lods[l].error;
+            objects[shape].lods.push_back(level);
+            lod_triangles += lods[l].count / 3;
+        }
     }
 
-    // Posição
-    GLuint VBO_pos;
-    glGenBuffers(1, &VBO_pos);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), model_coefficients.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
+    printf("Mesh \"%s\": %zu -> %zu vertices, VBO %zu -> %zu bytes (%zu bytes/vertex), "
+           "vertex shader invocations %zu -> %zu (welded) -> %zu (%s), "
+           "%zu triangles + %zu in %zu levels of detail\n",
+           objects.empty() ? "" : objects.back().name.c_str(), num_corners, num_vertices,
+           num_corners * separate_bytes_per_vertex, num_vertices * bytes_per_vertex, bytes_per_vertex,
+           num_corners, invocations_welded, invocations_final,
+           options.optimize_vertex_cache ? "cache-optimized" : "original order",
+           base_index_count / 3, lod_triangles, objects.empty() ? (size_t)0 : objects.back().lods.size());
+}
 
-    // Normais
-    if (!normal_coefficients.empty()) {
-        GLuint VBO_norm;
-        glGenBuffers(1, &VBO_norm);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_norm);
-        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), normal_coefficients.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(1);
-    }
+// Cria o VAO com os buffers de "geometry"; os nomes dos buffers vão para "buffers"
+static GLuint UploadMeshGeometry(const MeshGeometry& geometry, Mesh::VertexLayout layout, std::vector<GLuint>* buffers) {
+    GLuint vertex_array_object_id;
+    glGenVertexArrays(1, &vertex_array_object_id);
+    glBindVertexArray(vertex_array_object_id);
 
-    // Coordenadas de textura
-    if (!texture_coefficients.empty()) {
-        GLuint VBO_tex;
-        glGenBuffers(1, &VBO_tex);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_tex);
-        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), texture_coefficients.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(2);
-    }
+    if (layout == Mesh::Compact)
+        UploadCompactVertexBuffer(geometry.vertices, MESH_GEOMETRY_STRIDE, geometry.num_vertices, buffers);
+    else
+        UploadSeparateVertexBuffers(geometry.vertices, MESH_GEOMETRY_STRIDE, geometry.num_vertices,
+                                    geometry.has_normals, geometry.has_texcoords, buffers);
 
     // Índices
     GLuint EBO;
     glGenBuffers(1, &EBO);
+    buffers->push_back(EBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indices.size() * sizeof(GLuint), geometry.indices.data(), GL_STATIC_DRAW);
 
     glBindVertexArray(0); // desliga VAO
+    return vertex_array_object_id;
+}
+
+// Caixa de "bounds" com as normais das faces: o que um Mesh mostra enquanto
+// o AssetLoader monta a geometria de verdade
+static void BuildBoxGeometry(const AABB& bounds, MeshGeometry* geometry) {
+    const glm::vec3 corners[2] = { bounds.min, bounds.max };
+    for (int axis = 0; axis < 3; ++axis) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        for (int side = 0; side < 2; ++side) {
+            // Anti-horário visto de fora: u x v = axis
+            static const int square[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+            GLuint first = static_cast<GLuint>(geometry->num_vertices);
+            for (int c = 0; c < 4; ++c) {
+                int k = side == 1 ? c : 3 - c;
+                float p[3];
+                p[axis] = corners[side][axis];
+                p[u] = corners[square[k][0]][u];
+                p[v] = corners[square[k][1]][v];
+                float n[3] = { 0.0f, 0.0f, 0.0f };
+                n[axis] = side == 1 ? 1.0f : -1.0f;
+                const float record[MESH_GEOMETRY_STRIDE] = {
+                    p[0], p[1], p[2], 1.0f, n[0], n[1], n[2], 0.0f,
+                    (float)square[k][0], (float)square[k][1]
+                };
+                geometry->vertices.insert(geometry->vertices.end(), record, record + MESH_GEOMETRY_STRIDE);
+                geometry->num_vertices += 1;
+            }
+            const GLuint quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+            geometry->indices.insert(geometry->indices.end(), quad, quad + 6);
+        }
+    }
+    geometry->has_normals = true;
+    geometry->has_texcoords = true;
+}
+
+void Mesh::BuildTrianglesAndAddToVirtualScene(VirtualScene& scene) {
+    MeshBuildOptions options = { has_color, optimize_vertex_cache, lod_levels, vertex_layout };
+    MeshGeometry geometry;
+    BuildMeshGeometry(*model, options, &geometry);
+    std::vector<GLuint> buffers;
+    GLuint vao = UploadMeshGeometry(geometry, vertex_layout, &buffers);
+    for (size_t i = 0; i < geometry.objects.size(); ++i) {
+        geometry.objects[i].vao = vao;
+        this->scene_handle = scene.add(geometry.objects[i]);
+        this->name = geometry.objects[i].name; // atualiza nome do Mesh
+    }
+}
+
+void Mesh::LoadAndAddToVirtualScene(VirtualScene& scene, AssetLoader& loader) {
+    // Já no primeiro quadro cada shape aparece como a caixa do modelo, com o
+    // material e o transform do Mesh
+    MeshGeometry box;
+    BuildBoxGeometry(local_bounds, &box);
+    std::vector<GLuint> box_buffers;
+    GLuint box_vao = UploadMeshGeometry(box, vertex_layout, &box_buffers);
+    std::vector<SceneHandle> handles;
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
+        SceneObject obj;
+        obj.name = model->shapes[shape].name;
+        obj.first_index = 0;
+        obj.num_indices = static_cast<int>(box.indices.size());
+        obj.rendering_mode = GL_TRIANGLES;
+        obj.vao = box_vao;
+        obj.has_color = this->has_color;
+        this->scene_handle = scene.add(obj);
+        this->name = obj.name; // atualiza nome do Mesh
+        handles.push_back(this->scene_handle);
+    }
+
+    // A geometria de verdade é montada por um worker e trocada pela caixa no
+    // envio. O job só guarda cópias: o modelo é compartilhado e imutável.
+    MeshBuildOptions options = { has_color, optimize_vertex_cache, lod_levels, vertex_layout };
+    ModelHandle source = model;
+    VirtualScene* target = &scene;
+    AssetLoader* uploads = &loader;
+    loader.submit([source, options, target, handles, box_vao, box_buffers, uploads]() {
+        std::shared_ptr<MeshGeometry> geometry(new MeshGeometry());
+        BuildMeshGeometry(*source, options, geometry.get());
+        uploads->queueUpload([geometry, options, target, handles, box_vao, box_buffers]() {
+            std::vector<GLuint> buffers;
+            GLuint vao = UploadMeshGeometry(*geometry, options.vertex_layout, &buffers);
+            for (size_t i = 0; i < handles.size() && i < geometry->objects.size(); ++i) {
+                const SceneObject& obj = geometry->objects[i];
+                if (target->isValid(handles[i]))
+                    target->setGeometry(handles[i], vao, obj.first_index, obj.num_indices, obj.lods);
+            }
+            glDeleteVertexArrays(1, &box_vao);
+            glDeleteBuffers(static_cast<GLsizei>(box_buffers.size()), box_buffers.data());
+        });
+    });
 }
 
 Mesh::Mesh(std::string filename) {
-    model = new ObjModel(filename.c_str());
+    loadModel(filename);
     puts("Mesh::Mesh(): Model loaded successfully.");
-    ComputeNormals();
     transform = Matrix_Identity();
     this->body = new RigidBody();
+    updateLocalBounds();
 }
 Mesh::~Mesh() {
-    delete model;
     delete body;
+    delete collision_bvh;
     puts("Mesh::~Mesh(): Model and body deleted successfully.");
 }
 
@@ -247,8 +431,11 @@ glm::vec3 Mesh::compute_bbox_max(const tinyobj::attrib_t& attrib) {
 
 
 void Mesh::updateTransform() {
-    glm::vec4 translate = body->getPosition();
-    glm::vec3 rotate = body->getRotation();
+    updateTransform(body->getPosition(), body->getRotation());
+}
+
+void Mesh::updateTransform(const glm::vec4& translate, const glm::vec4& rotation) {
+    glm::vec3 rotate = rotation;
     glm::vec4 scale = body->getScale();
     glm::vec3 pivot = body->getPivot();
 
@@ -263,104 +450,107 @@ void Mesh::updateTransform() {
     glm::mat4 Pi = Matrix_Translate(-pivot.x, -pivot.y, -pivot.z);
 
     transform = T * P * R * S * Pi;
+    object_uniforms.setModel(transform); // Normal matrix is precomputed here, not per vertex
+    world_bounds = AABB_Transform(local_bounds, transform);
+    world_sphere = BoundingSphere_Transform(local_sphere, transform);
 }
 
-void Mesh::sendTransform(GLint program_id) {
-    // Envia a matriz de transformação para o shader
-    glUniformMatrix4fv(program_id, 1, GL_FALSE, glm::value_ptr(transform));
+void Mesh::updateLocalBounds() {
+    const std::vector<tinyobj::real_t>& verts = model->attrib.vertices;
+    const float* xyz = verts.empty() ? NULL : &verts[0];
+    local_bounds = AABB_FromPoints(xyz, verts.size() / 3);
+    local_sphere = BoundingSphere_FromPoints(xyz, verts.size() / 3, local_bounds);
+    local_center = body->ComputeRigidBodyCenter(verts);
+    // world_bounds/world_sphere follow on the next updateTransform()
 }
 
-// Em geometrics.cpp:
-
-void Mesh::rescale(float sx, float sy, float sz) {
-    // 1) Escala **de verdade** os atributos de vértice:
-    auto& verts = this->model->attrib.vertices;  // std::vector<float>
-    for (size_t i = 0; i < verts.size(); i += 3) {
-        verts[i + 0] *= sx;
-        verts[i + 1] *= sy;
-        verts[i + 2] *= sz;
-    }
-
-    this->ComputeNormals();
+void Mesh::sendTransform() {
+    // Envia as matrizes model e normal para o shader. "transform" é público e
+    // pode ter sido alterado diretamente; setModel() não faz nada se for igual.
+    object_uniforms.setModel(transform);
+    object_uniforms.bind();
+}
 
-    glm::vec4 center = body->ComputeRigidBodyCenter(this->model);
-    body->setPivot(glm::vec4(center));
+// Em geometrics.cpp:
 
+void Mesh::loadModel(const std::string& filename) {
+    model_path = filename;
+    model_scale = glm::vec3(1.0f);
+    model = g_AssetCache.acquireModel(model_path);
 }
 
-void Mesh::LoadTextureImage(const char* filename)
-{
-    printf("Carregando imagem \"%s\"... ", filename);
-
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
-    int width;
-    int height;
-    int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
-
-    if ( data == NULL )
-    {
-        fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filename);
-        std::exit(EXIT_FAILURE);
-    }
-
-    printf("OK (%dx%d).\n", width, height);
+void Mesh::rescale(float sx, float sy, float sz) {
+    // Escala **de verdade** os vértices: o modelo compartilhado nessa escala
+    // (com as normais já recalculadas) substitui o atual, que não é alterado.
+    model_scale *= glm::vec3(sx, sy, sz);
+    model = g_AssetCache.acquireModel(model_path, model_scale);
 
-    // Agora criamos objetos na GPU com OpenGL para armazenar a textura
-    GLuint texture_id;
-    GLuint sampler_id;
-    glGenTextures(1, &texture_id);
-    glGenSamplers(1, &sampler_id);
+    updateLocalBounds();
+    if (collision_bvh != nullptr)
+        buildCollisionBVH(); // Já registrada para colisão: acompanha os vértices
 
-    // Veja slides 95-96 do documento Aula_20_Mapeamento_de_Texturas.pdf
-    glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    body->setPivot(local_center);
 
-    // Parâmetros de amostragem da textura.
-    glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
 
-    // Agora enviamos a imagem lida do disco para a GPU
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+void Mesh::buildCollisionBVH() {
+    // Um triângulo por trio de índices (o modelo é carregado triangulado)
+    std::vector<unsigned> indices;
+    for (const tinyobj::shape_t& shape : model->shapes)
+        for (const tinyobj::index_t& index : shape.mesh.indices)
+            indices.push_back(static_cast<unsigned>(index.vertex_index));
+    if (collision_bvh == nullptr)
+        collision_bvh = new MeshBVH();
+    collision_bvh->build(model->attrib.vertices, indices);
+}
 
-    GLuint textureunit = g_NumLoadedTextures;
-    glActiveTexture(GL_TEXTURE0 + textureunit);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindSampler(textureunit, sampler_id);
+CollisionMesh Mesh::getCollisionMesh() {
+    if (collision_bvh == nullptr)
+        buildCollisionBVH();
+    CollisionMesh mesh = { collision_bvh, transform };
+    return mesh;
+}
 
-    stbi_image_free(data);
+void Mesh::LoadTextureImage(const char* filename, AssetLoader* loader)
+{
+    texture = g_AssetCache.acquireTexture(filename, loader);
+    if (!sampler)
+        sampler = g_AssetCache.acquireSampler(GL_CLAMP_TO_EDGE);
+    use_texture = true;
+    texture_id = texture->texture_id; // getTextureId() follows "texture" when it loads
+    this->sampler_id = sampler->sampler_id;
+}
 
-    g_NumLoadedTextures += 1;
-    this->setTexture(texture_id); // Set the texture ID in the Mesh class
+void Mesh::setTextureWrap(GLenum wrap)
+{
+    if (sampler_id == 0)
+        return;
+    sampler = g_AssetCache.acquireSampler(wrap);
+    sampler_id = sampler->sampler_id;
 }
 
 
 Cube::Cube(float size, std::string model_filename) {
     this->size = size;
     width = height = depth = size; // Set width, height, and depth to size
-    model = new ObjModel(model_filename.c_str());
+    loadModel(model_filename);
     body = new RigidBody();
     rescale(size, size, size); // Rescale to size
     setPivot(getMeshCenter());
     transform = Matrix_Identity();
-    ComputeNormals();
 }
 Cube::Cube(float size, std::string model_filename, glm::vec4 position) : Cube(size, model_filename) {
     body->setPosition(position);
 }
 Cube::Cube(float width, float height, float depth, std::string model_filename, glm::vec4 position) {
-    model = new ObjModel(model_filename.c_str());
+    this->width = width;
+    this->height = height;
+    this->depth = depth;
+    loadModel(model_filename);
     body = new RigidBody();
     rescale(width, height, depth); // Rescale to width, height, and depth
     setPivot(getMeshCenter());
     transform = Matrix_Identity();
-    ComputeNormals();
     for (const auto& v : model->attrib.vertices) {
         // Print the vertex coordinates
         std::cout << "Vertex: " << v << std::endl;
@@ -373,7 +563,7 @@ Cube::Cube(float width, float height, float depth, std::string model_filename, g
 Plane::Plane(float width, float height, std::string model_filename) {
     this->width = width;
     this->height = height;
-    model = new ObjModel(model_filename.c_str());
+    loadModel(model_filename);
     body = new RigidBody();
     transform = Matrix_Identity();
     rescale(width, height, 1.0f); // Rescale to width and height
@@ -388,14 +578,13 @@ Plane::Plane(float width, float height, glm::vec4 position, std::string model_fi
 
 Ball::Ball(float radius, std::string model_filename) {
 
-    model = new ObjModel(model_filename.c_str());
+    loadModel(model_filename);
     body = new RigidBody();
     transform = Matrix_Identity();
     rescale(radius, radius, radius); // Rescale to the radius
     //body->setScale(glm::vec4(radius, radius, radius, 1.0f)); // Set scale to radius
     setPivot(getMeshCenter());
     this->radius = radius; // Set the radius of the ball
-    ComputeNormals();
 }
 Ball::Ball(float radius, glm::vec4 position, std::string model_filename) : Ball(radius, model_filename) {
     body->setPosition(position);
@@ -404,12 +593,11 @@ Ball::Ball(float radius, glm::vec4 position, std::string model_filename) : Ball(
 Cylinder::Cylinder(float radius, float height, std::string model_filename) {
     this->radius = radius;
     this->height = height;
-    model = new ObjModel(model_filename.c_str());
+    loadModel(model_filename);
     body = new RigidBody();
-    setPivot(getMeshCenter());
     rescale(radius, height, radius); // Rescale to radius and height
+    setPivot(getMeshCenter());
     transform = Matrix_Identity();
-    ComputeNormals();
 }
 Cylinder::Cylinder(float radius, float height, glm::vec4 position, std::string model_filename) : Cylinder(radius, height, model_filename) {
     body->setPosition(position);
@@ -417,72 +605,49 @@ Cylinder::Cylinder(float radius, float height, glm::vec4 position, std::string m
 
 void Ball::testCollisionWithPlane(Plane* plane) {
     // Test collision with a plane
-    collisor col;
-    if (col.SphereToPlane(*this, *plane)) {
-        glm::vec4 normal = plane->normal; // Get the normal vector of the plane
-        glm::vec4 velocity = body->getVelocity(); // Get the velocity of the ball
-        glm::vec4 v_normal = glm::dot(velocity, normal) * normal;
-        glm::vec4 v_tangential = velocity - v_normal; // Calculate the tangential velocity
-        body->setVelocity(-v_normal + v_tangential); // Set the velocity of the ball to the tangential velocity
-
-        glm::vec4 normal_force = -glm::dot(g, normal) * normal * body->getMass();
-
-        body->addForce(normal_force);
+    if (Collision_RespondToPlane(*body, getCollisionSphere(), plane->getCollisionPlane()))
         isGrounded = true;
-
-    }
-    
 }
 
 void Ball::testCollisionWithCube(Cube* cube) {
-    collisor col;
+    Collision_RespondToBox(*body, getCollisionSphere(), cube->getCollisionBox(), BALL_RESPAWN_POSITION);
+}
 
-    if (col.SphereToCube(*this, *cube)) {
-        //std::cout << "Collision with cube detected!" << std::endl;
-        body->setPosition(glm::vec4 (0.0f,3.0f,0.0f,1.0f));
-        body->resetAcceleration();
-        body->resetVelocity();
+void Ball::testCollisionWithCylinder(Cylinder* cylinder) {
+    Collision_RespondToCylinder(*body, getCollisionSphere(), cylinder->getCollisionCylinder());
+}
 
-    }
+bool collisor::SphereToPlane(Ball &ball, Plane &plane) {
+    return Collision_SphereToPlane(ball.getCollisionSphere(), ball.body->getFuturePosition(), plane.getCollisionPlane());
+}
+
+bool collisor::SphereToCube(Ball& ball, Cube& cube) {
+    return Collision_SphereToBox(ball.getCollisionSphere(), cube.getCollisionBox());
+}
 
+bool collisor::SphereToCylinder(Ball &ball, Cylinder &cylinder) {
+    return Collision_SphereToCylinder(ball.getCollisionSphere(), cylinder.getCollisionCylinder());
+}
 
-    
+bool collisor::SphereToCylinderBottom(Ball &ball, Cylinder &cylinder) {
+    return Collision_SphereToCylinderBottom(ball.getCollisionSphere(), cylinder.getCollisionCylinder());
 }
-void Ball::testCollisionWithCylinder(Cylinder* cylinder) {
-    collisor col;
-    //If ball in the radius of the cylinder, turn off the normal force
-    if(col.SphereToCylinder(*this, *cylinder)) {
-        this->body->resetForce();
-        this->body->addForce(g); //Only gravity force
-        //std::cout << "Collision with radius of cylinder detected!" << std::endl;
-    }
-    if(col.SphereToCylinderBottom(*this, *cylinder)) {
-        //If ball hit the bottom of the cylinder, turn on normal force
-      //  std::cout << "Collision with bottom of cylinder detected!" << std::endl;
-        glm::vec4 normal = glm::normalize(getCenter() - cylinder->getCenter());
-        glm::vec4 velocity = body->getVelocity(); // Get the velocity of the ball
-        glm::vec4 v_normal = glm::dot(velocity, normal) * normal;
-        glm::vec4 v_tangential = velocity - v_normal; // Calculate the tangential velocity
-        body->setVelocity(-v_normal + v_tangential); // Set the velocity of
-        // the ball to the tangential velocity
-        glm::vec4 normal_force = -glm::dot(g, normal) * normal * body->getMass();
-        body->addForce(normal_force);
-    }
 
+bool collisor::SphereToSphere(Ball &ball1, Ball &ball2) {
+    return Collision_SphereToSphere(ball1.getCollisionSphere(), ball2.getCollisionSphere());
 }
 
 GolfClub::GolfClub(float length, float width, float height, std::string model_filename) {
     this->length = length;
     this->width = width;
     this->height = height;
-    model = new ObjModel(model_filename.c_str());
+    loadModel(model_filename);
     body = new RigidBody();
     transform = Matrix_Identity();
-    ComputeNormals();
     rescale(length, width, height); // Rescale the golf club to the specified dimensions
     setPivot(getMeshCenter());
     //body->setScale(glm::vec4(length, width, height, 1.0f)); // Set scale to length, width, and height
-    glm::vec3 club_size = getMeshSize(model); // Get the size of the golf club mesh
+    glm::vec3 club_size = getMeshSize(model.get()); // Get the size of the golf club mesh
     collision_box = new Cube(length, width, height, "../../assets/objects/unit_cube.obj", this->body->getPosition());
     collision_box->rescale(club_size.x, club_size.y, club_size.z);
     collision_box->body = this->body; // Set the collision box's body to the golf club's body
@@ -553,28 +718,41 @@ void GolfClub::move(GLFWwindow* window) {
     body->setVelocity(direction * speed); // Define a velocidade do golf club
 }
 
-void BezierCurve::setTrajectoryFromVelocity(glm::vec4 p0, glm::vec4 v0, glm::vec4 a, float bounce_factor)
-{
-    float g = -a.y; // aceleração da gravidade (valor positivo)
-    if (g <= 0.0f) return;
-
-    // Tempo para atingir o ponto mais alto
-    float t1 = v0.y / g;
-    // Ponto mais alto
-    glm::vec4 p1 = p0 + v0 * t1 + 0.5f * a * (t1 * t1);
-
-    float delta = (v0.y * v0.y) - (2.0f * g * p0.y);
-    if (delta < 0.0f) delta = 0.0f;
-    float t2 = (v0.y + sqrt(delta)) / g;
-
-    // Ponto final 
-    glm::vec4 p3 = p0 + v0 * t2 + 0.5f * a * (t2 * t2);
+TrajectoryPreview::TrajectoryPreview(size_t points) : capacity(static_cast<GLsizei>(points)) {
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    object_uniforms.setModel(glm::mat4(1.0f));
+}
 
-    glm::vec4 p2 = p1;
+TrajectoryPreview::~TrajectoryPreview() {
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+}
 
-    // Define os pontos de controle da curva de Bézier
-    setPoints({ p0, p1, p2, p3 });
-    computeInterpolatedPoints(0.01f);
-    config();
+void TrajectoryPreview::update(const std::vector<glm::vec4>& points) {
+    count = std::min(static_cast<GLsizei>(points.size()), capacity);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    // Órfão: o desenho do quadro anterior continua lendo o bloco antigo
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+    if (count > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec4), points.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void TrajectoryPreview::draw(ShaderProgram& program) {
+    if (count < 2)
+        return;
+    program.set(render_as_black_uniform.get(program), true);
+    program.set(use_instancing_uniform.get(program), false);
+    object_uniforms.bind();
+    glBindVertexArray(vao);
+    glLineWidth(10.0f);
+    glDrawArrays(GL_LINE_STRIP, 0, count);
+    glBindVertexArray(0);
+}
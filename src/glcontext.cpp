@@ -1,38 +1,210 @@
 #include "../include/glcontext.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+#include <algorithm>
 
 
-void VirtualScene::drawAll(GLuint programID) {
-    for (auto const& object : scene_objects) {
+int SceneObject_SelectLod(const SceneObject& object, float pixels_per_unit, int current) {
+    int lod = 0;
+    for (size_t l = 1; l <= object.lods.size(); ++l) {
+        float pixels = object.lods[l - 1].error * pixels_per_unit;
+        float limit = (int)l > current ? LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS) : LOD_PIXEL_ERROR;
+        if (pixels > limit)
+            break; // Os erros só crescem ao longo da cadeia
+        lod = (int)l;
+    }
+    return lod;
+}
+
+void SceneObject_LodRange(const SceneObject& object, int lod, size_t* first_index, int* num_indices) {
+    if (lod <= 0 || object.lods.empty()) {
+        *first_index = object.first_index;
+        *num_indices = object.num_indices;
+        return;
+    }
+    const SceneLod& level = object.lods[std::min<size_t>(lod, object.lods.size()) - 1];
+    *first_index = level.first_index;
+    *num_indices = level.num_indices;
+}
+
+SceneHandle VirtualScene::add(const SceneObject& object) {
+    uint32_t index;
+    if (!free_slots.empty()) {
+        index = free_slots.back();
+        free_slots.pop_back();
+    }
+    else {
+        index = static_cast<uint32_t>(objects.size());
+        objects.push_back(SceneObject());
+    }
+    // A geração do slot sobrevive à reutilização, invalidando handles antigos
+    uint32_t generation = objects[index].generation;
+    objects[index] = object;
+    objects[index].generation = generation;
+    objects[index].alive = true;
+
+    SceneHandle handle = { index, generation };
+    names[object.name] = handle;
+    return handle;
+}
+
+void VirtualScene::remove(SceneHandle handle) {
+    if (!isValid(handle))
+        return;
+    SceneObject& object = objects[handle.index];
+    if (object.instance_vbo != 0)
+        glDeleteBuffers(1, &object.instance_vbo);
+
+    auto it = names.find(object.name);
+    if (it != names.end() && it->second.index == handle.index && it->second.generation == handle.generation)
+        names.erase(it);
+
+    uint32_t generation = object.generation + 1;
+    object = SceneObject();
+    object.generation = generation;
+    free_slots.push_back(handle.index);
+}
+
+bool VirtualScene::isValid(SceneHandle handle) const {
+    return handle.index < objects.size()
+        && objects[handle.index].alive
+        && objects[handle.index].generation == handle.generation;
+}
+
+SceneHandle VirtualScene::find(const std::string& objectName) const {
+    auto it = names.find(objectName);
+    if (it == names.end())
+        return INVALID_SCENE_HANDLE;
+    return it->second;
+}
+
+const SceneObject& VirtualScene::getObject(SceneHandle handle) const {
+    if (!isValid(handle))
+        throw std::runtime_error("Invalid handle for the virtual scene");
+    return objects[handle.index];
+}
+
+// Liga o buffer de instâncias ao VAO atualmente ligado, como atributos por
+// instância. Um matN ocupa N localizações consecutivas, uma por coluna.
+static void AttachInstanceAttributes(GLuint instance_vbo) {
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    for (GLuint column = 0; column < 3; ++column) {
+        GLuint location = INSTANCE_NORMAL_MATRIX_LOCATION + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(offsetof(InstanceData, normal_matrix) + column * sizeof(glm::vec3)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void VirtualScene::setGeometry(SceneHandle handle, GLuint vao, size_t first_index, int num_indices, const std::vector<SceneLod>& lods) {
+    SceneObject& object = checkedObject(handle);
+    object.vao = vao;
+    object.first_index = first_index;
+    object.num_indices = num_indices;
+    object.lods = lods;
+    if (object.instance_vbo != 0) {
+        // As instâncias ficam no mesmo buffer; só o VAO novo precisa apontar para ele
+        glBindVertexArray(vao);
+        AttachInstanceAttributes(object.instance_vbo);
+        glBindVertexArray(0);
+    }
+}
+
+SceneObject& VirtualScene::checkedObject(SceneHandle handle) {
+    if (!isValid(handle))
+        throw std::runtime_error("Invalid handle for the virtual scene");
+    return objects[handle.index];
+}
+
+void VirtualScene::drawAll(ShaderProgram& program) {
+    int render_as_black = render_as_black_uniform.get(program);
+    program.set(use_instancing_uniform.get(program), false);
+    for (auto const& object : objects) {
+      if (!object.alive)
+        continue;
       // desenha cada um
-      glUniform1i(glGetUniformLocation(programID, "render_as_black"), object.second.has_color ? 0 : 1);
-      glBindVertexArray(object.second.vao);
+      program.set(render_as_black, !object.has_color);
+      glBindVertexArray(object.vao);
       glDrawElements(
-        object.second.rendering_mode,
-        object.second.num_indices,
+        object.rendering_mode,
+        object.num_indices,
         GL_UNSIGNED_INT,
-        (void*)(object.second.first_index * sizeof(GLuint))
+        (void*)(object.first_index * sizeof(GLuint))
       );
     }
     glBindVertexArray(0);
   }
 
-  void VirtualScene::draw(GLuint programID, const std::string& objectName) {
-    auto it = scene_objects.find(objectName);
-    if (it != scene_objects.end()) {
-        const SceneObject& object = it->second;
-
-        glUniform1i(glGetUniformLocation(programID, "render_as_black"), object.has_color ? 0 : 1);
-        glBindVertexArray(object.vao);
-        glDrawElements(
-            object.rendering_mode,
-            object.num_indices,
-            GL_UNSIGNED_INT,
-            (void*)(object.first_index * sizeof(GLuint))
-        );
-        glBindVertexArray(0);
-        
-    } else {
-        throw std::runtime_error("Object not found in the virtual scene: " + objectName);
+  void VirtualScene::draw(ShaderProgram& program, SceneHandle handle) {
+    const SceneObject& object = checkedObject(handle);
+
+    program.set(render_as_black_uniform.get(program), !object.has_color);
+    program.set(use_instancing_uniform.get(program), false);
+    glBindVertexArray(object.vao);
+    glDrawElements(
+        object.rendering_mode,
+        object.num_indices,
+        GL_UNSIGNED_INT,
+        (void*)(object.first_index * sizeof(GLuint))
+    );
+    glBindVertexArray(0);
+  }
+
+  void VirtualScene::setInstances(SceneHandle handle, const std::vector<glm::mat4>& transforms) {
+    SceneObject& object = checkedObject(handle);
+
+    glBindVertexArray(object.vao);
+    if (object.instance_vbo == 0) {
+        glGenBuffers(1, &object.instance_vbo);
+        AttachInstanceAttributes(object.instance_vbo);
     }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, object.instance_vbo);
+    }
+
+    GLsizei count = static_cast<GLsizei>(transforms.size());
+    if (count > object.instance_capacity) {
+        // Cresce em potências de dois para não realocar a cada instância nova
+        GLsizei capacity = object.instance_capacity > 0 ? object.instance_capacity : 1;
+        while (capacity < count)
+            capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_DYNAMIC_DRAW);
+        object.instance_capacity = capacity;
+    }
+    if (count > 0) {
+        std::vector<InstanceData> instances(count);
+        for (GLsizei i = 0; i < count; ++i) {
+            instances[i].model = transforms[i];
+            instances[i].normal_matrix = glm::inverseTranspose(glm::mat3(transforms[i]));
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), instances.data());
+    }
+    object.instance_count = count;
+
+    glBindVertexArray(0);
+  }
+
+  void VirtualScene::drawInstanced(ShaderProgram& program, SceneHandle handle) {
+    const SceneObject& object = checkedObject(handle);
+    if (object.instance_count == 0)
+        return;
+
+    program.set(render_as_black_uniform.get(program), !object.has_color);
+    program.set(use_instancing_uniform.get(program), true);
+    glBindVertexArray(object.vao);
+    glDrawElementsInstanced(
+        object.rendering_mode,
+        object.num_indices,
+        GL_UNSIGNED_INT,
+        (void*)(object.first_index * sizeof(GLuint)),
+        object.instance_count
+    );
+    glBindVertexArray(0);
   }
-  
\ No newline at end of file
@@ -0,0 +1,122 @@
+//Small work-stealing job system
+#include "../include/jobsystem.hpp"
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threads) : queued_jobs(0) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // A última fila recebe os jobs das threads que chamam parallelFor()
+    for (unsigned i = 0; i < threads; ++i)
+        queues.push_back(new Queue());
+    for (unsigned i = 0; i + 1 < threads; ++i)
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, static_cast<size_t>(i)));
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    for (size_t i = 0; i < queues.size(); ++i)
+        delete queues[i];
+}
+
+void JobSystem::parallelFor(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& job) {
+    if (count == 0)
+        return;
+    if (chunk == 0)
+        chunk = 1;
+    const size_t num_chunks = (count + chunk - 1) / chunk;
+
+    if (workers.empty() || num_chunks == 1) {
+        // Mesmos pedaços, na ordem, sem passar pelas filas
+        for (size_t first = 0; first < count; first += chunk)
+            job(first, std::min(first + chunk, count));
+        return;
+    }
+
+    // Cada fila recebe um bloco contíguo de pedaços (melhor para a cache);
+    // o roubo equilibra quando os blocos demoram tempos diferentes.
+    // A contagem sobe antes dos pushes: um worker acordado pode tirar um job
+    // assim que ele entra na fila, e o fetch_sub não pode passar de zero.
+    std::atomic<size_t> pending(num_chunks);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued_jobs += num_chunks;
+    }
+    const size_t num_queues = queues.size();
+    for (size_t q = 0; q < num_queues; ++q) {
+        size_t begin = q * num_chunks / num_queues;
+        size_t end = (q + 1) * num_chunks / num_queues;
+        if (begin == end)
+            continue;
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        for (size_t c = begin; c < end; ++c) {
+            size_t first = c * chunk;
+            size_t last = std::min(first + chunk, count);
+            Job j;
+            j.run = [&job, first, last]() { job(first, last); };
+            j.pending = &pending;
+            queues[q]->jobs.push_back(j);
+        }
+    }
+    wake.notify_all();
+
+    // Quem chamou também trabalha até todos os pedaços terminarem
+    const size_t own = num_queues - 1;
+    while (pending.load(std::memory_order_acquire) > 0) {
+        Job j;
+        if (popJob(own, j) || stealJob(own, j)) {
+            j.run();
+            j.pending->fetch_sub(1, std::memory_order_release);
+        }
+        else {
+            std::this_thread::yield(); // Os últimos pedaços estão rodando em workers
+        }
+    }
+}
+
+bool JobSystem::popJob(size_t queue, Job& job) {
+    Queue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.jobs.empty())
+        return false;
+    job = q.jobs.front();
+    q.jobs.pop_front();
+    queued_jobs.fetch_sub(1);
+    return true;
+}
+
+bool JobSystem::stealJob(size_t thief, Job& job) {
+    // Rouba do fim das outras filas, longe de onde a dona está consumindo
+    for (size_t k = 1; k < queues.size(); ++k) {
+        Queue& q = *queues[(thief + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.empty())
+            continue;
+        job = q.jobs.back();
+        q.jobs.pop_back();
+        queued_jobs.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::workerLoop(size_t index) {
+    for (;;) {
+        Job job;
+        if (popJob(index, job) || stealJob(index, job)) {
+            job.run();
+            job.pending->fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this]() { return quit || queued_jobs.load() > 0; });
+        if (quit)
+            return;
+    }
+}
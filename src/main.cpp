@@ -22,14 +22,13 @@
 #include "../include/glcontext.hpp"
 #include "../include/tiny_obj_loader.h"
 #include "../include/collisions.hpp"
-
-// Identificador que define qual objeto está sendo desenhado no momento
-#define BALL   0
-#define CLUB  1
-#define WALL  2
-#define FLOOR 3
-#define VEGETATION 4
-#define CLOUDS 5
+#include "../include/physicsscheduler.hpp"
+#include "../include/scenequery.hpp"
+#include "../include/simulation.hpp"
+#include "../include/trajectory.hpp"
+#include "../include/materials.hpp"
+#include "../include/renderqueue.hpp"
+#include "../include/assetloader.hpp"
 
 // Declaration of several functions used in main(). These are defined
 // right after the definition of main() in this file.
@@ -39,6 +38,9 @@ GLuint LoadShader_Vertex(const char* filename);   // Loads a vertex shader
 GLuint LoadShader_Fragment(const char* filename); // Loads a fragment shader
 void LoadShader(const char* filename, GLuint shader_id); // Function used by the two above
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Creates a GPU program
+void SubmitMesh(RenderQueue& queue, VirtualScene& scene, Mesh* mesh, Camera* camera); // Queues the draw of a mesh
+void SubmitInstances(RenderQueue& queue, VirtualScene& scene, Mesh* mesh, const AABB& bounds, bool blended = false); // Queues an instanced draw
+AABB InstancesBounds(Mesh* mesh, const std::vector<glm::mat4>& transforms); // World bounds of all instances of a mesh
 
 // Declaration of helper functions to render text inside the OpenGL window.
 // These functions are defined in the file "textrendering.cpp".
@@ -80,6 +82,8 @@ std::map<const char*, SceneObject> g_VirtualScene;
 
 // Window aspect ratio (width/height). See FramebufferSizeCallback() function.
 float g_ScreenRatio = 1.0f;
+// Framebuffer height in pixels, for level of detail selection. See FramebufferSizeCallback().
+int g_FramebufferHeight = 800;
 
 // Euler angles that control the rotation of one of the cubes in the virtual scene
 float g_AngleX = 0.0f;
@@ -112,6 +116,7 @@ bool g_ShowInfoText = true;
 
 // Variables that define a GPU program (shaders). See LoadShadersFromFiles() function.
 GLuint g_GpuProgramID = 0;
+ShaderProgram g_GpuProgram; // Uniform table of g_GpuProgramID, filled once after linking
 
 
 bool aimEnabled = false; // Set to true to enable aiming at the ball
@@ -206,6 +211,31 @@ int main() {
 
     printf("GPU: %s, %s, OpenGL %s, GLSL %s\n", vendor, renderer, glversion, glslversion);
 
+    // Assets load in the background (see "assetloader.hpp"): the models are
+    // parsed by its workers while the shaders compile, and the meshes and
+    // textures are drawn with placeholders until their uploads are done.
+    //
+    // The models are not fully deferred: each Mesh constructor below waits
+    // for its parse, since the physics needs its bounds and pivot at once.
+    // The first frame waits for the slowest model (the parses run in
+    // parallel); only the GPU uploads and the textures come later.
+    AssetLoader asset_loader;
+    enum CourseModel {
+        MODEL_GOLF_BALL, MODEL_FLOOR, MODEL_ROOF, MODEL_CLOUD, MODEL_UNIT_CUBE,
+        MODEL_WALL_NORTH, MODEL_WALL_SOUTH, MODEL_WALL_EAST, MODEL_WALL_WEST, MODEL_HOLE,
+        MODEL_COUNT
+    };
+    // Prefetched here and passed to the constructors, so the two never differ
+    static const char* const model_files[MODEL_COUNT] = {
+        "../../assets/objects/golf_ball.obj", "../../assets/objects/floor.obj",
+        "../../assets/objects/roof.obj", "../../assets/objects/cloud.obj",
+        "../../assets/objects/unit_cube.obj", "../../assets/objects/wall_north.obj",
+        "../../assets/objects/wall_south.obj", "../../assets/objects/wall_east.obj",
+        "../../assets/objects/wall_west.obj", "../../assets/objects/hole.obj"
+    };
+    for (const char* model_file : model_files)
+        g_AssetCache.prefetchModel(model_file, asset_loader);
+
     // We load the vertex and fragment shaders that will be used
     // for rendering. See slides 180-200 of the document Aula_03_Rendering_Pipeline_Grafico.pdf.
     //
@@ -215,12 +245,16 @@ int main() {
     // We initialize the code for text rendering.
     TextRendering_Init();
 
-    // We get the address of the variables defined inside the Vertex Shader.
-    // We will use these variables to send data to the video card
-    // (GPU)! See file "shader_vertex.glsl".
-    GLint model_uniform = glGetUniformLocation(g_GpuProgramID, "model"); // "model" matrix variable
-    GLint view_uniform = glGetUniformLocation(g_GpuProgramID, "view"); // "view" matrix variable in shader_vertex.glsl
-    GLint projection_uniform = glGetUniformLocation(g_GpuProgramID, "projection"); // "projection" matrix variable in shader_vertex.glsl
+    // Matrices and camera/light data reach the shaders through uniform
+    // buffers: FrameData is filled once per frame by the camera, ObjectData
+    // by each Mesh (see "uniformbuffers.hpp").
+    FrameUniformBuffer frame_uniforms;
+    frame_uniforms.setLightDirection(glm::normalize(glm::vec4(0.8f, 1.0f, 0.5f, 0.0f)));
+
+    // Surface parameters of every object, indexed per draw (see "materials.hpp")
+    MaterialTable materials;
+    materials.loadFromFile("../../assets/materials.txt");
+    materials.bind();
     // We enable the Z-buffer. See slides 104-116 of the document Aula_09_Projecoes.pdf.
     glEnable(GL_DEPTH_TEST);
 
@@ -245,11 +279,12 @@ int main() {
     float floor_width = 5.0f; // Largura do piso
     float roof_height = wall_height * 4 * 2;
 
-    Ball* ball = new Ball(0.02f, "../../assets/objects/golf_ball.obj");
-    Plane* floor = new Plane(floor_width, floor_length, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), "../../assets/objects/floor.obj");
-    Plane* roof = new Plane(floor_width, floor_length, glm::vec4(0.0f, roof_height, 0.0f, 1.0f), "../../assets/objects/roof.obj");
-    Cube* cloud = new Cube(10.0f, "../../assets/objects/cloud.obj", glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-    Cube *void_zone = new Cube(floor_width*100, 10.0f, floor_length*100,  "../../assets/objects/unit_cube.obj", glm::vec4(0.0f, -30.0f, 0.0f, 1.0f));
+    Ball* ball = new Ball(COURSE_BALL_RADIUS, model_files[MODEL_GOLF_BALL]);
+    Plane* floor = new Plane(floor_width, floor_length, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), model_files[MODEL_FLOOR]);
+    Plane* roof = new Plane(floor_width, floor_length, glm::vec4(0.0f, roof_height, 0.0f, 1.0f), model_files[MODEL_ROOF]);
+    Cube* cloud = new Cube(10.0f, model_files[MODEL_CLOUD], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    const glm::vec3 void_zone_size = 2.0f * COURSE_VOID_ZONE_HALF_SIZE;
+    Cube *void_zone = new Cube(void_zone_size.x, void_zone_size.y, void_zone_size.z, model_files[MODEL_UNIT_CUBE], glm::vec4(0.0f, COURSE_VOID_ZONE_Y, 0.0f, 1.0f));
 
     floor->body->setPosition(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
     ball->body->setPosition(glm::vec4(0.1f, 2.0f, 0.8f, 1.0f));
@@ -261,14 +296,15 @@ int main() {
 
 
 
-    Plane* wall_north = new Plane(wall_width, wall_height, "../../assets/objects/wall_north.obj");
-    Plane* wall_south = new Plane(wall_width, wall_height, "../../assets/objects/wall_south.obj");
-    Plane* wall_east = new Plane(wall_width, wall_height, "../../assets/objects/wall_east.obj");
-    Plane* wall_west = new Plane(wall_width, wall_height, "../../assets/objects/wall_west.obj");
-    wall_north->body->setPosition(glm::vec4(0.0f, -wall_height / 4, -wall_width * 4, 1.0f));
-    wall_south->body->setPosition(glm::vec4(0.0f, -wall_height / 4, wall_width * 4, 1.0f));
-    wall_east->body->setPosition(glm::vec4(wall_width * 4, -wall_height / 4, 0.0f, 1.0f));
-    wall_west->body->setPosition(glm::vec4(-wall_width * 4, -wall_height / 4, 0.0f, 1.0f));
+    Plane* wall_north = new Plane(wall_width, wall_height, model_files[MODEL_WALL_NORTH]);
+    Plane* wall_south = new Plane(wall_width, wall_height, model_files[MODEL_WALL_SOUTH]);
+    Plane* wall_east = new Plane(wall_width, wall_height, model_files[MODEL_WALL_EAST]);
+    Plane* wall_west = new Plane(wall_width, wall_height, model_files[MODEL_WALL_WEST]);
+    // Onde GolfCourse_AddColliders() põe os planos das paredes
+    wall_north->body->setPosition(glm::vec4(0.0f, COURSE_WALL_Y, -COURSE_WALL_DISTANCE, 1.0f));
+    wall_south->body->setPosition(glm::vec4(0.0f, COURSE_WALL_Y, COURSE_WALL_DISTANCE, 1.0f));
+    wall_east->body->setPosition(glm::vec4(COURSE_WALL_DISTANCE, COURSE_WALL_Y, 0.0f, 1.0f));
+    wall_west->body->setPosition(glm::vec4(-COURSE_WALL_DISTANCE, COURSE_WALL_Y, 0.0f, 1.0f));
 
     wall_north->normal = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
     wall_south->normal = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
@@ -287,25 +323,32 @@ int main() {
     walls.push_back(wall_west);
 
     for (auto& wall : walls) {
-        wall->setID(WALL); // Set the ID of the wall
-        wall->addToVirtualScene(*virtual_scene); // Add the walls to the virtual scene
-        wall->LoadTextureImage("../../assets/textures/sky.jpg"); // Load the wall texture
-        meshes.push_back(wall);
+        wall->setMaterial(materials.find("wall")); // Set the material of the wall
+        wall->updateTransform(); // Walls never move: their transforms are computed once
     }
+    // The four wall OBJs hold the same quad, so only the first one goes to the
+    // virtual scene and is drawn once per wall with instancing.
+    walls[0]->addToVirtualScene(*virtual_scene, &asset_loader);
+    walls[0]->LoadTextureImage("../../assets/textures/sky.jpg", &asset_loader); // Load the wall texture
+    std::vector<glm::mat4> wall_transforms;
+    for (Plane* wall : walls)
+        wall_transforms.push_back(wall->getTransform());
     
-    floor->LoadTextureImage("../../assets/textures/forrest_ground_01_diff_1k.jpg");
+    floor->LoadTextureImage("../../assets/textures/forrest_ground_01_diff_1k.jpg", &asset_loader);
 
 
-    roof->LoadTextureImage("../../assets/textures/sky.jpg");
-    ball->LoadTextureImage("../../assets/textures/blue_metal_plate_diff_2k.jpg");
-    cloud->LoadTextureImage("../../assets/textures/aerial_beach_01_diff_1k.jpg");
+    roof->LoadTextureImage("../../assets/textures/sky.jpg", &asset_loader);
+    floor->setTextureWrap(GL_REPEAT); // Floor and roof tile their textures
+    roof->setTextureWrap(GL_REPEAT);
+    ball->LoadTextureImage("../../assets/textures/blue_metal_plate_diff_2k.jpg", &asset_loader);
+    cloud->LoadTextureImage("../../assets/textures/aerial_beach_01_diff_1k.jpg", &asset_loader);
     
 
-    ball->setID(BALL); // Set the ID of the ball
-    //golf_club->setID(CLUB); // Set the ID of the golf club
-    floor->setID(VEGETATION); // Set the ID of the floor
-    cloud->setID(CLOUDS); // Set the ID of the cloud
-    roof->setID(WALL); // Set the ID of the roof
+    ball->setMaterial(materials.find("ball")); // Set the material of the ball
+    //golf_club->setMaterial(materials.find("club")); // Set the material of the golf club
+    floor->setMaterial(materials.find("vegetation")); // Set the material of the floor
+    cloud->setMaterial(materials.find("clouds")); // Set the material of the cloud
+    roof->setMaterial(materials.find("wall")); // Set the material of the roof
 
 
     int count_clouds = 10; // Number of clouds to create
@@ -329,25 +372,55 @@ int main() {
         cloud_transforms.push_back(cloud->getTransform()); // Store the transform of the cloud
     }
 
-    float radius = 0.6f; // Radius of the hole
-    float height = 1.5f; // Height of the hole
-    Cylinder* hole = new Cylinder(radius, height, "../../assets/objects/hole.obj");
-    hole->body->setPosition(glm::vec4(10.0f, -height + 0.01f, 0.0f, 1.0f)); // Set the position of the hole
+    Cylinder* hole = new Cylinder(COURSE_HOLE_RADIUS, COURSE_HOLE_HEIGHT, model_files[MODEL_HOLE]);
+    hole->body->setPosition(COURSE_HOLE_CENTER); // Set the position of the hole
     meshes.push_back(floor);
     meshes.push_back(roof);
     meshes.push_back(ball);
     meshes.push_back(hole);
 
-    ball->addToVirtualScene(*virtual_scene);
-    cloud->addToVirtualScene(*virtual_scene);
-    hole->addToVirtualScene(*virtual_scene);
-    roof->addToVirtualScene(*virtual_scene);
-    floor->addToVirtualScene(*virtual_scene);
-
-    ball->body->setMass(0.2f); // Set the mass of the ball
-
-
-    BezierCurve* bezier_curve = new BezierCurve();
+    ball->addToVirtualScene(*virtual_scene, &asset_loader);
+    cloud->addToVirtualScene(*virtual_scene, &asset_loader);
+    hole->addToVirtualScene(*virtual_scene, &asset_loader);
+    roof->addToVirtualScene(*virtual_scene, &asset_loader);
+    floor->addToVirtualScene(*virtual_scene, &asset_loader);
+
+    virtual_scene->setInstances(walls[0]->getSceneHandle(), wall_transforms);
+    virtual_scene->setInstances(cloud->getSceneHandle(), cloud_transforms);
+    AABB walls_bounds = InstancesBounds(walls[0], wall_transforms); // Instances never move
+    AABB clouds_bounds = InstancesBounds(cloud, cloud_transforms);
+
+    ball->body->setMass(COURSE_BALL_MASS); // Set the mass of the ball
+
+
+    RenderQueue render_queue; // Draws of each frame, sorted to minimize state changes
+
+    // Colliders of the fixed-step physics loop: the same course as the
+    // headless GolfSimulation (see "simulation.hpp")
+    BroadPhase broad_phase;
+    broad_phase.addBall(ball->body, ball->radius, &ball->isGrounded);
+    GolfCourse_AddColliders(broad_phase);
+
+    // The same static objects, for the ray casts of the aiming preview and
+    // of the camera
+    SceneQuery scene_query;
+    scene_query.addPlane(floor->getCollisionPlane());
+    for (Plane* wall : walls)
+        scene_query.addPlane(wall->getCollisionPlane());
+    scene_query.addBox(void_zone->getCollisionBox());
+    scene_query.addCylinder(hole->getCollisionCylinder());
+
+    // Aim preview: the shot simulated with the physics step on a copy of the
+    // ball, drawn as a line strip
+    TrajectoryPredictor trajectory_predictor(ball->radius);
+    trajectory_predictor.getBroadPhase().addStatics(broad_phase);
+    TrajectoryPreview trajectory_preview(TRAJECTORY_PREVIEW_STEPS + 1);
+    std::vector<glm::vec4> trajectory_points;
+
+    const AssetCacheStats& asset_stats = g_AssetCache.getStats();
+    printf("Assets: %u models loaded (%u by the loader), %u scaled, %u shared; %u textures loaded, %u shared; %u samplers\n",
+           asset_stats.model_loads, asset_stats.model_prefetches, asset_stats.model_imports, asset_stats.model_hits,
+           asset_stats.texture_loads, asset_stats.texture_hits, asset_stats.sampler_creates);
 
     std::cout << "Running the Mini-Golf 3D simulation...\n";
     camera_distance = lookatcam->camera_distance;
@@ -355,43 +428,58 @@ int main() {
     glm::vec4 ball_position = ball->getCenter();
     glm::vec4 camera_position = ball_position + glm::vec4(r,r,r,0.0f);
 
-    double accumulator = 0.0f;
-    const 
-    float dt = 1.0f / 60.0f; // Fixed time step for physics updates
-    int count = 0; // Counter for the number of physics updates
-    int max_updates = 2; // Maximum number of physics updates per frame	
+    // Physics at 60 Hz, at most 4 steps per frame; a frame longer than 0.25 s
+    // (a stall) only advances the simulation by 0.25 s.
+    PhysicsScheduler physics_scheduler(60.0f, 4, 0.25);
+    const float dt = physics_scheduler.getStepTime(); // Fixed time step for physics updates
+    // State of each mesh before the last physics step; the frame is drawn
+    // between it and the current state, see PhysicsScheduler::getAlpha().
+    std::vector<BodyState> previous_states;
+    for (Mesh* mesh : meshes)
+        previous_states.push_back(mesh->body->getState());
+    bool first_frame = true; // Startup times are printed once, measured from glfwInit()
+    bool assets_loaded = false;
     while (!glfwWindowShouldClose(window)) {
         double currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;       // frametime in seconds :contentReference[oaicite:1]{index=1},
-        accumulator += deltaTime; // Accumulate the time elapsed since the last frame
         lastFrame = currentFrame;
-        while (accumulator >= dt && count < max_updates) {
-            count++;
-            
-            ball->body->update(dt); // Update the ball's physics state
-            ball->testCollisionWithPlane(floor); // Test collision with the floor
-            for (Plane* wall : walls) {
-                ball->testCollisionWithPlane(wall); // Test collision with the walls
-            }
-            
-            //Update unessential physics
-            ball->testCollisionWithCube(void_zone); // Test collision with the void zone
-            ball->testCollisionWithCylinder(hole);
 
-             // Test collision with the hole
+        // GL side of the asset loading, a little every frame
+        asset_loader.processUploads(ASSETLOADER_UPLOAD_BUDGET_MS);
+        if (!assets_loaded && asset_loader.isIdle()) {
+            AssetLoaderStats loader_stats = asset_loader.getStats();
+            printf("Assets loaded after %.1f ms: %u jobs, %u uploads taking %.1f ms (at most %.1f ms per frame), "
+                   "%u waits for a full upload queue\n",
+                   glfwGetTime() * 1000.0, loader_stats.jobs, loader_stats.uploads, loader_stats.upload_ms,
+                   loader_stats.max_frame_upload_ms, loader_stats.full_waits);
+            assets_loaded = true;
+        }
+        int physics_steps = physics_scheduler.advance(deltaTime);
+        for (int step = 0; step < physics_steps; ++step) {
+            for (size_t i = 0; i < meshes.size(); ++i)
+                previous_states[i] = meshes[i]->body->getState();
 
-            accumulator = accumulator - dt; // Decrease the accumulated time by the fixed time step
+            ball->body->addForce(g * ball->body->getMass()); // Gravity, once per step
+            ball->body->update(dt); // Update the ball's physics state
+            broad_phase.update(); // Find the pairs whose bounds overlap
+            broad_phase.dispatch(); // Narrow phase and response for each of them
         }
-        count = 0; // Reset the counter for the number of physics updates
+        const float alpha = physics_scheduler.getAlpha();
+        glm::vec4 ball_render_position = ball->body->getPosition();
 
 
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glUseProgram(g_GpuProgramID);
         
-        for (Mesh* mesh : meshes)
-            mesh->updateTransform();
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            BodyState state = BodyState_Interpolate(previous_states[i], meshes[i]->body->getState(), alpha);
+            meshes[i]->updateTransform(state.position, state.rotation);
+            if (meshes[i] == ball)
+                ball_render_position = state.position;
+        }
         glm::vec4 view_vector;
+        Camera* active_camera = isFreeCamera ? (Camera*)freecam : (Camera*)lookatcam; // Used for levels of detail
         if (isFreeCamera) {
             axis = -1.0f; // set axis to -1.0f for free camera
             // golf_club->controller = false; // Disable controller for the golf club when using free camera
@@ -401,7 +489,8 @@ int main() {
                 freecam->setCameraAngles();
                 freecam->move(window, deltaTime);
             }
-            freecam->sendToGPU(view_uniform, projection_uniform); // Send the view and projection matrices to the GPU
+            freecam->sendToGPU(frame_uniforms); // Send the view and projection matrices to the GPU
+            render_queue.setFrustum(freecam->getFrustum()); // Skip objects the camera cannot see
             the_projection = freecam->getProjection();
             the_view = freecam->getView();
             view_vector = freecam->getViewVector(); // Get the view vector of the camera
@@ -414,18 +503,23 @@ int main() {
             
 
             if(!test.aim){
-                ball_position = ball->getCenter();
+                ball_position = ball_render_position; // Interpolated, like the ball drawn
                 float cam_x = r * lookatcam->pitch;
                 float cam_y = r * lookatcam->yaw;
                 float cam_z = r * lookatcam->roll;
                 camera_position = ball_position + glm::vec4(cam_x, cam_y, cam_z, 0.0f);
+                // Câmera na frente do que estiver entre ela e a bola
+                SceneHit camera_hit;
+                if (scene_query.segmentCast(ball_position, camera_position, &camera_hit))
+                    camera_position = camera_hit.point + camera_hit.normal * 0.05f;
             }
 
             lookatcam->setCameraAngles(); // Atualiza pitch/yaw/roll com o mouse
             
             lookatcam->setPosition(camera_position);
             lookatcam->setView(ball_position); // Câmera sempre olha para a bola
-            lookatcam->sendToGPU(view_uniform, projection_uniform);
+            lookatcam->sendToGPU(frame_uniforms);
+            render_queue.setFrustum(lookatcam->getFrustum());
             the_view = lookatcam->getView();
             the_projection = lookatcam->getProjection();
             view_vector = lookatcam->getViewVector();
@@ -436,9 +530,6 @@ int main() {
         ball->testCollisionWithCube(void_zone);
         ball->testCollisionWithCylinder(hole);
 
-        float m = ball->body->getMass(); // Get the mass of the ball
-        glm::vec4 mg = g * m; // Calculate the gravitational force
-        ball->body->addForce(mg); // Apply gravitational force to the ball
 
         if (test.teleport) {
             freecam->setPosition(ball->body->getPosition()); // Set the camera position to the ball's position
@@ -493,12 +584,11 @@ int main() {
             ball->body->resetForce();
             ball->body->resetAcceleration();
             ball->body->resetVelocity();
-            glm::vec4 p0 = ball->getCenter();
-            p0.y += 0.5f; // Slightly above the ground
-            bezier_curve->setTrajectoryFromVelocity(p0, velocity, g, 1.0f);
-            bezier_curve->transform = ball->getTransform(); // Get the transformation matrix of the ball
-
-
+            RigidBody shot = *ball->body; // The shot of test.hit below, on a copy
+            shot.setVelocity(velocity);
+            shot.setAngularAcceleration(velocity);
+            trajectory_predictor.predict(shot, dt, TRAJECTORY_PREVIEW_STEPS, trajectory_points);
+            trajectory_preview.update(trajectory_points);
         }
         if(test.hit){
             test.hit = false;
@@ -508,12 +598,16 @@ int main() {
         }
         // golf_club->animate(deltaTime, window); // Animate the golf club
         if(test.debug){
-            bezier_curve->printInterpolatedPoints(); // Print the interpolated points of the Bezier curve
+            for (const glm::vec4& point : trajectory_points)
+                printf("Trajectory Point: (%f, %f, %f, %f)\n", point.x, point.y, point.z, point.w);
         }
         if(test.aim){
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(bezier_curve->transform));
-            bezier_curve->draw(g_GpuProgramID); // Draw the Bezier curve
+            trajectory_preview.draw(g_GpuProgram); // Draw the predicted trajectory
         }
+        // Walls: one instanced draw for the four of them. Only the material of
+        // their ObjectData is used when instancing.
+        SubmitInstances(render_queue, *virtual_scene, walls[0], walls_bounds);
+
         for (Mesh* mesh : meshes) {
 
 
@@ -521,6 +615,7 @@ int main() {
                 std::cout << "Mesh: " << mesh->getName() << ", Position: " << glm::to_string(mesh->body->getPosition()) << std::endl;
                 std::cout << "Mesh: " << mesh->getName() << ", Transform: " << glm::to_string(mesh->transform) << std::endl;
                 std::cout << "Mesh: " << mesh->getName() << ", Center: " << glm::to_string(mesh->getCenter()) << std::endl;
+                std::cout << "Mesh: " << mesh->getName() << ", Level of detail: " << mesh->getLod() << std::endl;
 
                 
             }
@@ -539,50 +634,31 @@ int main() {
                 test.reset = false; // Reset the reset flag
             }
 
-            if (mesh->isTextured()) {
-                glUniform1i(glGetUniformLocation(g_GpuProgramID, "use_texture"), true);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, mesh->getTextureId());
-                glUniform1i(glGetUniformLocation(g_GpuProgramID, "texture_diffuse"), 0);
-
-                
-                glSamplerParameteri(mesh->getTextureId(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glSamplerParameteri(mesh->getTextureId(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-                if (mesh->getName() == "floor" || mesh->getName() == "roof") {
-                    glSamplerParameteri(mesh->getTextureId(), GL_TEXTURE_WRAP_S, GL_REPEAT);
-                    glSamplerParameteri(mesh->getTextureId(), GL_TEXTURE_WRAP_T, GL_REPEAT);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-                }
-
-                
-            }
-            else {
-                glUniform1i(glGetUniformLocation(g_GpuProgramID, "use_texture"), false);
-            }
-            mesh->sendTransform(model_uniform); // Set the transformation matrix for the mesh
-            virtual_scene->draw(g_GpuProgramID, mesh->getName());
+            SubmitMesh(render_queue, *virtual_scene, mesh, active_camera);
 
         }
-        test.debug = false;
-        
-        
-        
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        for (glm::mat4 transform : cloud_transforms) {
-
-            cloud->setTransform(transform); // Set the transformation matrix for each cloud
-            cloud->sendTransform(model_uniform); // Set the transformation matrix for the cloud
-            virtual_scene->draw(g_GpuProgramID, cloud->getName()); // Draw the cloud    
+        // All the clouds at once, blended after the opaque objects
+        SubmitInstances(render_queue, *virtual_scene, cloud, clouds_bounds, true);
+        render_queue.flush(); // Sorted by program/texture/VAO, see "renderqueue.hpp"
+
+        if (test.debug) {
+            const RenderStats& stats = render_queue.getStats();
+            std::cout << "Render: " << stats.draw_calls << " draws, " << stats.triangles << " triangles, " << stats.culled << " culled, "
+                      << stats.stateChanges() << " state changes ("
+                      << stats.program_binds << " programs, " << stats.texture_binds << " textures, "
+                      << stats.vao_binds << " VAOs, " << stats.buffer_binds << " UBOs, "
+                      << stats.blend_changes << " blend, " << stats.uniform_uploads << " uniforms)" << std::endl;
         }
-        glDisable(GL_BLEND);
+        test.debug = false;
 
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (first_frame) {
+            printf("First frame after %.1f ms\n", glfwGetTime() * 1000.0);
+            first_frame = false;
+        }
     }
 
     // We finalize the use of operating system resources
@@ -592,6 +668,51 @@ int main() {
     return 0;
 }
 
+// Queues the draw of a mesh with its texture, sampler and ObjectData. The
+// queue culls it with the world bounds from Mesh::updateTransform(), and the
+// level of detail comes from how big the mesh looks through "camera".
+void SubmitMesh(RenderQueue& queue, VirtualScene& scene, Mesh* mesh, Camera* camera) {
+    DrawItem item;
+    item.program = &g_GpuProgram;
+    item.object = &scene.getObject(mesh->getSceneHandle());
+    item.lod = mesh->selectLod(*item.object, camera->getPixelsPerUnit(glm::vec4(mesh->getWorldSphere().center, 1.0f), (float)g_FramebufferHeight));
+    if (mesh->isTextured()) {
+        item.texture = mesh->getTextureId();
+        item.sampler = mesh->getSamplerId();
+    }
+    item.object_uniforms = mesh->getObjectUniforms();
+    item.has_bounds = true;
+    item.bounds = mesh->getWorldBounds();
+    item.sphere = mesh->getWorldSphere();
+    queue.submit(item);
+}
+
+// Queues one draw of every transform given to VirtualScene::setInstances().
+// The whole batch is culled at once, with "bounds" covering all instances.
+void SubmitInstances(RenderQueue& queue, VirtualScene& scene, Mesh* mesh, const AABB& bounds, bool blended) {
+    DrawItem item;
+    item.program = &g_GpuProgram;
+    item.object = &scene.getObject(mesh->getSceneHandle());
+    if (mesh->isTextured()) {
+        item.texture = mesh->getTextureId();
+        item.sampler = mesh->getSamplerId();
+    }
+    item.object_uniforms = mesh->getObjectUniforms(); // Only its material is used
+    item.instanced = true;
+    item.blended = blended;
+    item.has_bounds = true;
+    item.bounds = bounds;
+    item.sphere = BoundingSphere_FromAABB(bounds);
+    queue.submit(item);
+}
+
+AABB InstancesBounds(Mesh* mesh, const std::vector<glm::mat4>& transforms) {
+    AABB bounds = AABB_Empty();
+    for (size_t i = 0; i < transforms.size(); ++i)
+        AABB_Extend(bounds, AABB_Transform(mesh->getLocalBounds(), transforms[i]));
+    return bounds;
+}
+
 // Loads a Vertex Shader from a GLSL file. See definition of LoadShader() below.
 GLuint LoadShader_Vertex(const char* filename) {
     // We create an identifier (ID) for this shader, informing that it will
@@ -716,6 +837,12 @@ void LoadShadersFromFiles() {
 
     // We create a GPU program using the shaders loaded above.
     g_GpuProgramID = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
+
+    // We read the table of active uniforms once, right after linking.
+    g_GpuProgram.reflect(g_GpuProgramID);
+    g_GpuProgram.bindUniformBlock("FrameData", FRAME_UNIFORM_BINDING);
+    g_GpuProgram.bindUniformBlock("ObjectData", OBJECT_UNIFORM_BINDING);
+    g_GpuProgram.bindUniformBlock("MaterialData", MATERIAL_UNIFORM_BINDING);
 }
 
 // This function creates a GPU program, which must contain
@@ -781,6 +908,7 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
     // The cast to float is necessary because integer numbers are rounded when
     // divided!
     g_ScreenRatio = (float)width / height;
+    g_FramebufferHeight = height;
 }
 
 // Global variables that store the last mouse cursor position, so
@@ -0,0 +1,51 @@
+//Read-only view of a whole file
+#include "../include/mappedfile.hpp"
+#include <cstdio>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define MAPPEDFILE_USE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const char* filename) {
+#ifdef MAPPEDFILE_USE_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = static_cast<const char*>(p);
+            size = static_cast<size_t>(st.st_size);
+            mapped = true;
+        }
+    }
+    close(fd);
+#else
+    FILE* f = fopen(filename, "rb");
+    if (f == NULL)
+        return;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long length = ftell(f);
+        if (length > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            buffer.resize(static_cast<size_t>(length));
+            if (fread(&buffer[0], 1, buffer.size(), f) == buffer.size()) {
+                data = &buffer[0];
+                size = buffer.size();
+            }
+        }
+    }
+    fclose(f);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPEDFILE_USE_MMAP
+    if (mapped)
+        munmap(const_cast<char*>(data), size);
+#endif
+}
@@ -0,0 +1,81 @@
+//Surface materials shared by all draws through a uniform buffer
+#include "../include/materials.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+MaterialTable::~MaterialTable() {
+    if (ubo != 0)
+        glDeleteBuffers(1, &ubo);
+}
+
+bool MaterialTable::loadFromFile(const char* filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        fprintf(stderr, "ERROR: Cannot open material file \"%s\".\n", filename);
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#')
+            continue;
+
+        Material material;
+        glm::vec4& kd = material.diffuse;
+        glm::vec4& ks = material.specular;
+        glm::vec4& ka = material.ambient;
+        if (!(fields >> kd.r >> kd.g >> kd.b >> ks.r >> ks.g >> ks.b >> ka.r >> ka.g >> ka.b >> ks.w >> kd.w)) {
+            fprintf(stderr, "WARNING: %s:%d: malformed material \"%s\", ignored.\n", filename, line_number, name.c_str());
+            continue;
+        }
+        ka.w = 0.0f;
+        if (add(name, material) < 0)
+            fprintf(stderr, "WARNING: %s:%d: more than %d materials, \"%s\" ignored.\n", filename, line_number, MAX_MATERIALS, name.c_str());
+    }
+    return true;
+}
+
+int MaterialTable::add(const std::string& name, const Material& material) {
+    int index = find(name);
+    if (index == MATERIAL_VERTEX_COLOR) {
+        if (materials.size() >= MAX_MATERIALS)
+            return -1;
+        index = static_cast<int>(materials.size());
+        names.push_back(name);
+        materials.push_back(material);
+    }
+    else {
+        materials[index] = material;
+    }
+    dirty = true;
+    return index;
+}
+
+int MaterialTable::find(const std::string& name) const {
+    for (size_t i = 0; i < names.size(); ++i)
+        if (names[i] == name)
+            return static_cast<int>(i);
+    return MATERIAL_VERTEX_COLOR;
+}
+
+void MaterialTable::bind() {
+    if (ubo == 0) {
+        // Always allocate the full array declared in the shader, so indexing
+        // past the loaded materials never reads outside the buffer.
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(Material), NULL, GL_STATIC_DRAW);
+    }
+    if (dirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        if (!materials.empty())
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, materials.size() * sizeof(Material), &materials[0]);
+        dirty = false;
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_UNIFORM_BINDING, ubo);
+}
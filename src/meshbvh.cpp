@@ -0,0 +1,349 @@
+//Bounding volume hierarchy of triangle meshes
+#include "../include/meshbvh.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Custo de atravessar um nó, em testes de triângulo (heurística SAH)
+static const float MESHBVH_TRAVERSAL_COST = 1.0f;
+
+static float SurfaceArea(const AABB& box) {
+    if (AABB_IsEmpty(box))
+        return 0.0f;
+    glm::vec3 d = box.max - box.min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Quadrado da distância de p à caixa (0 dentro dela)
+static float DistanceSquared(const AABB& box, const glm::vec3& p) {
+    glm::vec3 d = glm::max(glm::max(box.min - p, p - box.max), glm::vec3(0.0f));
+    return glm::dot(d, d);
+}
+
+glm::vec3 Triangle_ClosestPoint(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    // Regiões de Voronoi dos vértices, das arestas e da face, nesta ordem
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+void MeshBVH::build(const std::vector<float>& vertices, const std::vector<unsigned>& indices) {
+    nodes.clear();
+    triangles.clear();
+    triangle_ids.clear();
+    bounds = AABB_Empty();
+
+    // Triângulos com índices válidos e área não nula, com caixa e centróide
+    const size_t num_vertices = vertices.size() / 3;
+    std::vector<Triangle> input;
+    std::vector<int> input_ids;
+    std::vector<AABB> boxes;
+    std::vector<glm::vec3> centroids;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        if (indices[t] >= num_vertices || indices[t + 1] >= num_vertices || indices[t + 2] >= num_vertices)
+            continue;
+        Triangle triangle;
+        triangle.a = glm::vec3(vertices[3 * indices[t]], vertices[3 * indices[t] + 1], vertices[3 * indices[t] + 2]);
+        triangle.b = glm::vec3(vertices[3 * indices[t + 1]], vertices[3 * indices[t + 1] + 1], vertices[3 * indices[t + 1] + 2]);
+        triangle.c = glm::vec3(vertices[3 * indices[t + 2]], vertices[3 * indices[t + 2] + 1], vertices[3 * indices[t + 2] + 2]);
+        glm::vec3 n = glm::cross(triangle.b - triangle.a, triangle.c - triangle.a);
+        if (glm::dot(n, n) <= 0.0f)
+            continue; // Degenerado: as arestas dos vizinhos já o cobrem
+        AABB box = AABB_Empty();
+        AABB_Extend(box, triangle.a);
+        AABB_Extend(box, triangle.b);
+        AABB_Extend(box, triangle.c);
+        input.push_back(triangle);
+        input_ids.push_back(static_cast<int>(t / 3));
+        boxes.push_back(box);
+        centroids.push_back((triangle.a + triangle.b + triangle.c) / 3.0f);
+    }
+    if (input.empty())
+        return;
+
+    std::vector<int> order(input.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<int>(i);
+    triangles.reserve(input.size());
+    triangle_ids.reserve(input.size());
+
+    // Construção em profundidade com pilha explícita. O filho da esquerda é
+    // empilhado por último, então é criado logo depois do pai; o da direita
+    // grava seu índice no pai ("parent") quando for criado.
+    struct Task {
+        int parent;
+        int first;
+        int count;
+        int depth;
+    };
+    std::vector<Task> stack;
+    Task root = { -1, 0, static_cast<int>(order.size()), 0 };
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+        const int index = static_cast<int>(nodes.size());
+        if (task.parent >= 0)
+            nodes[task.parent].first = index;
+
+        Node node;
+        node.bounds = AABB_Empty();
+        AABB centroid_bounds = AABB_Empty();
+        for (int i = task.first; i < task.first + task.count; ++i) {
+            AABB_Extend(node.bounds, boxes[order[i]]);
+            AABB_Extend(centroid_bounds, centroids[order[i]]);
+        }
+
+        // SAH por baldes: para cada eixo, custo de cada fronteira entre baldes
+        int best_axis = -1;
+        int best_split = 0; // Baldes [0, best_split] vão para a esquerda
+        float best_cost = std::numeric_limits<float>::max();
+        if (task.count > MESHBVH_LEAF_SIZE && task.depth < MESHBVH_MAX_DEPTH) {
+            for (int axis = 0; axis < 3; ++axis) {
+                float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+                if (!(extent > 0.0f))
+                    continue;
+                AABB bin_bounds[MESHBVH_BINS];
+                int bin_count[MESHBVH_BINS] = { 0 };
+                for (int b = 0; b < MESHBVH_BINS; ++b)
+                    bin_bounds[b] = AABB_Empty();
+                float scale = MESHBVH_BINS / extent;
+                for (int i = task.first; i < task.first + task.count; ++i) {
+                    int b = std::min(MESHBVH_BINS - 1, static_cast<int>((centroids[order[i]][axis] - centroid_bounds.min[axis]) * scale));
+                    bin_count[b]++;
+                    AABB_Extend(bin_bounds[b], boxes[order[i]]);
+                }
+                // Áreas e contagens acumuladas da direita para a esquerda
+                float right_area[MESHBVH_BINS];
+                int right_count[MESHBVH_BINS];
+                AABB right = AABB_Empty();
+                int count = 0;
+                for (int b = MESHBVH_BINS - 1; b > 0; --b) {
+                    AABB_Extend(right, bin_bounds[b]);
+                    count += bin_count[b];
+                    right_area[b] = SurfaceArea(right);
+                    right_count[b] = count;
+                }
+                AABB left = AABB_Empty();
+                count = 0;
+                for (int b = 0; b < MESHBVH_BINS - 1; ++b) {
+                    AABB_Extend(left, bin_bounds[b]);
+                    count += bin_count[b];
+                    if (count == 0 || right_count[b + 1] == 0)
+                        continue;
+                    float cost = count * SurfaceArea(left) + right_count[b + 1] * right_area[b + 1];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = b;
+                    }
+                }
+            }
+        }
+
+        // Divide só se atravessar o nó e testar os filhos sai mais barato que
+        // testar todos os triângulos dele
+        const float area = SurfaceArea(node.bounds);
+        if (best_axis >= 0 && MESHBVH_TRAVERSAL_COST * area + best_cost < task.count * area) {
+            const int axis = best_axis;
+            const float min = centroid_bounds.min[axis];
+            const float scale = MESHBVH_BINS / (centroid_bounds.max[axis] - min);
+            const int split = best_split;
+            std::vector<int>::iterator middle = std::partition(order.begin() + task.first, order.begin() + task.first + task.count,
+                [&](int t) { return std::min(MESHBVH_BINS - 1, static_cast<int>((centroids[t][axis] - min) * scale)) <= split; });
+            int left_count = static_cast<int>(middle - order.begin()) - task.first;
+            if (left_count > 0 && left_count < task.count) {
+                node.first = -1; // Preenchido quando o filho da direita for criado
+                node.count = 0;
+                nodes.push_back(node);
+                Task right_task = { index, task.first + left_count, task.count - left_count, task.depth + 1 };
+                Task left_task = { -1, task.first, left_count, task.depth + 1 };
+                stack.push_back(right_task);
+                stack.push_back(left_task);
+                continue;
+            }
+        }
+
+        // Folha: os triângulos são copiados na ordem em que as folhas aparecem
+        node.first = static_cast<int>(triangles.size());
+        node.count = task.count;
+        nodes.push_back(node);
+        for (int i = task.first; i < task.first + task.count; ++i) {
+            triangles.push_back(input[order[i]]);
+            triangle_ids.push_back(input_ids[order[i]]);
+        }
+    }
+    bounds = nodes[0].bounds;
+}
+
+void MeshBVH::testTriangle(int index, const glm::vec3& point, float& best_sq, MeshContact* contact) const {
+    const Triangle& triangle = triangles[index];
+    glm::vec3 closest = Triangle_ClosestPoint(point, triangle.a, triangle.b, triangle.c);
+    glm::vec3 d = point - closest;
+    float distance_sq = glm::dot(d, d);
+    if (distance_sq > best_sq || (distance_sq == best_sq && contact->triangle >= 0))
+        return;
+    best_sq = distance_sq;
+    contact->point = closest;
+    contact->distance = std::sqrt(distance_sq);
+    contact->triangle = triangle_ids[index];
+    if (contact->distance > 1e-6f)
+        contact->normal = d / contact->distance;
+    else
+        contact->normal = glm::normalize(glm::cross(triangle.b - triangle.a, triangle.c - triangle.a)); // Ponto sobre a face
+}
+
+bool MeshBVH::closestPoint(const glm::vec3& point, float max_distance, MeshContact* contact) const {
+    if (nodes.empty() || max_distance < 0.0f)
+        return false;
+    float best_sq = max_distance * max_distance;
+    contact->triangle = -1;
+
+    // Cada nível empilha no máximo um nó a mais do que desempilha
+    int stack[MESHBVH_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const int index = stack[--top];
+        const Node& node = nodes[index];
+        if (DistanceSquared(node.bounds, point) > best_sq)
+            continue; // O melhor triângulo melhorou depois que o nó foi empilhado
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                testTriangle(i, point, best_sq, contact);
+            continue;
+        }
+        // O filho mais próximo sai primeiro da pilha
+        int near_child = index + 1;
+        int far_child = node.first;
+        float near_sq = DistanceSquared(nodes[near_child].bounds, point);
+        float far_sq = DistanceSquared(nodes[far_child].bounds, point);
+        if (far_sq < near_sq) {
+            std::swap(near_child, far_child);
+            std::swap(near_sq, far_sq);
+        }
+        if (far_sq <= best_sq)
+            stack[top++] = far_child;
+        if (near_sq <= best_sq)
+            stack[top++] = near_child;
+    }
+    return contact->triangle >= 0;
+}
+
+void MeshBVH::intersectTriangle(int index, const glm::vec3& origin, const glm::vec3& direction, float& best_t, MeshHit* hit) const {
+    // Möller-Trumbore, dos dois lados do triângulo
+    const Triangle& triangle = triangles[index];
+    glm::vec3 e1 = triangle.b - triangle.a;
+    glm::vec3 e2 = triangle.c - triangle.a;
+    glm::vec3 p = glm::cross(direction, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f)
+        return; // Raio paralelo ao triângulo
+    float inverse_det = 1.0f / det;
+    glm::vec3 s = origin - triangle.a;
+    float u = glm::dot(s, p) * inverse_det;
+    if (u < 0.0f || u > 1.0f)
+        return;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(direction, q) * inverse_det;
+    if (v < 0.0f || u + v > 1.0f)
+        return;
+    float t = glm::dot(e2, q) * inverse_det;
+    if (t < 0.0f || t > best_t || (t == best_t && hit->triangle >= 0))
+        return;
+    best_t = t;
+    hit->t = t;
+    hit->point = origin + t * direction;
+    hit->normal = glm::normalize(glm::cross(e1, e2));
+    if (glm::dot(hit->normal, direction) > 0.0f)
+        hit->normal = -hit->normal;
+    hit->triangle = triangle_ids[index];
+}
+
+bool MeshBVH::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float max_t, MeshHit* hit) const {
+    if (nodes.empty() || max_t < 0.0f || direction == glm::vec3(0.0f))
+        return false;
+    const glm::vec3 inverse_direction = 1.0f / direction;
+    float best_t = max_t;
+    hit->triangle = -1;
+
+    int stack[MESHBVH_MAX_DEPTH + 2];
+    int top = 0;
+    float t_enter;
+    if (!AABB_IntersectRay(nodes[0].bounds, origin, inverse_direction, best_t, &t_enter))
+        return false;
+    stack[top++] = 0;
+    while (top > 0) {
+        const int index = stack[--top];
+        const Node& node = nodes[index];
+        if (!AABB_IntersectRay(node.bounds, origin, inverse_direction, best_t, &t_enter))
+            continue; // Já há acerto antes de o raio chegar a este nó
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                intersectTriangle(i, origin, direction, best_t, hit);
+            continue;
+        }
+        // O filho em que o raio entra primeiro sai primeiro da pilha
+        int near_child = index + 1;
+        int far_child = node.first;
+        float near_t, far_t;
+        bool near_hit = AABB_IntersectRay(nodes[near_child].bounds, origin, inverse_direction, best_t, &near_t);
+        bool far_hit = AABB_IntersectRay(nodes[far_child].bounds, origin, inverse_direction, best_t, &far_t);
+        if (near_hit && far_hit && far_t < near_t) {
+            std::swap(near_child, far_child);
+        }
+        else if (!near_hit) {
+            near_child = far_child;
+            near_hit = far_hit;
+            far_hit = false;
+        }
+        if (far_hit)
+            stack[top++] = far_child;
+        if (near_hit)
+            stack[top++] = near_child;
+    }
+    return hit->triangle >= 0;
+}
+
+bool MeshBVH::closestPointBruteForce(const glm::vec3& point, float max_distance, MeshContact* contact) const {
+    if (triangles.empty() || max_distance < 0.0f)
+        return false;
+    float best_sq = max_distance * max_distance;
+    contact->triangle = -1;
+    for (size_t i = 0; i < triangles.size(); ++i)
+        testTriangle(static_cast<int>(i), point, best_sq, contact);
+    return contact->triangle >= 0;
+}
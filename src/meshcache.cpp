@@ -0,0 +1,209 @@
+//Binary mesh cache for ".obj" models
+#include "../include/meshcache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <sys/stat.h>
+#include "../include/mappedfile.hpp"
+
+namespace {
+
+const char MESHCACHE_MAGIC[4] = { 'F', 'G', 'M', 'C' };
+const size_t MESHCACHE_ALIGNMENT = 16;
+
+struct MeshCacheHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t real_size;      // sizeof(tinyobj::real_t) used when writing
+    uint32_t num_shapes;
+    uint64_t file_size;      // Total size of the cache file, for bounds checking
+    uint64_t source_size;    // Size of the OBJ file the cache was built from
+    int64_t  source_mtime;   // Modification time of that OBJ file
+    uint64_t num_positions;
+    uint64_t num_normals;
+    uint64_t num_texcoords;
+    uint64_t positions_offset;
+    uint64_t normals_offset;
+    uint64_t texcoords_offset;
+};
+
+struct MeshCacheShape {
+    uint64_t name_offset;
+    uint64_t indices_offset;
+    uint64_t face_vertices_offset;
+    uint64_t material_ids_offset;
+    uint32_t name_length;
+    uint32_t num_indices;
+    uint32_t num_faces;
+    uint32_t reserved;
+};
+
+bool FileStat(const char* filename, uint64_t* size, int64_t* mtime) {
+    struct stat st;
+    if (stat(filename, &st) != 0)
+        return false;
+    *size = static_cast<uint64_t>(st.st_size);
+    *mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+inline bool InBounds(const MappedFile& file, uint64_t offset, uint64_t bytes) {
+    return offset <= file.size && bytes <= file.size - offset;
+}
+
+// Copies "count" elements starting at "offset" into "out", checking bounds.
+template <typename T>
+bool ReadArray(const MappedFile& file, uint64_t offset, uint64_t count, std::vector<T>* out) {
+    if (count > file.size / sizeof(T) || !InBounds(file, offset, count * sizeof(T)))
+        return false;
+    out->resize(static_cast<size_t>(count));
+    if (count > 0)
+        memcpy(&(*out)[0], file.data + offset, static_cast<size_t>(count * sizeof(T)));
+    return true;
+}
+
+// Appends raw bytes to the blob, padding it first so the data starts at an
+// aligned offset. Returns that offset.
+uint64_t AppendAligned(std::vector<char>& blob, const void* data, size_t bytes) {
+    size_t padding = (MESHCACHE_ALIGNMENT - blob.size() % MESHCACHE_ALIGNMENT) % MESHCACHE_ALIGNMENT;
+    blob.insert(blob.end(), padding, 0);
+    uint64_t offset = blob.size();
+    const char* bytes_ptr = static_cast<const char*>(data);
+    blob.insert(blob.end(), bytes_ptr, bytes_ptr + bytes);
+    return offset;
+}
+
+template <typename T>
+uint64_t AppendArray(std::vector<char>& blob, const std::vector<T>& v) {
+    return AppendAligned(blob, v.empty() ? NULL : &v[0], v.size() * sizeof(T));
+}
+
+} // namespace
+
+std::string MeshCache_Path(const char* obj_filename) {
+    return std::string(obj_filename) + ".meshcache";
+}
+
+bool MeshCache_Load(const char* obj_filename, tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes) {
+    std::string cache_filename = MeshCache_Path(obj_filename);
+
+    uint64_t source_size, cache_size;
+    int64_t source_mtime, cache_mtime;
+    if (!FileStat(obj_filename, &source_size, &source_mtime))
+        return false;
+    if (!FileStat(cache_filename.c_str(), &cache_size, &cache_mtime))
+        return false;
+    if (cache_mtime < source_mtime)
+        return false; // OBJ was edited after the cache was written
+
+    MappedFile file(cache_filename.c_str());
+    if (file.data == NULL || file.size < sizeof(MeshCacheHeader))
+        return false;
+
+    MeshCacheHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, MESHCACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != MESHCACHE_VERSION
+        || header.real_size != sizeof(tinyobj::real_t)
+        || header.file_size != file.size
+        || header.source_size != source_size
+        || header.source_mtime != source_mtime)
+        return false;
+
+    if (header.num_shapes > file.size / sizeof(MeshCacheShape)
+        || !InBounds(file, sizeof(MeshCacheHeader), header.num_shapes * sizeof(MeshCacheShape)))
+        return false;
+
+    tinyobj::attrib_t new_attrib;
+    std::vector<tinyobj::shape_t> new_shapes(header.num_shapes);
+
+    if (!ReadArray(file, header.positions_offset, 3 * header.num_positions, &new_attrib.vertices)
+        || !ReadArray(file, header.normals_offset, 3 * header.num_normals, &new_attrib.normals)
+        || !ReadArray(file, header.texcoords_offset, 2 * header.num_texcoords, &new_attrib.texcoords))
+        return false;
+
+    for (uint32_t s = 0; s < header.num_shapes; ++s) {
+        MeshCacheShape record;
+        memcpy(&record, file.data + sizeof(MeshCacheHeader) + s * sizeof(MeshCacheShape), sizeof(record));
+
+        if (!InBounds(file, record.name_offset, record.name_length))
+            return false;
+        new_shapes[s].name.assign(file.data + record.name_offset, record.name_length);
+
+        tinyobj::mesh_t& mesh = new_shapes[s].mesh;
+        if (!ReadArray(file, record.indices_offset, record.num_indices, &mesh.indices)
+            || !ReadArray(file, record.face_vertices_offset, record.num_faces, &mesh.num_face_vertices)
+            || !ReadArray(file, record.material_ids_offset, record.num_faces, &mesh.material_ids))
+            return false;
+    }
+
+    attrib->vertices.swap(new_attrib.vertices);
+    attrib->normals.swap(new_attrib.normals);
+    attrib->texcoords.swap(new_attrib.texcoords);
+    shapes->swap(new_shapes);
+    return true;
+}
+
+bool MeshCache_Save(const char* obj_filename, const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes) {
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESHCACHE_MAGIC, sizeof(header.magic));
+    header.version = MESHCACHE_VERSION;
+    header.real_size = sizeof(tinyobj::real_t);
+    header.num_shapes = static_cast<uint32_t>(shapes.size());
+    if (!FileStat(obj_filename, &header.source_size, &header.source_mtime))
+        return false;
+    header.num_positions = attrib.vertices.size() / 3;
+    header.num_normals = attrib.normals.size() / 3;
+    header.num_texcoords = attrib.texcoords.size() / 2;
+
+    // Header and shape table are patched in place once the offsets are known
+    std::vector<char> blob(sizeof(MeshCacheHeader) + shapes.size() * sizeof(MeshCacheShape), 0);
+    std::vector<MeshCacheShape> records(shapes.size());
+
+    header.positions_offset = AppendArray(blob, attrib.vertices);
+    header.normals_offset = AppendArray(blob, attrib.normals);
+    header.texcoords_offset = AppendArray(blob, attrib.texcoords);
+
+    for (size_t s = 0; s < shapes.size(); ++s) {
+        const tinyobj::mesh_t& mesh = shapes[s].mesh;
+        MeshCacheShape& record = records[s];
+        memset(&record, 0, sizeof(record));
+        record.name_length = static_cast<uint32_t>(shapes[s].name.size());
+        record.num_indices = static_cast<uint32_t>(mesh.indices.size());
+        record.num_faces = static_cast<uint32_t>(mesh.num_face_vertices.size());
+        record.name_offset = AppendAligned(blob, shapes[s].name.data(), shapes[s].name.size());
+        record.indices_offset = AppendArray(blob, mesh.indices);
+        record.face_vertices_offset = AppendArray(blob, mesh.num_face_vertices);
+
+        // tinyobj leaves material_ids empty for some inputs; keep one per face
+        std::vector<int> material_ids(mesh.material_ids);
+        material_ids.resize(mesh.num_face_vertices.size(), -1);
+        record.material_ids_offset = AppendArray(blob, material_ids);
+    }
+
+    header.file_size = blob.size();
+    memcpy(&blob[0], &header, sizeof(header));
+    if (!records.empty())
+        memcpy(&blob[sizeof(MeshCacheHeader)], &records[0], records.size() * sizeof(MeshCacheShape));
+
+    // Write to a temporary file and rename it, so an interrupted run never
+    // leaves a truncated cache behind.
+    std::string cache_filename = MeshCache_Path(obj_filename);
+    std::string tmp_filename = cache_filename + ".tmp";
+    FILE* f = fopen(tmp_filename.c_str(), "wb");
+    if (f == NULL)
+        return false;
+    bool ok = fwrite(&blob[0], 1, blob.size(), f) == blob.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        remove(tmp_filename.c_str());
+        return false;
+    }
+    remove(cache_filename.c_str());
+    if (rename(tmp_filename.c_str(), cache_filename.c_str()) != 0) {
+        remove(tmp_filename.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,507 @@
+//Index buffer optimizations for triangle meshes
+#include "../include/meshopt.hpp"
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <queue>
+
+namespace {
+
+// Hash of a vertex record, computed over the raw bits of its floats
+uint32_t HashVertex(const float* v, size_t stride) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < stride; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &v[i], sizeof(bits));
+        h = (h ^ bits) * 16777619u;
+        h ^= h >> 15;
+    }
+    return h;
+}
+
+// Parameters of Forsyth's scoring function, as suggested in the original article
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+float ForsythVertexScore(int cache_position, unsigned int live_triangles) {
+    if (live_triangles == 0)
+        return -1.0f; // Vertex is not used by any remaining triangle
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // The three vertices of the last triangle get a fixed score, so
+            // the next triangle does not simply reuse the same edge forever.
+            score = FORSYTH_LAST_TRI_SCORE;
+        }
+        else {
+            const float scaler = 1.0f / (MESHOPT_VERTEX_CACHE_SIZE - 3);
+            score = 1.0f - (cache_position - 3) * scaler;
+            score = powf(score, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Bonus for vertices with few triangles left, so lone triangles are not
+    // left behind to be drawn with a cold cache at the end.
+    score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)live_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+} // namespace
+
+size_t MeshOpt_WeldVertices(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices) {
+    size_t num_vertices = stride ? vertices.size() / stride : 0;
+    if (num_vertices == 0)
+        return 0;
+
+    // Open-addressing hash table of unique vertex ids (power of two, load <= 0.5)
+    size_t table_size = 1;
+    while (table_size < 2 * num_vertices)
+        table_size <<= 1;
+    const unsigned int EMPTY = ~0u;
+    std::vector<unsigned int> table(table_size, EMPTY);
+
+    std::vector<unsigned int> remap(num_vertices);
+    size_t num_unique = 0;
+
+    for (size_t v = 0; v < num_vertices; ++v) {
+        const float* record = &vertices[v * stride];
+        size_t slot = HashVertex(record, stride) & (table_size - 1);
+
+        for (;;) {
+            unsigned int id = table[slot];
+            if (id == EMPTY) {
+                // First occurrence: compact it down to the next unique slot
+                // (always <= v, so we never overwrite a record not yet read).
+                if (num_unique != v)
+                    memmove(&vertices[num_unique * stride], record, stride * sizeof(float));
+                table[slot] = (unsigned int)num_unique;
+                remap[v] = (unsigned int)num_unique;
+                ++num_unique;
+                break;
+            }
+            if (memcmp(&vertices[id * stride], record, stride * sizeof(float)) == 0) {
+                remap[v] = id;
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+
+    vertices.resize(num_unique * stride);
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = remap[indices[i]];
+
+    return num_unique;
+}
+
+void MeshOpt_OptimizeVertexCache(std::vector<unsigned int>& indices, size_t first, size_t count, size_t num_vertices) {
+    const size_t num_triangles = count / 3;
+    if (num_triangles < 2 || num_vertices == 0)
+        return;
+
+    const unsigned int* in = &indices[first];
+
+    // Triangle adjacency of each vertex, as one flat array
+    std::vector<unsigned int> live_triangles(num_vertices, 0);
+    for (size_t i = 0; i < num_triangles * 3; ++i)
+        live_triangles[in[i]] += 1;
+
+    std::vector<unsigned int> adjacency_offset(num_vertices + 1, 0);
+    for (size_t v = 0; v < num_vertices; ++v)
+        adjacency_offset[v + 1] = adjacency_offset[v] + live_triangles[v];
+
+    std::vector<unsigned int> adjacency(num_triangles * 3);
+    {
+        std::vector<unsigned int> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t t = 0; t < num_triangles; ++t)
+            for (size_t k = 0; k < 3; ++k)
+                adjacency[fill[in[3 * t + k]]++] = (unsigned int)t;
+    }
+
+    std::vector<int> cache_position(num_vertices, -1);
+    std::vector<float> vertex_score(num_vertices);
+    for (size_t v = 0; v < num_vertices; ++v)
+        vertex_score[v] = ForsythVertexScore(-1, live_triangles[v]);
+
+    std::vector<float> triangle_score(num_triangles);
+    std::vector<bool> emitted(num_triangles, false);
+    int best_triangle = -1;
+    float best_score = -1.0f;
+    for (size_t t = 0; t < num_triangles; ++t) {
+        triangle_score[t] = vertex_score[in[3 * t]] + vertex_score[in[3 * t + 1]] + vertex_score[in[3 * t + 2]];
+        if (triangle_score[t] > best_score) {
+            best_score = triangle_score[t];
+            best_triangle = (int)t;
+        }
+    }
+
+    // The cache holds 3 extra slots for the vertices pushed out by the triangle
+    // just emitted, so their scores get updated before they are forgotten.
+    const size_t cache_capacity = MESHOPT_VERTEX_CACHE_SIZE + 3;
+    std::vector<unsigned int> cache, new_cache;
+    cache.reserve(cache_capacity);
+    new_cache.reserve(cache_capacity + 3);
+
+    std::vector<unsigned int> out;
+    out.reserve(num_triangles * 3);
+    size_t scan_cursor = 0;
+
+    for (size_t emitted_count = 0; emitted_count < num_triangles; ++emitted_count) {
+        if (best_triangle < 0) {
+            // Nothing left near the cache: continue with any remaining triangle
+            while (emitted[scan_cursor])
+                ++scan_cursor;
+            best_triangle = (int)scan_cursor;
+        }
+
+        const unsigned int t = (unsigned int)best_triangle;
+        const unsigned int tri[3] = { in[3 * t], in[3 * t + 1], in[3 * t + 2] };
+        out.push_back(tri[0]);
+        out.push_back(tri[1]);
+        out.push_back(tri[2]);
+        emitted[t] = true;
+
+        // Remove the triangle from the adjacency of its vertices
+        for (size_t k = 0; k < 3; ++k) {
+            unsigned int v = tri[k];
+            unsigned int begin = adjacency_offset[v];
+            unsigned int end = begin + live_triangles[v];
+            for (unsigned int a = begin; a < end; ++a) {
+                if (adjacency[a] == t) {
+                    adjacency[a] = adjacency[end - 1];
+                    break;
+                }
+            }
+            live_triangles[v] -= 1;
+        }
+
+        // Move the triangle's vertices to the front of the cache (LRU)
+        new_cache.clear();
+        new_cache.push_back(tri[0]);
+        new_cache.push_back(tri[1]);
+        new_cache.push_back(tri[2]);
+        for (size_t c = 0; c < cache.size(); ++c) {
+            unsigned int v = cache[c];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                new_cache.push_back(v);
+        }
+
+        for (size_t c = 0; c < new_cache.size(); ++c) {
+            unsigned int v = new_cache[c];
+            cache_position[v] = (c < MESHOPT_VERTEX_CACHE_SIZE) ? (int)c : -1;
+            vertex_score[v] = ForsythVertexScore(cache_position[v], live_triangles[v]);
+        }
+
+        // Rescore the triangles touching the cache and pick the next one
+        best_triangle = -1;
+        best_score = -1.0f;
+        for (size_t c = 0; c < new_cache.size(); ++c) {
+            unsigned int v = new_cache[c];
+            unsigned int begin = adjacency_offset[v];
+            unsigned int end = begin + live_triangles[v];
+            for (unsigned int a = begin; a < end; ++a) {
+                unsigned int u = adjacency[a];
+                float score = vertex_score[in[3 * u]] + vertex_score[in[3 * u + 1]] + vertex_score[in[3 * u + 2]];
+                triangle_score[u] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best_triangle = (int)u;
+                }
+            }
+        }
+
+        if (new_cache.size() > cache_capacity)
+            new_cache.resize(cache_capacity);
+        cache.swap(new_cache);
+    }
+
+    memcpy(&indices[first], &out[0], out.size() * sizeof(unsigned int));
+}
+
+size_t MeshOpt_VertexShaderInvocations(const std::vector<unsigned int>& indices, size_t first, size_t count, size_t cache_size) {
+    // FIFO cache, as in the hardware the classic ACMR figures were measured on
+    std::vector<unsigned int> fifo(cache_size, ~0u);
+    size_t head = 0;
+    size_t invocations = 0;
+
+    for (size_t i = first; i < first + count; ++i) {
+        unsigned int v = indices[i];
+        bool hit = false;
+        for (size_t c = 0; c < cache_size; ++c) {
+            if (fifo[c] == v) {
+                hit = true;
+                break;
+            }
+        }
+        if (!hit) {
+            fifo[head] = v;
+            head = (head + 1) % cache_size;
+            ++invocations;
+        }
+    }
+    return invocations;
+}
+
+namespace {
+
+// Sum of squared distances to a set of planes (a, b, c, d): the symmetric
+// 4x4 matrix of their outer products, upper triangle only
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+};
+
+Quadric QuadricFromPlane(double a, double b, double c, double d) {
+    Quadric q = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+    return q;
+}
+
+void QuadricAdd(Quadric& q, const Quadric& other) {
+    q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+    q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+    q.c2 += other.c2; q.cd += other.cd;
+    q.d2 += other.d2;
+}
+
+double QuadricError(const Quadric& q, const glm::vec3& p) {
+    double x = p.x, y = p.y, z = p.z;
+    double error = q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+                 + q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+                 + q.c2 * z * z + 2.0 * q.cd * z
+                 + q.d2;
+    return error > 0.0 ? error : 0.0; // Arredondamento
+}
+
+// Moving vertex "from" onto "to". The versions are those of the two vertices
+// when the cost was computed: a collapse popped after either changed is stale.
+struct Collapse {
+    double cost;
+    unsigned int from, to;
+    unsigned int from_version, to_version;
+    bool operator<(const Collapse& other) const { return cost > other.cost; } // Menor custo no topo
+};
+
+} // namespace
+
+float MeshOpt_Simplify(const std::vector<float>& vertices, size_t stride, const std::vector<unsigned int>& indices,
+                       size_t first, size_t count, size_t target_count, std::vector<unsigned int>& out) {
+    const size_t num_records = stride ? vertices.size() / stride : 0;
+    const size_t num_triangles = count / 3;
+    if (num_records == 0 || num_triangles == 0)
+        return 0.0f;
+
+    // Registros na mesma posição são um só vértice aqui; o de menor índice
+    // representa a posição nos cantos movidos para ela
+    std::vector<unsigned int> sorted(num_records);
+    for (size_t r = 0; r < num_records; ++r)
+        sorted[r] = (unsigned int)r;
+    std::sort(sorted.begin(), sorted.end(), [&](unsigned int a, unsigned int b) {
+        const float* pa = &vertices[a * stride];
+        const float* pb = &vertices[b * stride];
+        if (pa[0] != pb[0]) return pa[0] < pb[0];
+        if (pa[1] != pb[1]) return pa[1] < pb[1];
+        if (pa[2] != pb[2]) return pa[2] < pb[2];
+        return a < b;
+    });
+    std::vector<unsigned int> position_of(num_records);
+    std::vector<unsigned int> representative;
+    std::vector<glm::vec3> positions;
+    for (size_t i = 0; i < num_records; ++i) {
+        const float* p = &vertices[sorted[i] * stride];
+        glm::vec3 position(p[0], p[1], p[2]);
+        if (positions.empty() || position != positions.back()) {
+            positions.push_back(position);
+            representative.push_back(sorted[i]);
+        }
+        position_of[sorted[i]] = (unsigned int)(positions.size() - 1);
+    }
+    const size_t num_positions = positions.size();
+
+    std::vector<unsigned int> corners(3 * num_triangles);  // Posições
+    std::vector<unsigned int> records(3 * num_triangles);  // Registros, para a saída
+    std::vector<char> alive(num_triangles, 1);
+    std::vector<std::vector<unsigned int> > triangles_of(num_positions);
+    size_t live = 0;
+    for (size_t t = 0; t < num_triangles; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            records[3 * t + k] = indices[first + 3 * t + k];
+            corners[3 * t + k] = position_of[records[3 * t + k]];
+        }
+        const unsigned int* c = &corners[3 * t];
+        if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0]) {
+            alive[t] = 0; // Já degenerado: não aparece na tela
+            continue;
+        }
+        for (size_t k = 0; k < 3; ++k)
+            triangles_of[c[k]].push_back((unsigned int)t);
+        ++live;
+    }
+
+    // Arestas; as de borda (um triângulo) ou não-manifold (mais de dois)
+    // prendem os seus vértices, para não abrir buracos
+    std::vector<uint64_t> edges;
+    edges.reserve(3 * live);
+    for (size_t t = 0; t < num_triangles; ++t) {
+        if (!alive[t])
+            continue;
+        for (size_t k = 0; k < 3; ++k) {
+            uint64_t a = corners[3 * t + k], b = corners[3 * t + (k + 1) % 3];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<char> locked(num_positions, 0);
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+            ++j;
+        if (j - i != 2) {
+            locked[edges[i] >> 32] = 1;
+            locked[edges[i] & 0xFFFFFFFFu] = 1;
+        }
+        i = j;
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Quadric> quadrics(num_positions, QuadricFromPlane(0.0, 0.0, 0.0, 0.0));
+    for (size_t t = 0; t < num_triangles; ++t) {
+        if (!alive[t])
+            continue;
+        const glm::vec3& a = positions[corners[3 * t]];
+        glm::vec3 n = glm::cross(positions[corners[3 * t + 1]] - a, positions[corners[3 * t + 2]] - a);
+        float length = glm::length(n);
+        if (length <= 0.0f)
+            continue;
+        n /= length;
+        Quadric plane = QuadricFromPlane(n.x, n.y, n.z, -glm::dot(n, a));
+        for (size_t k = 0; k < 3; ++k)
+            QuadricAdd(quadrics[corners[3 * t + k]], plane);
+    }
+
+    std::vector<unsigned int> version(num_positions, 0);
+    std::vector<char> removed(num_positions, 0);
+    std::priority_queue<Collapse> heap;
+    auto push_edge = [&](unsigned int a, unsigned int b) {
+        // A direção mais barata da aresta; vértices presos não se movem
+        Quadric q = quadrics[a];
+        QuadricAdd(q, quadrics[b]);
+        const double never = std::numeric_limits<double>::infinity();
+        double a_to_b = locked[a] ? never : QuadricError(q, positions[b]);
+        double b_to_a = locked[b] ? never : QuadricError(q, positions[a]);
+        if (a_to_b == never && b_to_a == never)
+            return;
+        Collapse collapse;
+        collapse.cost = std::min(a_to_b, b_to_a);
+        collapse.from = a_to_b <= b_to_a ? a : b;
+        collapse.to = a_to_b <= b_to_a ? b : a;
+        collapse.from_version = version[collapse.from];
+        collapse.to_version = version[collapse.to];
+        heap.push(collapse);
+    };
+    for (size_t i = 0; i < edges.size(); ++i)
+        push_edge((unsigned int)(edges[i] >> 32), (unsigned int)(edges[i] & 0xFFFFFFFFu));
+
+    double max_cost = 0.0;
+    std::vector<unsigned int> neighbors;
+    while (live * 3 > target_count && !heap.empty()) {
+        Collapse collapse = heap.top();
+        heap.pop();
+        const unsigned int from = collapse.from, to = collapse.to;
+        if (removed[from] || removed[to] || version[from] != collapse.from_version || version[to] != collapse.to_version)
+            continue;
+
+        // Nenhum triângulo que sobrevive pode virar do avesso (ou sumir)
+        bool flips = false;
+        for (unsigned int t : triangles_of[from]) {
+            const unsigned int* c = &corners[3 * t];
+            if (!alive[t] || c[0] == to || c[1] == to || c[2] == to)
+                continue;
+            glm::vec3 p[3], q[3];
+            for (size_t k = 0; k < 3; ++k) {
+                p[k] = positions[c[k]];
+                q[k] = c[k] == from ? positions[to] : p[k];
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0.0f) {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        for (unsigned int t : triangles_of[from]) {
+            if (!alive[t])
+                continue;
+            unsigned int* c = &corners[3 * t];
+            if (c[0] == to || c[1] == to || c[2] == to) {
+                alive[t] = 0; // A aresta colapsada era dele
+                --live;
+                continue;
+            }
+            for (size_t k = 0; k < 3; ++k) {
+                if (c[k] == from) {
+                    c[k] = to;
+                    records[3 * t + k] = representative[to];
+                }
+            }
+            triangles_of[to].push_back(t);
+        }
+        triangles_of[from].clear();
+        removed[from] = 1;
+        QuadricAdd(quadrics[to], quadrics[from]);
+        version[to] += 1;
+        max_cost = std::max(max_cost, collapse.cost);
+
+        // Descarta os triângulos mortos de "to" e recalcula as suas arestas
+        std::vector<unsigned int>& around = triangles_of[to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int t) { return !alive[t]; }), around.end());
+        neighbors.clear();
+        for (unsigned int t : around)
+            for (size_t k = 0; k < 3; ++k)
+                if (corners[3 * t + k] != to)
+                    neighbors.push_back(corners[3 * t + k]);
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        for (unsigned int n : neighbors)
+            push_edge(to, n);
+    }
+
+    for (size_t t = 0; t < num_triangles; ++t)
+        if (alive[t])
+            out.insert(out.end(), &records[3 * t], &records[3 * t] + 3);
+    return static_cast<float>(std::sqrt(max_cost));
+}
+
+size_t MeshOpt_BuildLodChain(const std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+                             size_t first, size_t count, int max_levels, std::vector<MeshOptLod>& lods) {
+    size_t built = 0;
+    size_t source_first = first, source_count = count;
+    float error = 0.0f;
+    std::vector<unsigned int> level;
+    for (int l = 0; l < max_levels; ++l) {
+        size_t target = static_cast<size_t>(source_count / 3 * MESHOPT_LOD_REDUCTION) * 3;
+        if (target < 3 * MESHOPT_LOD_MIN_TRIANGLES)
+            break;
+        level.clear();
+        float level_error = MeshOpt_Simplify(vertices, stride, indices, source_first, source_count, target, level);
+        if (level.size() > source_count * 9 / 10)
+            break; // Quase nada a colapsar sem virar triângulos
+        // Cada nível parte do anterior: os erros se somam
+        error += level_error;
+        MeshOptLod lod = { indices.size(), level.size(), error };
+        indices.insert(indices.end(), level.begin(), level.end());
+        lods.push_back(lod);
+        source_first = lod.first;
+        source_count = lod.count;
+        ++built;
+    }
+    return built;
+}
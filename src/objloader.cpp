@@ -0,0 +1,618 @@
+//Parallel ".obj" parser
+#include "../include/objloader.hpp"
+#include "../include/jobsystem.hpp"
+#include "../include/mappedfile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace {
+
+inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Índices de um canto de face como escritos no arquivo, já em base 0.
+// Os relativos (negativos no arquivo) ainda não somam o início do pedaço.
+struct Corner {
+    int v, vt, vn; // -1 quando ausente (vt, vn)
+};
+const unsigned char RELATIVE_V = 1;
+const unsigned char RELATIVE_VT = 2;
+const unsigned char RELATIVE_VN = 4;
+
+enum CommandType { Group, Object, UseMtl, MtlLib, Smoothing };
+
+// Linha que muda o estado do leitor, na posição entre as faces do pedaço
+struct Command {
+    CommandType type;
+    size_t face;           // Faces do pedaço lidas antes dela
+    size_t triangle;       // Triângulos dessas faces (passo 3)
+    std::string text;      // Nome do grupo/objeto/material, arquivos da mtllib
+    unsigned int smoothing;
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    std::vector<float> v, vn, vt;
+    std::vector<Corner> corners;
+    std::vector<unsigned char> relative;     // RELATIVE_* de cada canto
+    std::vector<unsigned char> face_corners; // Cantos de cada face (3 ou 4)
+    std::vector<Command> commands;
+    std::vector<tinyobj::index_t> triangles; // Passo 3
+    size_t base_v = 0, base_vn = 0, base_vt = 0;
+    bool supported = true;
+};
+
+// Fim de um número: espaço ou fim da linha (o '\r' já foi cortado)
+inline bool AtSeparator(const char* p, const char* e) {
+    return p == e || IsSpace(*p);
+}
+
+inline const char* SkipSpaces(const char* p, const char* e) {
+    while (p < e && IsSpace(*p))
+        ++p;
+    return p;
+}
+
+// Lê "count" números separados por espaços; false se faltar algum
+bool ParseFloats(const char*& p, const char* e, float* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        p = SkipSpaces(p, e);
+        const char* q = ObjLoader_ParseFloat(p, e, &out[i]);
+        if (q == p || !AtSeparator(q, e))
+            return false;
+        p = q;
+    }
+    return true;
+}
+
+// Inteiro com sinal como atoi(); "value" = 0 sem dígitos, como atoi()
+const char* ParseIndex(const char* p, const char* e, int* value, bool* ok) {
+    bool negative = false;
+    if (p < e && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+    int n = 0;
+    while (p < e && IsDigit(*p)) {
+        if (n > 214748363) {
+            *ok = false;
+            return p;
+        }
+        n = n * 10 + (*p - '0');
+        ++p;
+    }
+    *value = negative ? -n : n;
+    return p;
+}
+
+// Índice de um canto: positivo em base 1, negativo relativo ao que foi lido
+// até aqui (que, no pedaço, ainda não inclui os pedaços anteriores)
+bool FixIndex(int index, size_t local_count, bool allow_zero, int* out, bool* relative) {
+    *relative = false;
+    if (index > 0) {
+        *out = index - 1;
+        return true;
+    }
+    if (index == 0) {
+        *out = -1;
+        return allow_zero;
+    }
+    *out = static_cast<int>(local_count) + index;
+    *relative = true;
+    return true;
+}
+
+bool ParseFace(Chunk& chunk, const char* p, const char* e) {
+    size_t count = 0;
+    p = SkipSpaces(p, e);
+    while (p < e) {
+        bool ok = true;
+        bool relative;
+        int value;
+        Corner corner = { -1, -1, -1 };
+        unsigned char flags = 0;
+        p = ParseIndex(p, e, &value, &ok);
+        if (!ok || !FixIndex(value, chunk.v.size() / 3, false, &corner.v, &relative))
+            return false;
+        flags |= relative ? RELATIVE_V : 0;
+        if (p < e && *p == '/') {
+            ++p;
+            if (p < e && *p == '/') { // v//vn
+                ++p;
+                p = ParseIndex(p, e, &value, &ok);
+                if (!ok || !FixIndex(value, chunk.vn.size() / 3, true, &corner.vn, &relative))
+                    return false;
+                flags |= relative ? RELATIVE_VN : 0;
+            }
+            else { // v/vt ou v/vt/vn
+                p = ParseIndex(p, e, &value, &ok);
+                if (!ok || !FixIndex(value, chunk.vt.size() / 2, true, &corner.vt, &relative))
+                    return false;
+                flags |= relative ? RELATIVE_VT : 0;
+                if (p < e && *p == '/') {
+                    ++p;
+                    p = ParseIndex(p, e, &value, &ok);
+                    if (!ok || !FixIndex(value, chunk.vn.size() / 3, true, &corner.vn, &relative))
+                        return false;
+                    flags |= relative ? RELATIVE_VN : 0;
+                }
+            }
+        }
+        if (!AtSeparator(p, e))
+            return false;
+        chunk.corners.push_back(corner);
+        chunk.relative.push_back(flags);
+        ++count;
+        p = SkipSpaces(p, e);
+    }
+    // Faces degeneradas são avisos no tinyobj e polígonos maiores passam
+    // pela triangulação por orelhas dele: ficam para o tinyobj
+    if (count < 3 || count > 4)
+        return false;
+    chunk.face_corners.push_back(static_cast<unsigned char>(count));
+    return true;
+}
+
+void AddCommand(Chunk& chunk, CommandType type, const std::string& text, unsigned int smoothing = 0) {
+    Command command;
+    command.type = type;
+    command.face = chunk.face_corners.size();
+    command.triangle = 0;
+    command.text = text;
+    command.smoothing = smoothing;
+    chunk.commands.push_back(command);
+}
+
+// Uma linha sem o '\n' e o '\r' finais. Mesmas regras de tinyobj::LoadObj()
+// para reconhecer cada comando; false se a linha foge do que é tratado aqui.
+bool ParseLine(Chunk& chunk, const char* p, const char* e) {
+    p = SkipSpaces(p, e);
+    if (p == e || *p == '#')
+        return true;
+    const char c1 = p + 1 < e ? p[1] : '\0';
+    const char c2 = p + 2 < e ? p[2] : '\0';
+
+    if (p[0] == 'v' && IsSpace(c1)) {
+        p += 2;
+        float xyz[3];
+        if (!ParseFloats(p, e, xyz, 3) || SkipSpaces(p, e) != e)
+            return false; // Cores por vértice ficam para o tinyobj
+        chunk.v.insert(chunk.v.end(), xyz, xyz + 3);
+        return true;
+    }
+    if (p[0] == 'v' && c1 == 'n' && IsSpace(c2)) {
+        p += 3;
+        float xyz[3];
+        if (!ParseFloats(p, e, xyz, 3))
+            return false;
+        chunk.vn.insert(chunk.vn.end(), xyz, xyz + 3);
+        return true;
+    }
+    if (p[0] == 'v' && c1 == 't' && IsSpace(c2)) {
+        p += 3;
+        float uv[2];
+        if (!ParseFloats(p, e, uv, 2))
+            return false; // Um "w" depois de u e v é ignorado, como no tinyobj
+        chunk.vt.insert(chunk.vt.end(), uv, uv + 2);
+        return true;
+    }
+    if ((p[0] == 'v' && c1 == 'w' && IsSpace(c2)) || ((p[0] == 'l' || p[0] == 'p' || p[0] == 't') && IsSpace(c1)))
+        return false;
+    if (p[0] == 'f' && IsSpace(c1))
+        return ParseFace(chunk, p + 2, e);
+    if (e - p >= 6 && strncmp(p, "usemtl", 6) == 0) {
+        p = SkipSpaces(p + 6, e);
+        const char* q = p;
+        while (q < e && !IsSpace(*q))
+            ++q;
+        AddCommand(chunk, UseMtl, std::string(p, q));
+        return true;
+    }
+    if (e - p >= 7 && strncmp(p, "mtllib", 6) == 0 && IsSpace(p[6])) {
+        AddCommand(chunk, MtlLib, std::string(p + 7, e));
+        return true;
+    }
+    if (p[0] == 'g' && IsSpace(c1)) {
+        // Vários nomes viram um só, separados por um espaço
+        std::string name;
+        p += 1;
+        while (true) {
+            p = SkipSpaces(p, e);
+            if (p == e)
+                break;
+            const char* q = p;
+            while (q < e && !IsSpace(*q))
+                ++q;
+            if (!name.empty())
+                name += ' ';
+            name.append(p, q);
+            p = q;
+        }
+        AddCommand(chunk, Group, name);
+        return true;
+    }
+    if (p[0] == 'o' && IsSpace(c1)) {
+        AddCommand(chunk, Object, std::string(p + 2, e));
+        return true;
+    }
+    if (p[0] == 's' && IsSpace(c1)) {
+        p = SkipSpaces(p + 2, e);
+        if (p == e)
+            return true;
+        unsigned int smoothing = 0;
+        if (!(e - p >= 3 && strncmp(p, "off", 3) == 0)) {
+            bool ok = true;
+            int value;
+            ParseIndex(p, e, &value, &ok);
+            if (!ok)
+                return false;
+            smoothing = value < 0 ? 0u : static_cast<unsigned int>(value);
+        }
+        AddCommand(chunk, Smoothing, std::string(), smoothing);
+        return true;
+    }
+    return true; // Comando desconhecido, ignorado como no tinyobj
+}
+
+// Passo 1
+void ParseChunk(Chunk& chunk) {
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if (eol == NULL)
+            eol = chunk.end;
+        const char* e = eol;
+        if (e > p && e[-1] == '\r')
+            --e;
+        // O tinyobj também termina linhas num '\r' sozinho
+        if ((e > p && memchr(p, '\r', e - p) != NULL) || !ParseLine(chunk, p, e)) {
+            chunk.supported = false;
+            return;
+        }
+        p = eol + 1;
+    }
+}
+
+// Resolve e confere um índice contra os totais do arquivo
+inline bool ResolveIndex(int* index, bool relative, size_t base, size_t count, bool optional) {
+    if (relative)
+        *index += static_cast<int>(base);
+    if (*index < 0)
+        return optional && !relative && *index == -1;
+    return static_cast<size_t>(*index) < count;
+}
+
+inline tinyobj::index_t ToIndex(const Corner& corner) {
+    tinyobj::index_t index;
+    index.vertex_index = corner.v;
+    index.normal_index = corner.vn;
+    index.texcoord_index = corner.vt;
+    return index;
+}
+
+// Passo 3: índices finais e quadriláteros divididos pela diagonal mais
+// curta, com as mesmas contas (em real_t) de exportGroupsToShape()
+void TriangulateChunk(Chunk& chunk, const tinyobj::attrib_t& attrib) {
+    const size_t num_v = attrib.vertices.size() / 3;
+    const size_t num_vn = attrib.normals.size() / 3;
+    const size_t num_vt = attrib.texcoords.size() / 2;
+    for (size_t i = 0; i < chunk.corners.size(); ++i) {
+        Corner& c = chunk.corners[i];
+        unsigned char flags = chunk.relative[i];
+        if (!ResolveIndex(&c.v, (flags & RELATIVE_V) != 0, chunk.base_v, num_v, false) ||
+            !ResolveIndex(&c.vt, (flags & RELATIVE_VT) != 0, chunk.base_vt, num_vt, true) ||
+            !ResolveIndex(&c.vn, (flags & RELATIVE_VN) != 0, chunk.base_vn, num_vn, true)) {
+            chunk.supported = false; // Fora do intervalo: o tinyobj avisa
+            return;
+        }
+    }
+
+    const std::vector<tinyobj::real_t>& v = attrib.vertices;
+    size_t corner = 0;
+    size_t command = 0;
+    chunk.triangles.reserve(3 * chunk.face_corners.size());
+    for (size_t face = 0; face <= chunk.face_corners.size(); ++face) {
+        for (; command < chunk.commands.size() && chunk.commands[command].face == face; ++command)
+            chunk.commands[command].triangle = chunk.triangles.size() / 3;
+        if (face == chunk.face_corners.size())
+            break;
+        const Corner* c = &chunk.corners[corner];
+        corner += chunk.face_corners[face];
+        if (chunk.face_corners[face] == 3) {
+            for (int k = 0; k < 3; ++k)
+                chunk.triangles.push_back(ToIndex(c[k]));
+            continue;
+        }
+        size_t vi0 = c[0].v, vi1 = c[1].v, vi2 = c[2].v, vi3 = c[3].v;
+        tinyobj::real_t e02x = v[vi2 * 3 + 0] - v[vi0 * 3 + 0];
+        tinyobj::real_t e02y = v[vi2 * 3 + 1] - v[vi0 * 3 + 1];
+        tinyobj::real_t e02z = v[vi2 * 3 + 2] - v[vi0 * 3 + 2];
+        tinyobj::real_t e13x = v[vi3 * 3 + 0] - v[vi1 * 3 + 0];
+        tinyobj::real_t e13y = v[vi3 * 3 + 1] - v[vi1 * 3 + 1];
+        tinyobj::real_t e13z = v[vi3 * 3 + 2] - v[vi1 * 3 + 2];
+        tinyobj::real_t sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+        tinyobj::real_t sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+        static const int split02[6] = { 0, 1, 2, 0, 2, 3 };
+        static const int split13[6] = { 0, 1, 3, 1, 2, 3 };
+        const int* split = sqr02 < sqr13 ? split02 : split13;
+        for (int k = 0; k < 6; ++k)
+            chunk.triangles.push_back(ToIndex(c[split[k]]));
+    }
+}
+
+// Passo 4: o que tinyobj::LoadObj() faz linha a linha com "g", "o",
+// "usemtl", "mtllib" e "s", aplicado aos blocos de triângulos entre eles
+class ShapeBuilder {
+public:
+    ShapeBuilder(std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                 const std::string& mtl_basedir, std::string* warn)
+        : shapes(shapes), materials(materials), reader(mtl_basedir), warn(warn) {}
+
+    void addTriangles(const Chunk& chunk, size_t first, size_t last) {
+        if (first == last)
+            return;
+        tinyobj::mesh_t& mesh = shape.mesh;
+        shape.name = name;
+        mesh.indices.insert(mesh.indices.end(), chunk.triangles.begin() + 3 * first, chunk.triangles.begin() + 3 * last);
+        mesh.num_face_vertices.insert(mesh.num_face_vertices.end(), last - first, 3);
+        mesh.material_ids.insert(mesh.material_ids.end(), last - first, material);
+        mesh.smoothing_group_ids.insert(mesh.smoothing_group_ids.end(), last - first, smoothing);
+    }
+
+    void apply(const Command& command) {
+        switch (command.type) {
+        case Group:
+        case Object:
+            finish();
+            name = command.text;
+            break;
+        case UseMtl: {
+            std::map<std::string, int>::const_iterator it = material_map.find(command.text);
+            if (it != material_map.end())
+                material = it->second;
+            else {
+                material = -1;
+                if (warn)
+                    (*warn) += "material [ '" + command.text + "' ] not found in .mtl\n";
+            }
+            break;
+        }
+        case MtlLib:
+            loadMaterials(command.text);
+            break;
+        case Smoothing:
+            smoothing = command.smoothing;
+            break;
+        }
+    }
+
+    void finish() {
+        if (!shape.mesh.indices.empty())
+            shapes->push_back(std::move(shape));
+        shape = tinyobj::shape_t();
+    }
+
+private:
+    // Como SplitString() do tinyobj: nomes separados por espaços, '\' escapa
+    void loadMaterials(const std::string& line) {
+        std::vector<std::string> filenames;
+        std::string token;
+        bool escaping = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char ch = line[i];
+            if (escaping)
+                escaping = false;
+            else if (ch == '\\') {
+                escaping = true;
+                continue;
+            }
+            else if (ch == ' ') {
+                if (!token.empty())
+                    filenames.push_back(token);
+                token.clear();
+                continue;
+            }
+            token += ch;
+        }
+        filenames.push_back(token);
+
+        bool found = false;
+        for (size_t i = 0; i < filenames.size(); ++i) {
+            if (material_filenames.count(filenames[i]) > 0) {
+                found = true;
+                continue;
+            }
+            std::string warn_mtl, err_mtl;
+            bool ok = reader(filenames[i], materials, &material_map, &warn_mtl, &err_mtl);
+            if (warn)
+                (*warn) += warn_mtl + err_mtl;
+            if (ok) {
+                found = true;
+                material_filenames.insert(filenames[i]);
+                break;
+            }
+        }
+        if (!found && warn)
+            (*warn) += "Failed to load material file(s). Use default material.\n";
+    }
+
+    std::vector<tinyobj::shape_t>* shapes;
+    std::vector<tinyobj::material_t>* materials;
+    tinyobj::MaterialFileReader reader;
+    std::string* warn;
+    std::map<std::string, int> material_map;
+    std::set<std::string> material_filenames;
+    tinyobj::shape_t shape;
+    std::string name;
+    int material = -1;
+    unsigned int smoothing = 0;
+};
+
+} // namespace
+
+const char* ObjLoader_ParseFloat(const char* s, const char* end, float* value) {
+    static const double POWERS_OF_TEN[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* p = s;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // Até 19 algarismos significativos cabem num uint64_t; os seguintes só
+    // mudam o expoente (parte inteira) ou são descartados (parte decimal)
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; p < end && IsDigit(*p); ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+            ++exponent;
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && IsDigit(*p); ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (!any) {
+        *value = 0.0f;
+        return s;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool exponent_negative = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            exponent_negative = *q == '-';
+            ++q;
+        }
+        if (q < end && IsDigit(*q)) { // Sem algarismos, o 'e' não é do número
+            int e = 0;
+            for (; q < end && IsDigit(*q); ++q)
+                if (e < 100000)
+                    e = e * 10 + (*q - '0');
+            exponent += exponent_negative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Mantissa exata em double e potência de dez exata: um só arredondamento
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0) {
+        if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+            result = exponent >= 0 ? result * POWERS_OF_TEN[exponent] : result / POWERS_OF_TEN[-exponent];
+        else
+            result *= std::pow(10.0, static_cast<double>(exponent));
+    }
+    *value = static_cast<float>(negative ? -result : result);
+    return p;
+}
+
+bool ObjLoader_Load(const char* filename, const char* mtl_basedir, tinyobj::attrib_t* attrib,
+                    std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                    std::string* warn, JobSystem* jobs) {
+    MappedFile file(filename);
+    if (file.data == NULL)
+        return false;
+    if (jobs == NULL) {
+        static JobSystem shared_jobs;
+        jobs = &shared_jobs;
+    }
+
+    // Pedaços terminados em fim de linha, do tamanho que o arquivo permitir
+    std::vector<Chunk> chunks;
+    const char* end = file.data + file.size;
+    for (const char* p = file.data; p < end;) {
+        const char* cut = end;
+        if (static_cast<size_t>(end - p) > OBJLOADER_CHUNK_BYTES) {
+            cut = static_cast<const char*>(memchr(p + OBJLOADER_CHUNK_BYTES, '\n', end - p - OBJLOADER_CHUNK_BYTES));
+            cut = cut ? cut + 1 : end;
+        }
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = cut;
+        chunks.push_back(chunk);
+        p = cut;
+    }
+
+    // 1. Cada pedaço lido por uma thread
+    jobs->parallelFor(chunks.size(), 1, [&chunks](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+            ParseChunk(chunks[c]);
+    });
+
+    // 2. Onde os vértices de cada pedaço começam, e a cópia para attrib
+    size_t num_v = 0, num_vn = 0, num_vt = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        if (!chunks[c].supported)
+            return false;
+        chunks[c].base_v = num_v;
+        chunks[c].base_vn = num_vn;
+        chunks[c].base_vt = num_vt;
+        num_v += chunks[c].v.size() / 3;
+        num_vn += chunks[c].vn.size() / 3;
+        num_vt += chunks[c].vt.size() / 2;
+    }
+    tinyobj::attrib_t result;
+    result.vertices.resize(3 * num_v);
+    result.normals.resize(3 * num_vn);
+    result.texcoords.resize(2 * num_vt);
+    jobs->parallelFor(chunks.size(), 1, [&chunks, &result](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            const Chunk& chunk = chunks[c];
+            std::copy(chunk.v.begin(), chunk.v.end(), result.vertices.begin() + 3 * chunk.base_v);
+            std::copy(chunk.vn.begin(), chunk.vn.end(), result.normals.begin() + 3 * chunk.base_vn);
+            std::copy(chunk.vt.begin(), chunk.vt.end(), result.texcoords.begin() + 2 * chunk.base_vt);
+        }
+    });
+
+    // 3. Índices finais e triângulos, precisa de todas as posições
+    jobs->parallelFor(chunks.size(), 1, [&chunks, &result](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+            TriangulateChunk(chunks[c], result);
+    });
+    for (size_t c = 0; c < chunks.size(); ++c)
+        if (!chunks[c].supported)
+            return false;
+
+    // 4. Shapes, na ordem do arquivo
+    std::string basedir = mtl_basedir ? mtl_basedir : "";
+    if (!basedir.empty() && basedir[basedir.size() - 1] != '/')
+        basedir += '/';
+    shapes->clear();
+    ShapeBuilder builder(shapes, materials, basedir, warn);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const Chunk& chunk = chunks[c];
+        size_t triangle = 0;
+        for (size_t i = 0; i < chunk.commands.size(); ++i) {
+            builder.addTriangles(chunk, triangle, chunk.commands[i].triangle);
+            triangle = chunk.commands[i].triangle;
+            builder.apply(chunk.commands[i]);
+        }
+        builder.addTriangles(chunk, triangle, chunk.triangles.size() / 3);
+    }
+    builder.finish();
+
+    // Cor padrão de todos os vértices, como o tinyobj preenche
+    result.colors.assign(3 * num_v, 1.0f);
+    *attrib = std::move(result);
+    return true;
+}
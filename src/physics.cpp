@@ -3,13 +3,20 @@
 #include <vector>
 #include "../include/physics.hpp"
 #include "../include/matrices.hpp"
-#include "../include/geometrics.hpp"
 
 glm::vec4 g = glm::vec4(0.0f, -9.81f, 0.0f, 0.0f); // Gravitational acceleration in m/s^2
 
 void RigidBody::update(float dt) {
     deltaTime = dt; // Update the time step
 
+    if (sleeping) {
+        // Dormindo: as forças do passo (gravidade, normal) são descartadas
+        force = {0.0f, 0.0f, 0.0f, 0.0f};
+        torque = {0.0f, 0.0f, 0.0f, 0.0f};
+        previous_position = position;
+        return;
+    }
+
     acceleration = (force / mass); // Update acceleration based on force and mass
     angular_acceleration = (torque / inertia); // Update angular acceleration based on torque and mass
     float tmp = angular_acceleration.x;
@@ -26,6 +33,7 @@ void RigidBody::update(float dt) {
 
  
 
+    previous_position = position;
     position += velocity * dt;
 
     // Update rotation based on angular velocity
@@ -36,11 +44,25 @@ void RigidBody::update(float dt) {
         
     rotation += angular_velocity * dt;
 
+    // Em repouso por SLEEP_TIME: para de vez em vez de decair para sempre
+    float linear_energy = 0.5f * glm::dot(velocity, velocity);
+    float angular_energy = 0.5f * glm::dot(angular_velocity, angular_velocity);
+    if (can_sleep && linear_energy < MIN_LIMIAR && angular_energy < MIN_LIMIAR) {
+        sleep_timer += dt;
+        if (sleep_timer >= SLEEP_TIME) {
+            sleeping = true;
+            velocity = glm::vec4(0.0f);
+            angular_velocity = glm::vec4(0.0f);
+            acceleration = glm::vec4(0.0f);
+            angular_acceleration = glm::vec4(0.0f);
+        }
+    }
+    else {
+        sleep_timer = 0.0f;
+    }
 }
 
-glm::vec4 RigidBody::ComputeRigidBodyCenter(const struct ObjModel* model) {
-    const std::vector<float>& vertices = model->attrib.vertices;
-
+glm::vec4 RigidBody::ComputeRigidBodyCenter(const std::vector<float>& vertices) {
     if (vertices.empty())
         return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // fallback
 
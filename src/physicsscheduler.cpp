@@ -0,0 +1,37 @@
+//Fixed-step scheduler for the physics loop
+#include "../include/physicsscheduler.hpp"
+#include <cmath>
+
+PhysicsScheduler::PhysicsScheduler(float rate, int substeps, double frame_time)
+    : tick_rate(rate), step_time(1.0f / rate), max_substeps(substeps > 0 ? substeps : 1), max_frame_time(frame_time) {}
+
+void PhysicsScheduler::setTickRate(float rate) {
+    // Mantém a fração de passo acumulada, não o tempo
+    double alpha = accumulator / step_time;
+    tick_rate = rate;
+    step_time = 1.0f / rate;
+    accumulator = alpha * step_time;
+}
+
+int PhysicsScheduler::advance(double frame_time) {
+    if (frame_time < 0.0)
+        frame_time = 0.0;
+    if (frame_time > max_frame_time) {
+        dropped_time += frame_time - max_frame_time;
+        frame_time = max_frame_time;
+    }
+    accumulator += frame_time;
+
+    int steps = static_cast<int>(accumulator / step_time);
+    if (steps > max_substeps) {
+        // Descarta os passos inteiros que sobraram, fica só a fração
+        double kept = std::fmod(accumulator, static_cast<double>(step_time));
+        dropped_time += accumulator - kept - max_substeps * static_cast<double>(step_time);
+        accumulator = kept;
+        return max_substeps;
+    }
+    accumulator -= steps * static_cast<double>(step_time);
+    if (accumulator < 0.0)
+        accumulator = 0.0; // Arredondamento
+    return steps;
+}
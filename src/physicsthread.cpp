@@ -0,0 +1,81 @@
+//Fixed-step physics on its own thread
+#include "../include/physicsthread.hpp"
+#include <chrono>
+
+// Atraso máximo recuperado de uma vez: depois de uma pausa longa (janela
+// arrastada, breakpoint) a simulação continua de onde estava em vez de
+// rodar centenas de passos seguidos.
+static const double PHYSICS_THREAD_MAX_LAG = 0.25;
+
+PhysicsThread::~PhysicsThread() {
+    stop();
+}
+
+void PhysicsThread::start(float step_dt, const StepFunction& step_function, const SnapshotFunction& snapshot_function) {
+    stop();
+    dt = step_dt;
+    step = step_function;
+    snapshot = snapshot_function;
+
+    // Estado inicial publicado antes do primeiro passo
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        snapshot(states[front]);
+        tick = 0;
+    }
+    running = true;
+    thread = std::thread(&PhysicsThread::loop, this);
+}
+
+void PhysicsThread::stop() {
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+void PhysicsThread::post(const std::function<void()>& command) {
+    std::lock_guard<std::mutex> lock(command_mutex);
+    commands.push_back(command);
+}
+
+unsigned long long PhysicsThread::read(std::vector<BodyState>& out) const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    out = states[front];
+    return tick;
+}
+
+void PhysicsThread::loop() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+    const Clock::duration max_lag = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(PHYSICS_THREAD_MAX_LAG));
+    Clock::time_point next = Clock::now();
+    std::vector<std::function<void()> > pending;
+
+    while (running.load()) {
+        {
+            std::lock_guard<std::mutex> lock(command_mutex);
+            pending.swap(commands);
+        }
+        for (size_t i = 0; i < pending.size(); ++i)
+            pending[i]();
+        pending.clear();
+
+        step(dt);
+
+        // O buffer de trás só é tocado por esta thread; a troca é o único
+        // momento em que o renderizador precisa esperar.
+        const int back = 1 - front;
+        snapshot(states[back]);
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            front = back;
+            ++tick;
+        }
+
+        next += period;
+        Clock::time_point now = Clock::now();
+        if (now - next > max_lag)
+            next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
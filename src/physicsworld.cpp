@@ -0,0 +1,184 @@
+//Structure-of-arrays rigid body world, integrated in batches
+#include "../include/physicsworld.hpp"
+#include "../include/jobsystem.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHYSICSWORLD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHYSICSWORLD_SSE 1
+#endif
+
+int PhysicsWorld::addBody(const glm::vec4& position, float m, float linear_d, float angular_d, float inertia_value) {
+    px.push_back(position.x); py.push_back(position.y); pz.push_back(position.z);
+    vx.push_back(0.0f); vy.push_back(0.0f); vz.push_back(0.0f);
+    fx.push_back(0.0f); fy.push_back(0.0f); fz.push_back(0.0f);
+    mass.push_back(m);
+    linear_damping.push_back(linear_d);
+    rx.push_back(0.0f); ry.push_back(0.0f); rz.push_back(0.0f);
+    wx.push_back(0.0f); wy.push_back(0.0f); wz.push_back(0.0f);
+    tx.push_back(0.0f); ty.push_back(0.0f); tz.push_back(0.0f);
+    inertia.push_back(inertia_value);
+    angular_damping.push_back(angular_d);
+    return static_cast<int>(mass.size() - 1);
+}
+
+void PhysicsWorld::reserve(size_t count) {
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz, &fx, &fy, &fz, &mass, &linear_damping,
+                                     &rx, &ry, &rz, &wx, &wy, &wz, &tx, &ty, &tz, &inertia, &angular_damping };
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+        arrays[i]->reserve(count);
+}
+
+void PhysicsWorld::clear() {
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz, &fx, &fy, &fz, &mass, &linear_damping,
+                                     &rx, &ry, &rz, &wx, &wy, &wz, &tx, &ty, &tz, &inertia, &angular_damping };
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+        arrays[i]->clear();
+}
+
+void PhysicsWorld::addAccelerationToAll(const glm::vec4& a) {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        // Mesma ordem de RigidBody: a força é g * m
+        fx[i] += a.x * mass[i];
+        fy[i] += a.y * mass[i];
+        fz[i] += a.z * mass[i];
+    }
+}
+
+void PhysicsWorld::step(float dt, JobSystem* jobs) {
+    if (jobs == NULL) {
+        stepRange(0, size(), dt);
+        return;
+    }
+    jobs->parallelFor(size(), PHYSICSWORLD_CHUNK_SIZE, [this, dt](size_t first, size_t last) {
+        stepRange(first, last, dt);
+    });
+}
+
+void PhysicsWorld::stepRange(size_t first, size_t last, float dt) {
+    size_t i = first;
+    if (simd_enabled)
+        i = stepRangeSimd(first, last, dt);
+
+    // Restante (ou tudo, sem SIMD): mesma sequência de RigidBody::update()
+    for (; i < last; ++i) {
+        float ax = fx[i] / mass[i];
+        float ay = fy[i] / mass[i];
+        float az = fz[i] / mass[i];
+        // Torque/inércia com os eixos trocados como em RigidBody::update()
+        float aax = tz[i] / inertia[i];
+        float aay = -(ty[i] / inertia[i]);
+        float aaz = -(tx[i] / inertia[i]);
+        fx[i] = fy[i] = fz[i] = 0.0f;
+        tx[i] = ty[i] = tz[i] = 0.0f;
+
+        float linear_keep = 1.0f - linear_damping[i] * dt;
+        vx[i] += ax * dt; vy[i] += ay * dt; vz[i] += az * dt;
+        vx[i] *= linear_keep; vy[i] *= linear_keep; vz[i] *= linear_keep;
+        px[i] += vx[i] * dt; py[i] += vy[i] * dt; pz[i] += vz[i] * dt;
+
+        float angular_keep = 1.0f - angular_damping[i] * dt;
+        wx[i] += aax * dt; wy[i] += aay * dt; wz[i] += aaz * dt;
+        wx[i] *= angular_keep; wy[i] *= angular_keep; wz[i] *= angular_keep;
+        rx[i] += wx[i] * dt; ry[i] += wy[i] * dt; rz[i] += wz[i] * dt;
+    }
+}
+
+#if defined(PHYSICSWORLD_AVX)
+
+const char* PhysicsWorld::SimdName() { return "AVX"; }
+
+size_t PhysicsWorld::stepRangeSimd(size_t first, size_t last, float dt) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t i = first;
+    for (; i + 8 <= last; i += 8) {
+        __m256 m = _mm256_loadu_ps(&mass[i]);
+        __m256 I = _mm256_loadu_ps(&inertia[i]);
+        __m256 ax = _mm256_div_ps(_mm256_loadu_ps(&fx[i]), m);
+        __m256 ay = _mm256_div_ps(_mm256_loadu_ps(&fy[i]), m);
+        __m256 az = _mm256_div_ps(_mm256_loadu_ps(&fz[i]), m);
+        __m256 aax = _mm256_div_ps(_mm256_loadu_ps(&tz[i]), I);
+        __m256 aay = _mm256_xor_ps(_mm256_div_ps(_mm256_loadu_ps(&ty[i]), I), sign);
+        __m256 aaz = _mm256_xor_ps(_mm256_div_ps(_mm256_loadu_ps(&tx[i]), I), sign);
+        _mm256_storeu_ps(&fx[i], zero); _mm256_storeu_ps(&fy[i], zero); _mm256_storeu_ps(&fz[i], zero);
+        _mm256_storeu_ps(&tx[i], zero); _mm256_storeu_ps(&ty[i], zero); _mm256_storeu_ps(&tz[i], zero);
+
+        __m256 keep = _mm256_sub_ps(one, _mm256_mul_ps(_mm256_loadu_ps(&linear_damping[i]), vdt));
+        __m256 v0 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vx[i]), _mm256_mul_ps(ax, vdt)), keep);
+        __m256 v1 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vy[i]), _mm256_mul_ps(ay, vdt)), keep);
+        __m256 v2 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vz[i]), _mm256_mul_ps(az, vdt)), keep);
+        _mm256_storeu_ps(&vx[i], v0); _mm256_storeu_ps(&vy[i], v1); _mm256_storeu_ps(&vz[i], v2);
+        _mm256_storeu_ps(&px[i], _mm256_add_ps(_mm256_loadu_ps(&px[i]), _mm256_mul_ps(v0, vdt)));
+        _mm256_storeu_ps(&py[i], _mm256_add_ps(_mm256_loadu_ps(&py[i]), _mm256_mul_ps(v1, vdt)));
+        _mm256_storeu_ps(&pz[i], _mm256_add_ps(_mm256_loadu_ps(&pz[i]), _mm256_mul_ps(v2, vdt)));
+
+        keep = _mm256_sub_ps(one, _mm256_mul_ps(_mm256_loadu_ps(&angular_damping[i]), vdt));
+        __m256 w0 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&wx[i]), _mm256_mul_ps(aax, vdt)), keep);
+        __m256 w1 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&wy[i]), _mm256_mul_ps(aay, vdt)), keep);
+        __m256 w2 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&wz[i]), _mm256_mul_ps(aaz, vdt)), keep);
+        _mm256_storeu_ps(&wx[i], w0); _mm256_storeu_ps(&wy[i], w1); _mm256_storeu_ps(&wz[i], w2);
+        _mm256_storeu_ps(&rx[i], _mm256_add_ps(_mm256_loadu_ps(&rx[i]), _mm256_mul_ps(w0, vdt)));
+        _mm256_storeu_ps(&ry[i], _mm256_add_ps(_mm256_loadu_ps(&ry[i]), _mm256_mul_ps(w1, vdt)));
+        _mm256_storeu_ps(&rz[i], _mm256_add_ps(_mm256_loadu_ps(&rz[i]), _mm256_mul_ps(w2, vdt)));
+    }
+    return i;
+}
+
+#elif defined(PHYSICSWORLD_SSE)
+
+const char* PhysicsWorld::SimdName() { return "SSE2"; }
+
+size_t PhysicsWorld::stepRangeSimd(size_t first, size_t last, float dt) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        __m128 m = _mm_loadu_ps(&mass[i]);
+        __m128 I = _mm_loadu_ps(&inertia[i]);
+        __m128 ax = _mm_div_ps(_mm_loadu_ps(&fx[i]), m);
+        __m128 ay = _mm_div_ps(_mm_loadu_ps(&fy[i]), m);
+        __m128 az = _mm_div_ps(_mm_loadu_ps(&fz[i]), m);
+        __m128 aax = _mm_div_ps(_mm_loadu_ps(&tz[i]), I);
+        __m128 aay = _mm_xor_ps(_mm_div_ps(_mm_loadu_ps(&ty[i]), I), sign);
+        __m128 aaz = _mm_xor_ps(_mm_div_ps(_mm_loadu_ps(&tx[i]), I), sign);
+        _mm_storeu_ps(&fx[i], zero); _mm_storeu_ps(&fy[i], zero); _mm_storeu_ps(&fz[i], zero);
+        _mm_storeu_ps(&tx[i], zero); _mm_storeu_ps(&ty[i], zero); _mm_storeu_ps(&tz[i], zero);
+
+        __m128 keep = _mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(&linear_damping[i]), vdt));
+        __m128 v0 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vx[i]), _mm_mul_ps(ax, vdt)), keep);
+        __m128 v1 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vy[i]), _mm_mul_ps(ay, vdt)), keep);
+        __m128 v2 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vz[i]), _mm_mul_ps(az, vdt)), keep);
+        _mm_storeu_ps(&vx[i], v0); _mm_storeu_ps(&vy[i], v1); _mm_storeu_ps(&vz[i], v2);
+        _mm_storeu_ps(&px[i], _mm_add_ps(_mm_loadu_ps(&px[i]), _mm_mul_ps(v0, vdt)));
+        _mm_storeu_ps(&py[i], _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(v1, vdt)));
+        _mm_storeu_ps(&pz[i], _mm_add_ps(_mm_loadu_ps(&pz[i]), _mm_mul_ps(v2, vdt)));
+
+        keep = _mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(&angular_damping[i]), vdt));
+        __m128 w0 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&wx[i]), _mm_mul_ps(aax, vdt)), keep);
+        __m128 w1 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&wy[i]), _mm_mul_ps(aay, vdt)), keep);
+        __m128 w2 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&wz[i]), _mm_mul_ps(aaz, vdt)), keep);
+        _mm_storeu_ps(&wx[i], w0); _mm_storeu_ps(&wy[i], w1); _mm_storeu_ps(&wz[i], w2);
+        _mm_storeu_ps(&rx[i], _mm_add_ps(_mm_loadu_ps(&rx[i]), _mm_mul_ps(w0, vdt)));
+        _mm_storeu_ps(&ry[i], _mm_add_ps(_mm_loadu_ps(&ry[i]), _mm_mul_ps(w1, vdt)));
+        _mm_storeu_ps(&rz[i], _mm_add_ps(_mm_loadu_ps(&rz[i]), _mm_mul_ps(w2, vdt)));
+    }
+    return i;
+}
+
+#else
+
+const char* PhysicsWorld::SimdName() { return "none"; }
+
+size_t PhysicsWorld::stepRangeSimd(size_t first, size_t, float) {
+    return first;
+}
+
+#endif
@@ -0,0 +1,122 @@
+//Sorted render queue that minimizes OpenGL state changes
+#include "../include/renderqueue.hpp"
+#include <algorithm>
+
+uint64_t RenderQueue::MakeKey(const DrawItem& item, uint32_t sequence) {
+    uint64_t pass = item.blended ? 1 : 0;
+    uint64_t program = item.program->id() & 0x7FF;
+    uint64_t texture = item.texture & 0xFFFF;
+    uint64_t vao = item.object->vao & 0xFFFF;
+    return (pass << 63) | (program << 52) | (texture << 36) | (vao << 20) | (sequence & 0xFFFFF);
+}
+
+bool RenderQueue::submit(const DrawItem& item) {
+    // A esfera é o teste mais barato; a caixa só confirma o que ela aceitou
+    if (culling && item.has_bounds
+        && (!Frustum_Intersects(frustum, item.sphere) || !Frustum_Intersects(frustum, item.bounds))) {
+        culled += 1;
+        return false;
+    }
+    items.push_back(item);
+    items.back().key = MakeKey(item, static_cast<uint32_t>(items.size() - 1));
+    return true;
+}
+
+void RenderQueue::flush() {
+    stats = RenderStats();
+    stats.culled = culled;
+    culled = 0;
+    std::sort(items.begin(), items.end(),
+              [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+
+    // State left by whoever drew before the queue is unknown, so the first
+    // item binds everything it needs.
+    ShaderProgram* bound_program = nullptr;
+    GLuint bound_program_id = 0;
+    GLuint bound_vao = 0;
+    GLuint bound_texture = 0, bound_sampler = 0;
+    bool texture_known = false;
+    ObjectUniformBuffer* bound_uniforms = nullptr;
+    bool blending = false;
+    unsigned int uploads_before = 0;
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const DrawItem& item = items[i];
+        const SceneObject& object = *item.object;
+
+        if (item.program != bound_program || item.program->id() != bound_program_id) {
+            if (bound_program != nullptr)
+                stats.uniform_uploads += bound_program->getUploadCount() - uploads_before;
+            item.program->use();
+            bound_program = item.program;
+            bound_program_id = item.program->id();
+            uploads_before = bound_program->getUploadCount();
+            stats.program_binds += 1;
+        }
+        ShaderProgram& program = *item.program;
+
+        if (item.blended != blending) {
+            if (item.blended) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            }
+            else {
+                glDisable(GL_BLEND);
+            }
+            blending = item.blended;
+            stats.blend_changes += 1;
+        }
+
+        program.set(use_texture_uniform.get(program), item.texture != 0);
+        if (item.texture != 0 && (!texture_known || item.texture != bound_texture || item.sampler != bound_sampler)) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, item.texture);
+            glBindSampler(0, item.sampler);
+            program.set(texture_diffuse_uniform.get(program), 0);
+            bound_texture = item.texture;
+            bound_sampler = item.sampler;
+            texture_known = true;
+            stats.texture_binds += 1;
+        }
+
+        if (item.object_uniforms != nullptr && item.object_uniforms != bound_uniforms) {
+            item.object_uniforms->bind();
+            bound_uniforms = item.object_uniforms;
+            stats.buffer_binds += 1;
+        }
+
+        if (object.vao != bound_vao) {
+            glBindVertexArray(object.vao);
+            bound_vao = object.vao;
+            stats.vao_binds += 1;
+        }
+
+        program.set(render_as_black_uniform.get(program), !object.has_color);
+        program.set(use_instancing_uniform.get(program), item.instanced);
+        size_t first_index;
+        int num_indices;
+        SceneObject_LodRange(object, item.lod, &first_index, &num_indices);
+        unsigned int triangles = object.rendering_mode == GL_TRIANGLES ? num_indices / 3 : 0;
+        if (item.instanced) {
+            if (object.instance_count == 0)
+                continue;
+            glDrawElementsInstanced(object.rendering_mode, num_indices, GL_UNSIGNED_INT,
+                                    (void*)(first_index * sizeof(GLuint)), object.instance_count);
+            triangles *= object.instance_count;
+        }
+        else {
+            glDrawElements(object.rendering_mode, num_indices, GL_UNSIGNED_INT,
+                           (void*)(first_index * sizeof(GLuint)));
+        }
+        stats.draw_calls += 1;
+        stats.triangles += triangles;
+    }
+
+    if (bound_program != nullptr)
+        stats.uniform_uploads += bound_program->getUploadCount() - uploads_before;
+    if (blending)
+        glDisable(GL_BLEND);
+    if (bound_vao != 0)
+        glBindVertexArray(0);
+    items.clear();
+}
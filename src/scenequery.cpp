@@ -0,0 +1,417 @@
+//Ray and segment casts against the static scene
+#include "../include/scenequery.hpp"
+#include "../include/jobsystem.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Objetos por folha da BVH da cena
+static const int SCENEQUERY_LEAF_SIZE = 2;
+// Profundidade máxima da BVH da cena: a divisão pela mediana a mantém em
+// log2 do número de objetos
+static const int SCENEQUERY_MAX_DEPTH = 32;
+// Raios de cada job de castRays()
+static const size_t SCENEQUERY_RAYS_PER_JOB = 64;
+
+// Normal unitária contra o sentido do raio
+static glm::vec4 FaceRay(const glm::vec3& normal, const glm::vec4& direction) {
+    glm::vec3 n = glm::normalize(normal);
+    if (glm::dot(n, glm::vec3(direction)) > 0.0f)
+        n = -n;
+    return glm::vec4(n, 0.0f);
+}
+
+static void SetHit(SceneHit* hit, const SceneRay& ray, float t, const glm::vec3& normal) {
+    hit->t = t;
+    hit->point = ray.origin + t * ray.direction;
+    hit->point.w = 1.0f;
+    hit->normal = FaceRay(normal, ray.direction);
+    hit->triangle = -1;
+}
+
+bool Raycast_Plane(const SceneRay& ray, const CollisionPlane& plane, SceneHit* hit) {
+    float denom = glm::dot(ray.direction, plane.normal);
+    if (std::fabs(denom) < 1e-12f)
+        return false; // Paralelo ao plano
+    float t = glm::dot(plane.point - ray.origin, plane.normal) / denom;
+    if (t < 0.0f || t > ray.max_t)
+        return false;
+    SetHit(hit, ray, t, glm::vec3(plane.normal));
+    return true;
+}
+
+bool Raycast_Box(const SceneRay& ray, const CollisionBox& box, SceneHit* hit) {
+    // No espaço local o parâmetro t é o mesmo: a transformação é afim
+    glm::mat4 inverse = glm::inverse(box.transform);
+    glm::vec4 origin = inverse * ray.origin;
+    glm::vec4 direction = inverse * glm::vec4(glm::vec3(ray.direction), 0.0f);
+
+    float t_near = -std::numeric_limits<float>::max();
+    float t_far = std::numeric_limits<float>::max();
+    int axis_near = -1;
+    int axis_far = -1;
+    for (int k = 0; k < 3; ++k) {
+        float half = std::fabs(box.half_size[k]);
+        if (std::fabs(direction[k]) < 1e-12f) {
+            if (origin[k] < -half || origin[k] > half)
+                return false; // Paralelo ao par de faces e fora dele
+            continue;
+        }
+        float t0 = (-half - origin[k]) / direction[k];
+        float t1 = (half - origin[k]) / direction[k];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        if (t0 > t_near) {
+            t_near = t0;
+            axis_near = k;
+        }
+        if (t1 < t_far) {
+            t_far = t1;
+            axis_far = k;
+        }
+        if (t_near > t_far)
+            return false;
+    }
+    // Entrada, ou a saída quando o raio começa dentro da caixa
+    float t = t_near;
+    int axis = axis_near;
+    if (t < 0.0f) {
+        t = t_far;
+        axis = axis_far;
+    }
+    if (axis < 0 || t < 0.0f || t > ray.max_t)
+        return false;
+    glm::vec3 local_normal(0.0f);
+    local_normal[axis] = 1.0f;
+    // Normais se transformam pela inversa transposta (a caixa pode escalar)
+    SetHit(hit, ray, t, glm::vec3(glm::transpose(inverse) * glm::vec4(local_normal, 0.0f)));
+    return true;
+}
+
+bool Raycast_Cylinder(const SceneRay& ray, const CollisionCylinder& cylinder, SceneHit* hit) {
+    // Menor t entre a lateral e as duas tampas
+    glm::vec3 o = glm::vec3(ray.origin - cylinder.center);
+    glm::vec3 d = glm::vec3(ray.direction);
+    const float half = 0.5f * cylinder.height;
+    const float r2 = cylinder.radius * cylinder.radius;
+    float best = ray.max_t;
+    bool found = false;
+    glm::vec3 normal(0.0f);
+
+    float a = d.x * d.x + d.z * d.z;
+    if (a > 0.0f) {
+        float b = o.x * d.x + o.z * d.z;
+        float c = o.x * o.x + o.z * o.z - r2;
+        float discriminant = b * b - a * c;
+        if (discriminant >= 0.0f) {
+            float root = std::sqrt(discriminant);
+            float roots[2] = { (-b - root) / a, (-b + root) / a };
+            for (int i = 0; i < 2; ++i) {
+                float t = roots[i];
+                float y = o.y + t * d.y;
+                if (t >= 0.0f && t <= best && y >= -half && y <= half) {
+                    best = t;
+                    found = true;
+                    normal = glm::vec3(o.x + t * d.x, 0.0f, o.z + t * d.z);
+                }
+            }
+        }
+    }
+    if (d.y != 0.0f) {
+        for (int side = -1; side <= 1; side += 2) {
+            float t = (side * half - o.y) / d.y;
+            float x = o.x + t * d.x;
+            float z = o.z + t * d.z;
+            if (t >= 0.0f && t <= best && x * x + z * z <= r2) {
+                best = t;
+                found = true;
+                normal = glm::vec3(0.0f, static_cast<float>(side), 0.0f);
+            }
+        }
+    }
+    if (!found)
+        return false;
+    SetHit(hit, ray, best, normal);
+    return true;
+}
+
+bool Raycast_Sphere(const SceneRay& ray, const CollisionSphere& sphere, SceneHit* hit) {
+    glm::vec3 oc = glm::vec3(ray.origin - sphere.center);
+    glm::vec3 d = glm::vec3(ray.direction);
+    float a = glm::dot(d, d);
+    if (a <= 0.0f)
+        return false;
+    float b = glm::dot(oc, d);
+    float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f)
+        return false;
+    float root = std::sqrt(discriminant);
+    float t = (-b - root) / a;
+    if (t < 0.0f)
+        t = (-b + root) / a; // Começa dentro: sai pelo outro lado
+    if (t < 0.0f || t > ray.max_t)
+        return false;
+    SetHit(hit, ray, t, oc + t * d);
+    return true;
+}
+
+bool Raycast_Mesh(const SceneRay& ray, const CollisionMesh& mesh, SceneHit* hit) {
+    glm::mat4 inverse = glm::inverse(mesh.transform);
+    glm::vec3 origin(inverse * ray.origin);
+    glm::vec3 direction(inverse * glm::vec4(glm::vec3(ray.direction), 0.0f));
+    MeshHit mesh_hit;
+    if (!mesh.bvh->intersectRay(origin, direction, ray.max_t, &mesh_hit))
+        return false;
+    SetHit(hit, ray, mesh_hit.t, glm::vec3(glm::transpose(inverse) * glm::vec4(mesh_hit.normal, 0.0f)));
+    hit->triangle = mesh_hit.triangle;
+    return true;
+}
+
+int SceneQuery::addPlane(const CollisionPlane& plane) {
+    Object object;
+    object.shape = ColliderPlane;
+    object.plane = plane;
+    return add(object);
+}
+
+int SceneQuery::addBox(const CollisionBox& box) {
+    Object object;
+    object.shape = ColliderBox;
+    object.box = box;
+    glm::vec3 half = glm::abs(box.half_size);
+    AABB local = { -half, half };
+    object.bounds = AABB_Transform(local, box.transform);
+    return add(object);
+}
+
+int SceneQuery::addCylinder(const CollisionCylinder& cylinder) {
+    Object object;
+    object.shape = ColliderCylinder;
+    object.cylinder = cylinder;
+    glm::vec3 extent(cylinder.radius, 0.5f * cylinder.height, cylinder.radius);
+    AABB box = { glm::vec3(cylinder.center) - extent, glm::vec3(cylinder.center) + extent };
+    object.bounds = box;
+    return add(object);
+}
+
+int SceneQuery::addSphere(const CollisionSphere& sphere) {
+    Object object;
+    object.shape = ColliderSphere;
+    object.sphere = sphere;
+    AABB box = { glm::vec3(sphere.center) - glm::vec3(sphere.radius), glm::vec3(sphere.center) + glm::vec3(sphere.radius) };
+    object.bounds = box;
+    return add(object);
+}
+
+int SceneQuery::addMesh(const CollisionMesh& mesh) {
+    Object object;
+    object.shape = ColliderMesh;
+    object.mesh = mesh;
+    object.bounds = AABB_Transform(mesh.bvh->getBounds(), mesh.transform);
+    return add(object);
+}
+
+int SceneQuery::add(const Object& object) {
+    objects.push_back(object);
+    int id = static_cast<int>(objects.size() - 1);
+    if (object.shape == ColliderPlane)
+        unbounded.push_back(id);
+    else
+        build(); // Poucos objetos e estáticos: refazer a árvore é barato
+    return id;
+}
+
+void SceneQuery::build() {
+    bounded.clear();
+    nodes.clear();
+    for (size_t id = 0; id < objects.size(); ++id)
+        if (objects[id].shape != ColliderPlane && !AABB_IsEmpty(objects[id].bounds))
+            bounded.push_back(static_cast<int>(id));
+    if (bounded.empty())
+        return;
+
+    // Mesma organização da MeshBVH: filho da esquerda logo depois do pai
+    struct Task {
+        int parent;
+        int first;
+        int count;
+        int depth;
+    };
+    std::vector<Task> stack;
+    Task root = { -1, 0, static_cast<int>(bounded.size()), 0 };
+    stack.push_back(root);
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+        const int index = static_cast<int>(nodes.size());
+        if (task.parent >= 0)
+            nodes[task.parent].first = index;
+
+        Node node;
+        node.bounds = AABB_Empty();
+        AABB centroid_bounds = AABB_Empty();
+        for (int i = task.first; i < task.first + task.count; ++i) {
+            const AABB& box = objects[bounded[i]].bounds;
+            AABB_Extend(node.bounds, box);
+            AABB_Extend(centroid_bounds, 0.5f * (box.min + box.max));
+        }
+        if (task.count <= SCENEQUERY_LEAF_SIZE || task.depth >= SCENEQUERY_MAX_DEPTH) {
+            node.first = task.first;
+            node.count = task.count;
+            nodes.push_back(node);
+            continue;
+        }
+
+        // Mediana dos centros no eixo mais longo
+        glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+        int axis = 0;
+        if (extent.y > extent[axis])
+            axis = 1;
+        if (extent.z > extent[axis])
+            axis = 2;
+        const int middle = task.first + task.count / 2;
+        std::nth_element(bounded.begin() + task.first, bounded.begin() + middle, bounded.begin() + task.first + task.count,
+            [this, axis](int a, int b) {
+                return objects[a].bounds.min[axis] + objects[a].bounds.max[axis] < objects[b].bounds.min[axis] + objects[b].bounds.max[axis];
+            });
+        node.first = -1;
+        node.count = 0;
+        nodes.push_back(node);
+        Task right_task = { index, middle, task.first + task.count - middle, task.depth + 1 };
+        Task left_task = { -1, task.first, middle - task.first, task.depth + 1 };
+        stack.push_back(right_task);
+        stack.push_back(left_task);
+    }
+}
+
+bool SceneQuery::castObject(int id, const SceneRay& ray, SceneHit* hit) const {
+    const Object& object = objects[id];
+    switch (object.shape) {
+    case ColliderPlane:
+        return Raycast_Plane(ray, object.plane, hit);
+    case ColliderBox:
+        return Raycast_Box(ray, object.box, hit);
+    case ColliderCylinder:
+        return Raycast_Cylinder(ray, object.cylinder, hit);
+    case ColliderSphere:
+        return Raycast_Sphere(ray, object.sphere, hit);
+    case ColliderMesh:
+        return Raycast_Mesh(ray, object.mesh, hit);
+    }
+    return false;
+}
+
+bool SceneQuery::cast(const SceneRay& ray, SceneHit* hit, bool any) const {
+    if (glm::vec3(ray.direction) == glm::vec3(0.0f) || ray.max_t < 0.0f)
+        return false;
+    // Cada acerto encurta o raio: os testes seguintes só aceitam algo antes dele
+    SceneRay current = ray;
+    bool found = false;
+    SceneHit candidate;
+    for (size_t i = 0; i < unbounded.size(); ++i) {
+        if (!castObject(unbounded[i], current, &candidate))
+            continue;
+        *hit = candidate;
+        hit->object = unbounded[i];
+        current.max_t = candidate.t;
+        found = true;
+        if (any)
+            return true;
+    }
+    if (nodes.empty())
+        return found;
+
+    const glm::vec3 origin(ray.origin);
+    const glm::vec3 inverse_direction = 1.0f / glm::vec3(ray.direction);
+    int stack[SCENEQUERY_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const int index = stack[--top];
+        const Node& node = nodes[index];
+        float t_enter;
+        if (!AABB_IntersectRay(node.bounds, origin, inverse_direction, current.max_t, &t_enter))
+            continue;
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if (!castObject(bounded[i], current, &candidate))
+                    continue;
+                *hit = candidate;
+                hit->object = bounded[i];
+                current.max_t = candidate.t;
+                found = true;
+                if (any)
+                    return true;
+            }
+            continue;
+        }
+        // O filho em que o raio entra primeiro sai primeiro da pilha
+        int near_child = index + 1;
+        int far_child = node.first;
+        float near_t, far_t;
+        bool near_hit = AABB_IntersectRay(nodes[near_child].bounds, origin, inverse_direction, current.max_t, &near_t);
+        bool far_hit = AABB_IntersectRay(nodes[far_child].bounds, origin, inverse_direction, current.max_t, &far_t);
+        if (near_hit && far_hit && far_t < near_t) {
+            std::swap(near_child, far_child);
+        }
+        else if (!near_hit) {
+            near_child = far_child;
+            near_hit = far_hit;
+            far_hit = false;
+        }
+        if (far_hit)
+            stack[top++] = far_child;
+        if (near_hit)
+            stack[top++] = near_child;
+    }
+    return found;
+}
+
+bool SceneQuery::raycast(const SceneRay& ray, SceneHit* hit) const {
+    return cast(ray, hit, false);
+}
+
+bool SceneQuery::segmentCast(const glm::vec4& from, const glm::vec4& to, SceneHit* hit) const {
+    SceneRay ray = { from, glm::vec4(glm::vec3(to - from), 0.0f), 1.0f };
+    ray.origin.w = 1.0f;
+    return cast(ray, hit, false);
+}
+
+bool SceneQuery::anyHit(const SceneRay& ray) const {
+    SceneHit hit;
+    return cast(ray, &hit, true);
+}
+
+void SceneQuery::castRays(const SceneRay* rays, size_t count, SceneHit* hits, JobSystem* jobs) const {
+    auto cast_range = [this, rays, hits](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            if (!cast(rays[i], &hits[i], false))
+                hits[i].object = -1;
+    };
+    if (jobs != NULL)
+        jobs->parallelFor(count, SCENEQUERY_RAYS_PER_JOB, cast_range);
+    else
+        cast_range(0, count);
+}
+
+bool SceneQuery::castParabola(const glm::vec4& p0, const glm::vec4& v0, const glm::vec4& a, float max_time, int segments,
+                              SceneHit* hit, float* time) const {
+    if (segments < 1)
+        segments = 1;
+    glm::vec4 from = p0;
+    for (int i = 1; i <= segments; ++i) {
+        float t1 = max_time * i / segments;
+        glm::vec4 to = p0 + v0 * t1 + 0.5f * a * (t1 * t1);
+        to.w = 1.0f;
+        if (segmentCast(from, to, hit)) {
+            float t0 = max_time * (i - 1) / segments;
+            *time = t0 + hit->t * (t1 - t0);
+            return true;
+        }
+        from = to;
+    }
+    return false;
+}
@@ -9,20 +9,39 @@ in vec4 position_world;
 in vec4 normal;
 
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-
-// Identificador que define qual objeto está sendo desenhado no momento
-#define BALL   0
-#define CLUB  1
-#define WALL  2
-#define FLOOR 3
-#define VEGETATION 4
-#define CLOUDS 5
-uniform int object_id;
+// Dados por quadro e por objeto, em uniform buffers (std140). Devem ser
+// idênticos em ambos os shaders e às structs FrameUniforms/ObjectUniforms em
+// "uniformbuffers.hpp".
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 light_direction;
+};
+layout (std140) uniform ObjectData
+{
+    mat4 model;
+    mat4 normal_matrix; // inverse(transpose(model)), calculada na CPU
+    ivec4 material;     // x = índice em MaterialData (-1 = cor do vértice)
+};
+
+
+// Tabela de materiais da cena, indexada por ObjectData.material.x. Veja
+// MaterialTable em "materials.hpp"; MAX_MATERIALS deve ser o mesmo.
+#define MAX_MATERIALS 64
+struct Material
+{
+    vec4 diffuse;  // rgb = Kd, w = multiplicador da cor da textura
+    vec4 specular; // rgb = Ks, w = expoente especular q
+    vec4 ambient;  // rgb = Ka
+};
+layout (std140) uniform MaterialData
+{
+    Material materials[MAX_MATERIALS];
+};
+
 in vec2 TexCoords;              // <--- já vem do vertex shader
 uniform sampler2D texture_diffuse; // <--- nova uniform
 uniform bool use_texture; // nova flag para ativar ou não textura
@@ -33,10 +52,8 @@ out vec4 color;
 
 void main()
 {
-    // Obtemos a posição da câmera utilizando a inversa da matriz que define o
-    // sistema de coordenadas da câmera.
-    vec4 origin = vec4(0.0, 0.0, 0.0, 1.0);
-    vec4 camera_position = inverse(view) * origin;
+    // A posição da câmera vem pronta em FrameData (antes era calculada aqui,
+    // por fragmento, com inverse(view)).
 
     // O fragmento atual é coberto por um ponto que percente à superfície de um
     // dos objetos virtuais da cena. Este ponto, p, possui uma posição no
@@ -50,7 +67,7 @@ void main()
     vec4 n = normalize(normal);
 
     // Vetor que define o sentido da fonte de luz em relação ao ponto atual.
-    vec4 l = normalize(vec4(0.8,1.0,0.5,0.0));
+    vec4 l = light_direction;
 
     // Vetor que define o sentido da câmera em relação ao ponto atual.
     vec4 v = normalize(camera_position - p);
@@ -64,82 +81,25 @@ void main()
     vec3 Ka; // Refletância ambiente
     float q; // Expoente especular para o modelo de iluminação de Phong
 
-    if ( object_id == BALL )
-    {
-        vec3 Kd_base = vec3(0.9, 0.9, 0.9);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base*2;
-        else
-            Kd = Kd_base;
-
-        Ks = vec3(0.9,0.9,0.9);
-        Ka = vec3(0.4,0.4,0.4);
-        q = 100.0;
-    }
-    else if ( object_id == CLUB )
-    {
-        vec3 Kd_base = vec3(0.08, 0.4, 0.8);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base;
-        else
-            Kd = Kd_base;
-        Ks = vec3(0.8,0.8,0.8);
-        Ka = vec3(0.4,0.2,0.4);
-        q = 32.0;
-    }
-    else if ( object_id == FLOOR )
-    {
-        vec3 Kd_base = vec3(0.001,0.9,0.2);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base;
-        else
-            Kd = Kd_base;
-        Ks = vec3(0.3,0.3,0.3);
-        Ka = vec3(0.2,0.5,0.3);
-        q = 100.0;
-    }
-    else if ( object_id == WALL )
-    {
-        vec3 Kd_base = vec3(0.0,0.0,0.8);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base;
-        else
-            Kd = Kd_base;
-        Ks = vec3(0.2,0.2,0.2);
-        Ka = vec3(0.8,0.8,0.8);
-        q = 1.0;
-    }
-    else if ( object_id == VEGETATION )
-    {
-        vec3 Kd_base = vec3(0.1, 0.6, 0.1);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base;
-        else
-            Kd = Kd_base;
-        Ks = vec3(0.2, 0.2, 0.2);
-        Ka = vec3(0.004, 0.004, 0.004);
-        q = 10.0;
-    }
-    else if ( object_id == CLOUDS)
-    {
-        vec3 Kd_base = vec3(1.0, 1.0, 1.0);
-        if (use_texture)
-            Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base;
-        else
-            Kd = Kd_base;
-        Ks = vec3(0.5, 0.5, 0.5);
-        Ka = vec3(0.8, 0.8, 0.8);
-        q = 1000.0;
-    }
-    
-    
-    
-    else // Objeto desconhecido = preto
+    int material_index = material.x;
+    if ( material_index < 0 || material_index >= MAX_MATERIALS ) // Sem material = cor do vértice
     {
        color = cor_interpolada_pelo_rasterizador; // Cor do objeto
        return;
     }
 
+    // O mesmo índice vale para todo o draw call, então não há divergência
+    // entre fragmentos como na antiga cadeia de "if (object_id == ...)".
+    Material m = materials[material_index];
+    vec3 Kd_base = m.diffuse.rgb;
+    if (use_texture)
+        Kd = texture(texture_diffuse, TexCoords).rgb * Kd_base * m.diffuse.w;
+    else
+        Kd = Kd_base;
+    Ks = m.specular.rgb;
+    Ka = m.ambient.rgb;
+    q = m.specular.w;
+
     // Espectro da fonte de iluminação
     vec3 I = vec3(1.0,1.0,1.0);
 
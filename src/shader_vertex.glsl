@@ -1,18 +1,41 @@
 #version 330 core
 
 // Atributos de vértice recebidos como entrada ("in") pelo Vertex Shader.
-// Veja a função BuildTrianglesAndAddToVirtualScene() em "main.cpp".
-layout (location = 0) in vec4 model_coefficients;
-layout (location = 1) in vec4 normal_coefficients;
+// Veja a função BuildTrianglesAndAddToVirtualScene() em "geometrics.cpp".
+// Posição e normal chegam como vec3: no layout compacto (CompactVertex) a
+// posição é vec3 float e a normal é GL_INT_2_10_10_10_REV; no layout separado
+// (vec4 float) o componente w é simplesmente descartado.
+layout (location = 0) in vec3 model_coefficients;
+layout (location = 1) in vec3 normal_coefficients;
 layout (location = 2) in vec2 texture_coefficients;
 layout (location = 3) in vec4 color_coefficients;
 
+// Matrizes "model" e normal de cada instância, usadas quando o objeto é
+// desenhado com glDrawElementsInstanced(). Veja VirtualScene::setInstances()
+// em "glcontext.cpp".
+layout (location = 4) in mat4 instance_model;
+layout (location = 8) in mat3 instance_normal_matrix;
+uniform bool use_instancing;
 
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Dados por quadro e por objeto, em uniform buffers (std140). Devem ser
+// idênticos em ambos os shaders e às structs FrameUniforms/ObjectUniforms em
+// "uniformbuffers.hpp".
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 light_direction;
+};
+layout (std140) uniform ObjectData
+{
+    mat4 model;
+    mat4 normal_matrix; // inverse(transpose(model)), calculada na CPU
+    ivec4 material;     // x = índice em MaterialData (-1 = cor do vértice)
+};
 
 out vec4 cor_interpolada_pelo_rasterizador;
 out vec2 TexCoords;
@@ -40,8 +63,11 @@ void main()
     // deste Vertex Shader, a placa de vídeo (GPU) fará a divisão por W. Veja
     // slides 41-67 e 69-86 do documento Aula_09_Projecoes.pdf.
     
+    vec4 position_model = vec4(model_coefficients, 1.0);
+    mat4 model_matrix = use_instancing ? instance_model : model;
+
     TexCoords = texture_coefficients;
-    gl_Position = projection * view * model * model_coefficients;
+    gl_Position = view_projection * model_matrix * position_model;
 
     // Como as variáveis acima  (tipo vec4) são vetores com 4 coeficientes,
     // também é possível acessar e modificar cada coeficiente de maneira
@@ -58,11 +84,15 @@ void main()
     // rasterizador para gerar atributos únicos para cada fragmento gerado.
 
     // Posição do vértice atual no sistema de coordenadas global (World).
-    position_world = model * model_coefficients;
+    position_world = model_matrix * position_model;
 
     // Normal do vértice atual no sistema de coordenadas global (World).
     // Veja slides 123-151 do documento Aula_07_Transformacoes_Geometricas_3D.pdf.
-    normal = inverse(transpose(model)) * normal_coefficients;
+    // A matriz normal já vem calculada (ObjectData ou atributo de instância).
+    if ( use_instancing )
+        normal = vec4(instance_normal_matrix * normal_coefficients, 0.0);
+    else
+        normal = normal_matrix * vec4(normal_coefficients, 0.0);
     normal.w = 0.0;
     
     if ( render_as_black )
@@ -0,0 +1,98 @@
+#include "../include/shaderprogram.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include <algorithm>
+#include <cstring>
+
+void ShaderProgram::reflect(GLuint id) {
+    program_id = id;
+    generation += 1;
+    uniforms.clear();
+
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> name(max_length > 0 ? max_length : 1);
+
+    for (GLint i = 0; i < count; ++i) {
+        Uniform u;
+        GLsizei length = 0;
+        glGetActiveUniform(program_id, (GLuint)i, (GLsizei)name.size(), &length, &u.size, &u.type, name.data());
+        u.name.assign(name.data(), length);
+        u.location = glGetUniformLocation(program_id, u.name.c_str());
+        if (u.location < 0)
+            continue; // Member of a uniform block: not set through glUniform*
+
+        size_t bracket = u.name.find('[');
+        if (bracket != std::string::npos)
+            u.name.erase(bracket);
+        u.cached = false;
+        uniforms.push_back(u);
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(),
+              [](const Uniform& a, const Uniform& b) { return a.name < b.name; });
+}
+
+int ShaderProgram::uniform(const char* name) const {
+    std::string key(name);
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), key,
+                               [](const Uniform& u, const std::string& k) { return u.name < k; });
+    if (it == uniforms.end() || it->name != key)
+        return -1;
+    return (int)(it - uniforms.begin());
+}
+
+bool ShaderProgram::changed(int handle, const void* bytes, size_t length) {
+    Uniform& u = uniforms[handle];
+    if (u.cached && memcmp(u.value, bytes, length) == 0)
+        return false;
+    memcpy(u.value, bytes, length);
+    u.cached = true;
+    return true;
+}
+
+void ShaderProgram::set(int handle, bool value) {
+    set(handle, (GLint)(value ? 1 : 0));
+}
+
+void ShaderProgram::set(int handle, GLint value) {
+    if (handle < 0 || !changed(handle, &value, sizeof(value)))
+        return;
+    upload_count += 1;
+    glUniform1i(uniforms[handle].location, value);
+}
+
+void ShaderProgram::set(int handle, GLfloat value) {
+    if (handle < 0 || !changed(handle, &value, sizeof(value)))
+        return;
+    upload_count += 1;
+    glUniform1f(uniforms[handle].location, value);
+}
+
+void ShaderProgram::set(int handle, const glm::vec4& value) {
+    if (handle < 0 || !changed(handle, glm::value_ptr(value), sizeof(value)))
+        return;
+    upload_count += 1;
+    glUniform4fv(uniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(int handle, const glm::mat4& value) {
+    if (handle < 0 || !changed(handle, glm::value_ptr(value), sizeof(value)))
+        return;
+    upload_count += 1;
+    glUniformMatrix4fv(uniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+bool ShaderProgram::bindUniformBlock(const char* block_name, GLuint binding) {
+    GLuint index = glGetUniformBlockIndex(program_id, block_name);
+    if (index == GL_INVALID_INDEX)
+        return false;
+    glUniformBlockBinding(program_id, index, binding);
+    return true;
+}
+
+void ShaderProgram::invalidate() {
+    for (size_t i = 0; i < uniforms.size(); ++i)
+        uniforms[i].cached = false;
+}
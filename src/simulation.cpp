@@ -0,0 +1,92 @@
+//Headless golf course simulation
+#include "../include/simulation.hpp"
+#include "../include/jobsystem.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Bolas integradas por job em integrate()
+static const size_t SIMULATION_BODIES_PER_JOB = 256;
+
+void GolfCourse_AddColliders(BroadPhase& broad_phase) {
+    CollisionPlane floor = { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f) };
+    broad_phase.addPlane(floor);
+
+    const float d = COURSE_WALL_DISTANCE;
+    CollisionPlane walls[4] = {
+        { glm::vec4(0.0f, COURSE_WALL_Y, -d, 1.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) },  // north
+        { glm::vec4(0.0f, COURSE_WALL_Y, d, 1.0f), glm::vec4(0.0f, 0.0f, -1.0f, 0.0f) },  // south
+        { glm::vec4(d, COURSE_WALL_Y, 0.0f, 1.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f) },  // east
+        { glm::vec4(-d, COURSE_WALL_Y, 0.0f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f) }   // west
+    };
+    for (int i = 0; i < 4; ++i)
+        broad_phase.addPlane(walls[i]);
+
+    CollisionBox void_zone;
+    void_zone.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, COURSE_VOID_ZONE_Y, 0.0f));
+    void_zone.half_size = COURSE_VOID_ZONE_HALF_SIZE;
+    broad_phase.addBox(void_zone, BALL_RESPAWN_POSITION);
+    broad_phase.addCylinder(GolfCourse_GetHole());
+}
+
+CollisionCylinder GolfCourse_GetHole() {
+    CollisionCylinder hole;
+    hole.center = COURSE_HOLE_CENTER;
+    hole.radius = COURSE_HOLE_RADIUS;
+    hole.height = COURSE_HOLE_HEIGHT;
+    return hole;
+}
+
+GolfSimulation::GolfSimulation() : hole(GolfCourse_GetHole()) {
+    GolfCourse_AddColliders(broad_phase);
+}
+
+int GolfSimulation::addBall(const glm::vec4& position) {
+    bodies.push_back(RigidBody());
+    grounded.push_back(true);
+    RigidBody& body = bodies.back();
+    body.setPosition(position);
+    body.setMass(COURSE_BALL_MASS);
+    body.setSleepEnabled(sleep_enabled);
+    broad_phase.addBall(&body, COURSE_BALL_RADIUS, &grounded.back());
+    return static_cast<int>(bodies.size() - 1);
+}
+
+void GolfSimulation::shoot(int ball, const glm::vec4& velocity) {
+    bodies[ball].setVelocity(velocity);
+    bodies[ball].setAngularAcceleration(velocity);
+    grounded[ball] = false;
+}
+
+void GolfSimulation::setSleepEnabled(bool enabled) {
+    sleep_enabled = enabled;
+    for (size_t i = 0; i < bodies.size(); ++i)
+        bodies[i].setSleepEnabled(enabled);
+}
+
+void GolfSimulation::step(float dt, JobSystem* jobs) {
+    integrate(dt, jobs);
+    collide(jobs);
+}
+
+void GolfSimulation::integrate(float dt, JobSystem* jobs) {
+    auto integrate_range = [this, dt](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            RigidBody& body = bodies[i];
+            body.addForce(g * body.getMass());
+            body.update(dt);
+        }
+    };
+    if (jobs != NULL)
+        jobs->parallelFor(bodies.size(), SIMULATION_BODIES_PER_JOB, integrate_range);
+    else
+        integrate_range(0, bodies.size());
+}
+
+void GolfSimulation::collide(JobSystem* jobs) {
+    broad_phase.update();
+    broad_phase.dispatch(jobs);
+}
+
+bool GolfSimulation::isInHole(int ball) const {
+    CollisionSphere sphere = { bodies[ball].getPosition(), COURSE_BALL_RADIUS };
+    return sphere.center.y < 0.0f && Collision_SphereToCylinder(sphere, hole);
+}
@@ -0,0 +1,35 @@
+//Trajectory prediction with the physics step
+#include "../include/trajectory.hpp"
+
+// Abaixo desta velocidade (m/s) a bola prevista é considerada parada
+static const float TRAJECTORY_REST_SPEED = 0.01f;
+
+TrajectoryPredictor::TrajectoryPredictor(float radius) {
+    broad_phase.addBall(&body, radius);
+}
+
+size_t TrajectoryPredictor::predict(const RigidBody& start, float dt, int steps, std::vector<glm::vec4>& points) {
+    body = start;
+    points.clear();
+    points.push_back(body.getPosition());
+    bool was_slow = false;
+    for (int step = 0; step < steps; ++step) {
+        // O mesmo passo do loop de física de main() e de GolfSimulation
+        body.addForce(g * body.getMass());
+        body.update(dt);
+        broad_phase.update();
+        broad_phase.dispatch();
+
+        glm::vec4 velocity = body.getVelocity();
+        if (velocity == glm::vec4(0.0f))
+            break; // Zona de morte: Collision_RespondToBox zera a velocidade
+        points.push_back(body.getPosition());
+        // Dois passos seguidos: no alto de um quique (ou quicando no fundo
+        // do buraco) a velocidade passa perto de zero por um passo só
+        bool slow = glm::length(glm::vec3(velocity)) < TRAJECTORY_REST_SPEED;
+        if (slow && was_slow)
+            break;
+        was_slow = slow;
+    }
+    return points.size();
+}
@@ -0,0 +1,67 @@
+//Uniform buffer objects shared by the shaders
+#include "../include/uniformbuffers.hpp"
+#include "glm/mat3x3.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+#include <cstring>
+
+FrameUniformBuffer::~FrameUniformBuffer() {
+    if (ubo != 0)
+        glDeleteBuffers(1, &ubo);
+}
+
+void FrameUniformBuffer::setCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& camera_position) {
+    data.view = view;
+    data.projection = projection;
+    data.view_projection = projection * view;
+    data.camera_position = camera_position;
+}
+
+void FrameUniformBuffer::upload() {
+    if (ubo == 0) {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    }
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, ubo);
+}
+
+ObjectUniformBuffer::~ObjectUniformBuffer() {
+    if (ubo != 0)
+        glDeleteBuffers(1, &ubo);
+}
+
+void ObjectUniformBuffer::setModel(const glm::mat4& model) {
+    if (!dirty && memcmp(&model, &data.model, sizeof(model)) == 0)
+        return;
+    data.model = model;
+    // Only the upper 3x3 part matters for normals (w = 0); the translation
+    // column must not leak into them.
+    data.normal_matrix = glm::mat4(glm::inverseTranspose(glm::mat3(model)));
+    dirty = true;
+}
+
+void ObjectUniformBuffer::setMaterial(int material_index) {
+    if (data.material.x == material_index)
+        return;
+    data.material.x = material_index;
+    dirty = true;
+}
+
+void ObjectUniformBuffer::bind() {
+    if (ubo == 0) {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ObjectUniforms), &data, GL_DYNAMIC_DRAW);
+        dirty = false;
+    }
+    else if (dirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ObjectUniforms), &data);
+        dirty = false;
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, OBJECT_UNIFORM_BINDING, ubo);
+}